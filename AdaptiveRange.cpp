@@ -0,0 +1,216 @@
+/**
+ * @file AdaptiveRange.cpp
+ * @ingroup Drawing
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#include "AdaptiveRange.h"
+#include "DrawingSimd.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace MobileRGBD;
+
+namespace {
+
+const int GammaSteps = 4096;		// Resolution of the normalised gamma curve
+
+} // anonymous namespace
+
+/** @brief constructor.
+ *
+ * @param _InitialHigh [in] Upper clip point before the first frame (i.e. fixed normaliser of the view).
+ * @param _LowPercentile [in] Fraction of pixels under the lower clip point (Default = 0.01).
+ * @param _HighPercentile [in] Fraction of pixels under the upper clip point (Default = 0.99).
+ * @param _Smoothing [in] Weight of the current frame in smoothed clip points, 1.0 for no smoothing (Default = 0.1).
+ * @param _LineStep [in] Use one line every LineStep lines for the histogram (Default = 4).
+ */
+AdaptiveRange::AdaptiveRange( int _InitialHigh, float _LowPercentile /* = 0.01f */, float _HighPercentile /* = 0.99f */, float _Smoothing /* = 0.1f */, int _LineStep /* = 4 */ )
+{
+	LowPercentile = _LowPercentile;
+	HighPercentile = _HighPercentile;
+	Smoothing = _Smoothing <= 0.0f ? 0.01f : (_Smoothing > 1.0f ? 1.0f : _Smoothing);
+	LineStep = _LineStep < 1 ? 1 : _LineStep;
+
+	FirstFrame = true;
+	Version = 0;
+	SmoothedLow = 0.0f;
+	SmoothedHigh = (float)_InitialHigh;
+
+	Histogram.resize( NumberOfBins*4 );
+	Table.resize( 65536 );
+
+	// Gamma .32 of normalised values, computed once
+	Gamma.resize( GammaSteps+1 );
+	for( int Step = 0; Step <= GammaSteps; Step++ )
+	{
+		Gamma[Step] = (unsigned char)(pow( (float)Step/(float)GammaSteps, .32f )*255.0f);
+	}
+
+	BuildTable( 0, _InitialHigh );
+}
+
+/** @brief Compute the histogram of a frame in Histogram.
+ *
+ * @return the number of non zero values.
+ */
+int AdaptiveRange::ComputeHistogram( const unsigned short int * Frame, int Width, int Height )
+{
+	// 4 sub-histograms, so consecutive equal values do not wait for each other
+	memset( &Histogram[0], 0, Histogram.size()*sizeof(unsigned int) );
+	unsigned int * H0 = &Histogram[0];
+	unsigned int * H1 = H0 + NumberOfBins;
+	unsigned int * H2 = H1 + NumberOfBins;
+	unsigned int * H3 = H2 + NumberOfBins;
+
+	for( int line = 0; line < Height; line += LineStep )
+	{
+		const unsigned short int * Values = Frame + line*Width;
+		int col = 0;
+
+#ifdef DRAWING_SSE2
+		for( ; col+8 <= Width; col += 8 )
+		{
+			// Bins of 8 values at once
+			__m128i Bins = _mm_srli_epi16( _mm_loadu_si128( (const __m128i*)(Values+col) ), BinShift );
+			H0[_mm_extract_epi16( Bins, 0 )]++;
+			H1[_mm_extract_epi16( Bins, 1 )]++;
+			H2[_mm_extract_epi16( Bins, 2 )]++;
+			H3[_mm_extract_epi16( Bins, 3 )]++;
+			H0[_mm_extract_epi16( Bins, 4 )]++;
+			H1[_mm_extract_epi16( Bins, 5 )]++;
+			H2[_mm_extract_epi16( Bins, 6 )]++;
+			H3[_mm_extract_epi16( Bins, 7 )]++;
+		}
+#else
+		for( ; col+4 <= Width; col += 4 )
+		{
+			H0[Values[col] >> BinShift]++;
+			H1[Values[col+1] >> BinShift]++;
+			H2[Values[col+2] >> BinShift]++;
+			H3[Values[col+3] >> BinShift]++;
+		}
+#endif
+		for( ; col < Width; col++ )
+		{
+			H0[Values[col] >> BinShift]++;
+		}
+	}
+
+	// Merge sub-histograms, first bin (no data) ignored
+	int Total = 0;
+	H0[0] = 0;
+	for( int Bin = 1; Bin < NumberOfBins; Bin++ )
+	{
+		H0[Bin] += H1[Bin] + H2[Bin] + H3[Bin];
+		Total += (int)H0[Bin];
+	}
+
+	return Total;
+}
+
+/** @brief Build Table for a range.
+ */
+void AdaptiveRange::BuildTable( int Low, int High )
+{
+	if ( High <= Low )
+	{
+		High = Low+1;
+	}
+
+	TableLow = Low;
+	TableHigh = High;
+	Version++;
+
+	// Lookup in the normalised gamma curve, no pow per value
+	Table[0] = 0;
+	const float Scale = (float)GammaSteps/(float)(High-Low);
+	for( int Value = 1; Value < 65536; Value++ )
+	{
+		if ( Value <= Low )
+		{
+			Table[Value] = 0;
+		}
+		else if ( Value >= High )
+		{
+			Table[Value] = 255;
+		}
+		else
+		{
+			Table[Value] = Gamma[(int)((float)(Value-Low)*Scale)];
+		}
+	}
+}
+
+/** @brief Update the range with a new frame.
+ *
+ * @param Frame [in] 16 bits frame.
+ * @param Width [in] Width of the frame.
+ * @param Height [in] Height of the frame.
+ * @return true if the table was rebuilt.
+ */
+bool AdaptiveRange::Update( const unsigned short int * Frame, int Width, int Height )
+{
+	int Total = ComputeHistogram( Frame, Width, Height );
+	if ( Total == 0 )
+	{
+		// No data, keep the current range
+		return false;
+	}
+
+	// Clip points of this frame
+	const unsigned int * Counts = &Histogram[0];
+	int LowCount = (int)(LowPercentile*(float)Total);
+	int HighCount = (int)(HighPercentile*(float)Total);
+	int Low = -1;
+	int High = NumberOfBins-1;
+	int Cumulated = 0;
+	for( int Bin = 1; Bin < NumberOfBins; Bin++ )
+	{
+		Cumulated += (int)Counts[Bin];
+		if ( Low < 0 && Cumulated > LowCount )
+		{
+			Low = Bin;
+		}
+		if ( Cumulated >= HighCount )
+		{
+			High = Bin;
+			break;
+		}
+	}
+	if ( Low < 0 )
+	{
+		Low = High;
+	}
+
+	float FrameLow = (float)(Low << BinShift);
+	float FrameHigh = (float)((High+1) << BinShift);
+
+	// Smooth over time
+	if ( FirstFrame )
+	{
+		SmoothedLow = FrameLow;
+		SmoothedHigh = FrameHigh;
+		FirstFrame = false;
+	}
+	else
+	{
+		SmoothedLow += Smoothing*(FrameLow - SmoothedLow);
+		SmoothedHigh += Smoothing*(FrameHigh - SmoothedHigh);
+	}
+
+	// Rebuild only if the range moved by more than 1% of its width
+	int NewLow = (int)SmoothedLow;
+	int NewHigh = (int)SmoothedHigh;
+	int Tolerance = (TableHigh - TableLow)/100;
+	if ( abs( NewLow - TableLow ) <= Tolerance && abs( NewHigh - TableHigh ) <= Tolerance )
+	{
+		return false;
+	}
+
+	BuildTable( NewLow, NewHigh );
+	return true;
+}
@@ -0,0 +1,118 @@
+/**
+ * @file AdaptiveRange.h
+ * @ingroup Drawing
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __ADAPTIVE_RANGE_H__
+#define __ADAPTIVE_RANGE_H__
+
+#include <vector>
+
+namespace MobileRGBD {
+
+/**
+ * @class AdaptiveRange AdaptiveRange.cpp AdaptiveRange.h
+ * @brief Automatic display range of 16 bits frames (depth, infrared). For each frame, a histogram of one
+ *        line every few lines is computed (SSE2 when available), percentiles give the clip points, and
+ *        clip points are smoothed over time. The 16 bits to 8 bits table (gamma .32, as the fixed
+ *        mapping of Kinect2 views) is rebuilt only when the smoothed range moves, so drawing with it
+ *        costs the same as the fixed mapping. Zero values (no data) are ignored and stay black.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class AdaptiveRange
+{
+public:
+	enum { BinShift = 4, NumberOfBins = 65536 >> BinShift };	/*!< @brief Histogram bins of 16 values */
+
+	/** @brief constructor.
+	 *
+	 * @param _InitialHigh [in] Upper clip point before the first frame (i.e. fixed normaliser of the view).
+	 * @param _LowPercentile [in] Fraction of pixels under the lower clip point (Default = 0.01).
+	 * @param _HighPercentile [in] Fraction of pixels under the upper clip point (Default = 0.99).
+	 * @param _Smoothing [in] Weight of the current frame in smoothed clip points, 1.0 for no smoothing (Default = 0.1).
+	 * @param _LineStep [in] Use one line every LineStep lines for the histogram (Default = 4).
+	 */
+	AdaptiveRange( int _InitialHigh, float _LowPercentile = 0.01f, float _HighPercentile = 0.99f, float _Smoothing = 0.1f, int _LineStep = 4 );
+
+	/** @brief Virtual destructor, always.
+	 */
+	virtual ~AdaptiveRange() {}
+
+	/** @brief Update the range with a new frame.
+	 *
+	 * @param Frame [in] 16 bits frame.
+	 * @param Width [in] Width of the frame.
+	 * @param Height [in] Height of the frame.
+	 * @return true if the table was rebuilt.
+	 */
+	bool Update( const unsigned short int * Frame, int Width, int Height );
+
+	/** @brief Get the 8 bits intensity of each 16 bits value (65536 values).
+	 */
+	const unsigned char * GetTable() const
+	{
+		return &Table[0];
+	}
+
+	/** @brief Get the lower clip point of the table.
+	 */
+	int GetLow() const
+	{
+		return TableLow;
+	}
+
+	/** @brief Get the upper clip point of the table.
+	 */
+	int GetHigh() const
+	{
+		return TableHigh;
+	}
+
+	/** @brief Get the number of times the table was built, to detect changes.
+	 */
+	int GetVersion() const
+	{
+		return Version;
+	}
+
+	/** @brief Forget the smoothed range (e.g. after a seek).
+	 */
+	void Reset()
+	{
+		FirstFrame = true;
+	}
+
+protected:
+	/** @brief Compute the histogram of a frame in Histogram.
+	 *
+	 * @return the number of non zero values.
+	 */
+	int ComputeHistogram( const unsigned short int * Frame, int Width, int Height );
+
+	/** @brief Build Table for a range.
+	 */
+	void BuildTable( int Low, int High );
+
+	float LowPercentile;				/*!< @brief Fraction of pixels under the lower clip point */
+	float HighPercentile;				/*!< @brief Fraction of pixels under the upper clip point */
+	float Smoothing;					/*!< @brief Weight of the current frame in smoothed clip points */
+	int LineStep;						/*!< @brief Use one line every LineStep lines */
+
+	bool FirstFrame;					/*!< @brief No frame seen since construction or Reset */
+	float SmoothedLow;					/*!< @brief Smoothed lower clip point */
+	float SmoothedHigh;					/*!< @brief Smoothed upper clip point */
+	int TableLow;						/*!< @brief Lower clip point of Table */
+	int TableHigh;						/*!< @brief Upper clip point of Table */
+	int Version;						/*!< @brief Number of times Table was built */
+
+	std::vector<unsigned int> Histogram;	/*!< @brief Histogram, 4 interleaved sub-histograms while counting */
+	std::vector<unsigned char> Table;		/*!< @brief Intensity of each 16 bits value */
+	std::vector<unsigned char> Gamma;		/*!< @brief Gamma coded intensity of 0..GammaSteps normalised values */
+};
+
+} // namespace MobileRGBD
+
+#endif // __ADAPTIVE_RANGE_H__
@@ -0,0 +1,363 @@
+/**
+ * @file BatchRenderer.cpp
+ * @ingroup Drawing
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#include "BatchRenderer.h"
+#include "TimestampIndex.h"
+
+#include <stdio.h>
+#include <thread>
+#include <chrono>
+#include <stdexcept>
+#include <algorithm>
+
+#if defined WIN32 || defined WIN64
+#include <stdlib.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#endif
+
+using namespace MobileRGBD;
+
+/** @brief constructor.
+ *
+ * @param _NumberOfWorkers [in] Number of worker threads. 0 means one per core (Default = 0).
+ * @param _MaxRecordingsPerDisk [in] Maximum number of recordings read at the same time from one disk (Default = 2).
+ */
+BatchRenderer::BatchRenderer( int _NumberOfWorkers /* = 0 */, int _MaxRecordingsPerDisk /* = 2 */ )
+{
+	NumberOfWorkers = _NumberOfWorkers;
+	if ( NumberOfWorkers <= 0 )
+	{
+		NumberOfWorkers = (int)std::thread::hardware_concurrency();
+		if ( NumberOfWorkers <= 0 )
+		{
+			NumberOfWorkers = 1;
+		}
+	}
+
+	MaxRecordingsPerDisk = _MaxRecordingsPerDisk <= 0 ? 1 : _MaxRecordingsPerDisk;
+
+	CurrentFolders = nullptr;
+	CurrentRecipe = nullptr;
+	RemainingTasks = 0;
+}
+
+/** @brief Compute a key identifying the disk (device) containing a folder.
+ *
+ * @param Folder [in] Folder to check.
+ */
+// static
+std::string BatchRenderer::GetDiskKey( const std::string& Folder )
+{
+#if defined WIN32 || defined WIN64
+	char FullPath[_MAX_PATH];
+	if ( _fullpath( FullPath, Folder.c_str(), _MAX_PATH ) == nullptr )
+	{
+		return Folder;
+	}
+
+	std::string Path( FullPath );
+	if ( Path.size() >= 2 && Path[1] == ':' )
+	{
+		// Drive letter
+		return Path.substr( 0, 2 );
+	}
+
+	if ( Path.size() >= 2 && Path[0] == '\\' && Path[1] == '\\' )
+	{
+		// UNC path, \\server\share is the disk
+		size_t EndOfServer = Path.find( '\\', 2 );
+		size_t EndOfShare = EndOfServer == std::string::npos ? std::string::npos : Path.find( '\\', EndOfServer+1 );
+		return Path.substr( 0, EndOfShare );
+	}
+
+	return Path;
+#else
+	struct stat FolderStat;
+	if ( stat( Folder.c_str(), &FolderStat ) != 0 )
+	{
+		// Unknown, consider it as a separate disk
+		return Folder;
+	}
+
+	char tmpc[64];
+	sprintf( tmpc, "dev:%llu", (unsigned long long)FolderStat.st_dev );
+	return std::string( tmpc );
+#endif
+}
+
+/** @brief Try to acquire a reading slot on the disk of a recording.
+ */
+bool BatchRenderer::TryAcquireDisk( int Task )
+{
+	std::lock_guard<std::mutex> Lock( DiskMutex );
+
+	int& Usage = DiskUsage[TaskDisks[Task]];
+	if ( Usage >= MaxRecordingsPerDisk )
+	{
+		return false;
+	}
+
+	Usage++;
+	return true;
+}
+
+/** @brief Release the reading slot of a recording.
+ */
+void BatchRenderer::ReleaseDisk( int Task )
+{
+	{
+		std::lock_guard<std::mutex> Lock( DiskMutex );
+		DiskUsage[TaskDisks[Task]]--;
+	}
+
+	DiskReleased.notify_all();
+}
+
+/** @brief Take a recording to render: from the back of the worker queue, or from the front of another
+ *         worker queue. Recordings whose disk is busy are skipped.
+ *
+ * @param Worker [in] Id of the worker.
+ * @param Task [out] Index of the recording.
+ * @return true if a recording was found (its disk slot is acquired).
+ */
+bool BatchRenderer::TakeTask( int Worker, int& Task )
+{
+	for( int i = 0; i < NumberOfWorkers; i++ )
+	{
+		int Victim = (Worker+i)%NumberOfWorkers;
+		std::lock_guard<std::mutex> Lock( *QueueMutexes[Victim] );
+		std::deque<int>& Queue = Queues[Victim];
+
+		for( size_t Pos = 0; Pos < Queue.size(); Pos++ )
+		{
+			// Own queue is used as a stack (back), other queues are stolen from the front
+			size_t Candidate = (Victim == Worker) ? Queue.size()-1-Pos : Pos;
+			if ( TryAcquireDisk( Queue[Candidate] ) )
+			{
+				Task = Queue[Candidate];
+				Queue.erase( Queue.begin() + Candidate );
+				RemainingTasks--;
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+/** @brief Main loop of a worker thread.
+ *
+ * @param Worker [in] Id of the worker.
+ */
+void BatchRenderer::WorkerLoop( int Worker )
+{
+	for(;;)
+	{
+		int Task;
+		if ( TakeTask( Worker, Task ) )
+		{
+			Reports[Task].Worker = Worker;
+			RenderRecording( Task, Reports[Task] );
+			ReleaseDisk( Task );
+			continue;
+		}
+
+		if ( RemainingTasks.load() == 0 )
+		{
+			// Nothing left to take
+			return;
+		}
+
+		// Remaining recordings are on busy disks, wait for a slot
+		std::unique_lock<std::mutex> Lock( DiskMutex );
+		DiskReleased.wait_for( Lock, std::chrono::milliseconds(100) );
+	}
+}
+
+/** @brief Render one recording.
+ *
+ * @param Task [in] Index of the recording.
+ * @param Report [out] Report of the recording.
+ */
+void BatchRenderer::RenderRecording( int Task, RecordingReport& Report )
+{
+	const std::string& Folder = (*CurrentFolders)[Task];
+	const RenderRecipe& Recipe = *CurrentRecipe;
+
+	std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+
+	std::vector< std::vector<Drawable*> > Layers( Recipe.Targets.size() );
+	std::vector<cv::Mat> Canvases( Recipe.Targets.size() );
+
+	try
+	{
+		TimestampIndex Frames;
+		if ( Frames.Load( Folder + Recipe.ReferenceTimestampFile ) == false )
+		{
+			throw std::runtime_error( "unable to read " + Folder + Recipe.ReferenceTimestampFile );
+		}
+
+		// Create Drawables of this recording
+		for( size_t t = 0; t < Recipe.Targets.size(); t++ )
+		{
+			Canvases[t].create( Recipe.Targets[t].Size.height, Recipe.Targets[t].Size.width, CV_8UC3 );
+			for( size_t l = 0; l < Recipe.Targets[t].Layers.size(); l++ )
+			{
+				Layers[t].push_back( Recipe.Targets[t].Layers[l]( Folder ) );
+			}
+		}
+
+		int Step = Recipe.FrameStep <= 0 ? 1 : Recipe.FrameStep;
+		for( int Frame = 0; Frame < Frames.GetNumberOfEntries(); Frame += Step )
+		{
+			TimeB Timestamp = Frames.GetTimestamp( Frame );
+
+			for( size_t t = 0; t < Canvases.size(); t++ )
+			{
+				Canvases[t].setTo( cv::Scalar(0,0,0) );
+				for( size_t l = 0; l < Layers[t].size(); l++ )
+				{
+					if ( Layers[t][l] != nullptr )
+					{
+						Layers[t][l]->Draw( Canvases[t], Timestamp );
+					}
+				}
+			}
+
+			Report.FramesRendered++;
+
+			if ( Recipe.OnFrame && Recipe.OnFrame( Folder, Frame, Timestamp, Canvases ) == false )
+			{
+				break;
+			}
+		}
+
+		Report.Success = true;
+	}
+	catch( cv::Exception& )
+	{
+		Report.Error = "OpenCV exception";
+	}
+	catch( std::exception& e )
+	{
+		Report.Error = e.what();
+	}
+	catch( ... )
+	{
+		// Non standard exceptions (Omiscid...) must not escape worker threads
+		Report.Error = "Unknown exception";
+	}
+
+	for( size_t t = 0; t < Layers.size(); t++ )
+	{
+		for( size_t l = 0; l < Layers[t].size(); l++ )
+		{
+			delete Layers[t][l];
+		}
+	}
+
+	Report.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-Start).count();
+	Report.FramesPerSecond = Report.Seconds > 0.0 ? (double)Report.FramesRendered/Report.Seconds : 0.0;
+}
+
+/** @brief Render all recordings. Returns when all recordings are done.
+ *
+ * @param Folders [in] Recording folders.
+ * @param Recipe [in] What to render for each frame.
+ * @return a report for each recording, in the order of Folders.
+ */
+std::vector<RecordingReport> BatchRenderer::Run( const std::vector<std::string>& Folders, const RenderRecipe& Recipe )
+{
+	CurrentFolders = &Folders;
+	CurrentRecipe = &Recipe;
+
+	Reports.assign( Folders.size(), RecordingReport() );
+	TaskDisks.resize( Folders.size() );
+	DiskUsage.clear();
+
+	int WorkersForBatch = std::min( NumberOfWorkers, (int)Folders.size() );
+
+	Queues.assign( WorkersForBatch, std::deque<int>() );
+	QueueMutexes.clear();
+	for( int w = 0; w < WorkersForBatch; w++ )
+	{
+		QueueMutexes.push_back( std::unique_ptr<std::mutex>( new std::mutex ) );
+	}
+
+	// Deal recordings to workers
+	for( size_t i = 0; i < Folders.size(); i++ )
+	{
+		Reports[i].Folder = Folders[i];
+		Reports[i].Success = false;
+		Reports[i].Worker = -1;
+		Reports[i].FramesRendered = 0;
+		Reports[i].Seconds = 0.0;
+		Reports[i].FramesPerSecond = 0.0;
+
+		TaskDisks[i] = GetDiskKey( Folders[i] );
+		Queues[i%WorkersForBatch].push_back( (int)i );
+	}
+	RemainingTasks = (int)Folders.size();
+
+	// One worker per core: do not let OpenCV start its own threads in each worker
+	int PreviousOpenCVThreads = cv::getNumThreads();
+	cv::setNumThreads( 1 );
+
+	int SavedNumberOfWorkers = NumberOfWorkers;
+	NumberOfWorkers = WorkersForBatch;
+
+	std::vector<std::thread> Workers;
+	for( int w = 0; w < WorkersForBatch; w++ )
+	{
+		Workers.push_back( std::thread( &BatchRenderer::WorkerLoop, this, w ) );
+	}
+	for( size_t w = 0; w < Workers.size(); w++ )
+	{
+		Workers[w].join();
+	}
+
+	NumberOfWorkers = SavedNumberOfWorkers;
+	cv::setNumThreads( PreviousOpenCVThreads );
+
+	CurrentFolders = nullptr;
+	CurrentRecipe = nullptr;
+
+	return Reports;
+}
+
+/** @brief Write reports as text (one line per recording and a summary).
+ *
+ * @param Reports [in] Reports from Run.
+ * @param fout [in] Output file (Default = stdout).
+ */
+// static
+void BatchRenderer::PrintReports( const std::vector<RecordingReport>& Reports, FILE * fout /* = stdout */ )
+{
+	int TotalFrames = 0;
+	int Failures = 0;
+	double TotalSeconds = 0.0;
+
+	for( size_t i = 0; i < Reports.size(); i++ )
+	{
+		const RecordingReport& Report = Reports[i];
+
+		fprintf( fout, "%s: %s, worker %d, %d frames in %.2f s (%.1f fps)%s%s\n", Report.Folder.c_str(),
+			Report.Success ? "ok" : "FAILED", Report.Worker, Report.FramesRendered, Report.Seconds, Report.FramesPerSecond,
+			Report.Error.empty() ? "" : ", ", Report.Error.c_str() );
+
+		TotalFrames += Report.FramesRendered;
+		TotalSeconds += Report.Seconds;
+		if ( Report.Success == false )
+		{
+			Failures++;
+		}
+	}
+
+	fprintf( fout, "%d recordings (%d failed), %d frames, %.2f s of rendering\n", (int)Reports.size(), Failures, TotalFrames, TotalSeconds );
+}
@@ -0,0 +1,197 @@
+/**
+ * @file BatchRenderer.h
+ * @ingroup Drawing
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __BATCH_RENDERER_H__
+#define __BATCH_RENDERER_H__
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+#include "Drawable.h"
+
+namespace MobileRGBD {
+
+/**
+ * @class RenderRecipe BatchRenderer.h
+ * @brief Description of what to render for each frame of a recording: a list of targets (canvas size and
+ *        Drawable layers drawn in order on it) and a callback receiving the rendered canvases.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class RenderRecipe
+{
+public:
+	/** @brief Factory creating a Drawable for a recording folder. Drawables are created by the worker
+	 *         thread rendering the recording and deleted at the end of the recording.
+	 */
+	typedef std::function<Drawable*(const std::string& Folder)> DrawableFactory;
+
+	/** @brief Callback receiving the rendered canvases (one per target) of a frame. Return false to stop
+	 *         the recording. Called from worker threads, concurrently for different recordings.
+	 */
+	typedef std::function<bool(const std::string& Folder, int FrameIndex, const TimeB& Timestamp, std::vector<cv::Mat>& Canvases)> FrameCallback;
+
+	/**
+	 * @struct RenderTarget
+	 * @brief One output canvas: its size and the layers drawn on it.
+	 */
+	struct RenderTarget
+	{
+		std::string Name;								/*!< @brief Name of the target (for the callback user) */
+		cv::Size Size;									/*!< @brief Size of the canvas */
+		std::vector<DrawableFactory> Layers;			/*!< @brief Drawables, drawn in this order */
+	};
+
+	/** @brief constructor. Frames follow the video stream, every frame is rendered.
+	 */
+	RenderRecipe()
+	{
+		ReferenceTimestampFile = "/video/video.timestamp";
+		FrameStep = 1;
+	}
+
+	/** @brief Add a target to the recipe.
+	 *
+	 * @param Name [in] Name of the target.
+	 * @param Size [in] Size of the canvas.
+	 * @param Layers [in] Drawables, drawn in this order.
+	 */
+	void AddTarget( const std::string& Name, const cv::Size& Size, const std::vector<DrawableFactory>& Layers )
+	{
+		RenderTarget NewTarget;
+		NewTarget.Name = Name;
+		NewTarget.Size = Size;
+		NewTarget.Layers = Layers;
+		Targets.push_back( NewTarget );
+	}
+
+	std::vector<RenderTarget> Targets;		/*!< @brief Targets rendered for each frame */
+	std::string ReferenceTimestampFile;		/*!< @brief Timestamp file, relative to the recording folder, giving the frames to render */
+	int FrameStep;							/*!< @brief Render one frame every FrameStep frames of the reference stream */
+	FrameCallback OnFrame;					/*!< @brief Called for each rendered frame (may be empty) */
+};
+
+/**
+ * @struct RecordingReport
+ * @brief Result and throughput of the rendering of one recording.
+ */
+struct RecordingReport
+{
+	std::string Folder;			/*!< @brief Recording folder */
+	bool Success;				/*!< @brief Was the recording rendered without error? */
+	std::string Error;			/*!< @brief Error message if not */
+	int Worker;					/*!< @brief Worker thread that rendered it */
+	int FramesRendered;			/*!< @brief Number of rendered frames */
+	double Seconds;				/*!< @brief Rendering time (without waiting for the disk) */
+	double FramesPerSecond;		/*!< @brief Throughput */
+};
+
+/**
+ * @class BatchRenderer BatchRenderer.cpp BatchRenderer.h
+ * @brief Render a list of recordings with a recipe, in parallel. Recordings are dealt to per-worker
+ *        queues; a worker takes its own recordings first, then steals from other workers. The number
+ *        of recordings read at the same time from one disk is limited. Only one worker per core is
+ *        started and OpenCV internal threading is disabled during the batch to avoid oversubscribing.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class BatchRenderer
+{
+public:
+	/** @brief constructor.
+	 *
+	 * @param _NumberOfWorkers [in] Number of worker threads. 0 means one per core (Default = 0).
+	 * @param _MaxRecordingsPerDisk [in] Maximum number of recordings read at the same time from one disk (Default = 2).
+	 */
+	BatchRenderer( int _NumberOfWorkers = 0, int _MaxRecordingsPerDisk = 2 );
+
+	/** @brief Virtual destructor, always.
+	 */
+	virtual ~BatchRenderer() {}
+
+	/** @brief Render all recordings. Returns when all recordings are done.
+	 *
+	 * @param Folders [in] Recording folders.
+	 * @param Recipe [in] What to render for each frame.
+	 * @return a report for each recording, in the order of Folders.
+	 */
+	std::vector<RecordingReport> Run( const std::vector<std::string>& Folders, const RenderRecipe& Recipe );
+
+	/** @brief Write reports as text (one line per recording and a summary).
+	 *
+	 * @param Reports [in] Reports from Run.
+	 * @param fout [in] Output file (Default = stdout).
+	 */
+	static void PrintReports( const std::vector<RecordingReport>& Reports, FILE * fout = stdout );
+
+	/** @brief Compute a key identifying the disk (device) containing a folder.
+	 *
+	 * @param Folder [in] Folder to check.
+	 */
+	static std::string GetDiskKey( const std::string& Folder );
+
+protected:
+	/** @brief Main loop of a worker thread.
+	 *
+	 * @param Worker [in] Id of the worker.
+	 */
+	void WorkerLoop( int Worker );
+
+	/** @brief Take a recording to render: from the back of the worker queue, or from the front of another
+	 *         worker queue. Recordings whose disk is busy are skipped.
+	 *
+	 * @param Worker [in] Id of the worker.
+	 * @param Task [out] Index of the recording.
+	 * @return true if a recording was found (its disk slot is acquired).
+	 */
+	bool TakeTask( int Worker, int& Task );
+
+	/** @brief Try to acquire a reading slot on the disk of a recording.
+	 */
+	bool TryAcquireDisk( int Task );
+
+	/** @brief Release the reading slot of a recording.
+	 */
+	void ReleaseDisk( int Task );
+
+	/** @brief Render one recording.
+	 *
+	 * @param Task [in] Index of the recording.
+	 * @param Report [out] Report of the recording.
+	 */
+	void RenderRecording( int Task, RecordingReport& Report );
+
+	int NumberOfWorkers;				/*!< @brief Number of worker threads */
+	int MaxRecordingsPerDisk;			/*!< @brief Maximum number of recordings read at the same time from one disk */
+
+	// Batch state, valid during Run
+	const std::vector<std::string> * CurrentFolders;	/*!< @brief Folders of the current batch */
+	const RenderRecipe * CurrentRecipe;					/*!< @brief Recipe of the current batch */
+	std::vector<RecordingReport> Reports;				/*!< @brief Reports of the current batch */
+	std::vector<std::string> TaskDisks;					/*!< @brief Disk key of each recording */
+
+	std::vector<std::deque<int>> Queues;				/*!< @brief Recordings to render, per worker */
+	std::vector<std::unique_ptr<std::mutex>> QueueMutexes;	/*!< @brief One mutex per queue */
+
+	std::mutex DiskMutex;								/*!< @brief Protect DiskUsage */
+	std::condition_variable DiskReleased;				/*!< @brief Signaled when a disk slot is released */
+	std::map<std::string, int> DiskUsage;				/*!< @brief Number of recordings currently read per disk */
+
+	std::atomic<int> RemainingTasks;					/*!< @brief Number of recordings not yet taken */
+};
+
+} // namespace MobileRGBD
+
+#endif // __BATCH_RENDERER_H__
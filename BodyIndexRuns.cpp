@@ -0,0 +1,388 @@
+/**
+ * @file BodyIndexRuns.cpp
+ * @ingroup Drawing
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#include "BodyIndexRuns.h"
+#include "DrawingSimd.h"
+#include "IndexedFrameFile.h"
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace MobileRGBD;
+
+/** @brief constructor.
+ *
+ * @param _Width [in] Width of frames.
+ * @param _Height [in] Height of frames.
+ */
+BodyIndexRuns::BodyIndexRuns( int _Width, int _Height )
+{
+	Width = _Width;
+	Height = _Height;
+	LineStarts.assign( Height+1, 0 );
+}
+
+/** @brief Encode a frame.
+ *
+ * @param Frame [in] Body index frame (Width*Height bytes).
+ */
+void BodyIndexRuns::Encode( const unsigned char * Frame )
+{
+	Runs.clear();
+
+#ifdef DRAWING_SSE2
+	const __m128i BackgroundBytes = _mm_set1_epi8( (char)Background );
+#endif
+
+	for( int line = 0; line < Height; line++ )
+	{
+		LineStarts[line] = (int)Runs.size();
+
+		const unsigned char * Values = Frame + line*Width;
+		int col = 0;
+		while( col < Width )
+		{
+#ifdef DRAWING_SSE2
+			// Skip background 16 pixels at once
+			while( col+16 <= Width && _mm_movemask_epi8( _mm_cmpeq_epi8( _mm_loadu_si128( (const __m128i*)(Values+col) ), BackgroundBytes ) ) == 0xFFFF )
+			{
+				col += 16;
+			}
+			if ( col >= Width )
+			{
+				break;
+			}
+#endif
+			unsigned char Body = Values[col];
+			if ( Body >= NumberOfBodies )
+			{
+				col++;
+				continue;
+			}
+
+			// Run of the same body
+			int Start = col;
+			while( col < Width && Values[col] == Body )
+			{
+				col++;
+			}
+
+			BodyIndexRun NewRun;
+			NewRun.Line = (unsigned short int)line;
+			NewRun.Column = (unsigned short int)Start;
+			NewRun.Length = (unsigned short int)(col-Start);
+			NewRun.Body = Body;
+			NewRun.Reserved = 0;
+			Runs.push_back( NewRun );
+		}
+	}
+
+	LineStarts[Height] = (int)Runs.size();
+}
+
+/** @brief Set the runs of a frame (i.e. read from a compressed file).
+ *
+ * @param NewRuns [in] Runs, ordered by line then column.
+ * @param NumberOfRuns [in] Number of runs.
+ * @return false if a run is out of the frame.
+ */
+bool BodyIndexRuns::SetRuns( const BodyIndexRun * NewRuns, int NumberOfRuns )
+{
+	Runs.assign( NewRuns, NewRuns + NumberOfRuns );
+
+	int Run = 0;
+	for( int line = 0; line <= Height; line++ )
+	{
+		LineStarts[line] = Run;
+		while( Run < NumberOfRuns && Runs[Run].Line == line )
+		{
+			if ( Runs[Run].Column + Runs[Run].Length > Width || Runs[Run].Body >= NumberOfBodies )
+			{
+				Runs.clear();
+				LineStarts.assign( Height+1, 0 );
+				return false;
+			}
+			Run++;
+		}
+	}
+
+	if ( Run != NumberOfRuns )
+	{
+		// Runs not ordered or out of the frame
+		Runs.clear();
+		LineStarts.assign( Height+1, 0 );
+		return false;
+	}
+
+	return true;
+}
+
+/** @brief Compress the runs of the frame.
+ *
+ * @param Compressed [out] Compressed frame.
+ * @return the size of the compressed frame.
+ */
+int BodyIndexRuns::Compress( std::vector<unsigned char>& Compressed ) const
+{
+	Compressed.clear();
+
+	// Never empty, even without runs (empty frames are errors in IndexedFrameFile)
+	EncodeVLE( (unsigned int)Runs.size(), Compressed );
+
+	int Position = 0;
+	for( size_t r = 0; r < Runs.size(); r++ )
+	{
+		int Start = Runs[r].Line*Width + Runs[r].Column;
+		EncodeVLE( (unsigned int)(Start - Position), Compressed );
+		EncodeVLE( ((unsigned int)Runs[r].Length << 3) | Runs[r].Body, Compressed );
+		Position = Start + Runs[r].Length;
+	}
+
+	return (int)Compressed.size();
+}
+
+/** @brief Set the runs of the frame from a compressed frame.
+ *
+ * @param Compressed [in] Compressed frame.
+ * @param CompressedSize [in] Size of the compressed frame.
+ * @return true if the frame was decoded.
+ */
+bool BodyIndexRuns::Decompress( const unsigned char * Compressed, int CompressedSize )
+{
+	Runs.clear();
+
+	RunBuilder Builder;
+	Builder.Runs = &Runs;
+	Builder.Width = Width;
+	Builder.Position = 0;
+	if ( Decode( Compressed, CompressedSize, Width*Height, Builder ) == false )
+	{
+		Runs.clear();
+		LineStarts.assign( Height+1, 0 );
+		return false;
+	}
+
+	// Runs are ordered, index lines
+	size_t Run = 0;
+	for( int line = 0; line <= Height; line++ )
+	{
+		while( Run < Runs.size() && Runs[Run].Line < line )
+		{
+			Run++;
+		}
+		LineStarts[line] = (int)Run;
+	}
+
+	return true;
+}
+
+/** @brief Compress all frames of a raw body index file to a data file and its index (see IndexedFrameFile).
+ *         Frames are in the same order, so the timestamp file of the raw file remains valid.
+ *
+ * @param RawFile [in] Raw body index file.
+ * @param Width [in] Width of frames (1 byte per pixel).
+ * @param Height [in] Height of frames.
+ * @param RleFile [in] Compressed data file to write.
+ * @param IndexFile [in] Index file to write.
+ * @return true if the files were written.
+ */
+// static
+bool BodyIndexRuns::ConvertRawFile( const std::string& RawFile, int Width, int Height, const std::string& RleFile, const std::string& IndexFile )
+{
+	FILE * fin = fopen( RawFile.c_str(), "rb" );
+	if ( fin == nullptr )
+	{
+		return false;
+	}
+
+	IndexedFrameFileWriter Writer;
+	if ( Writer.Open( RleFile, IndexFile ) == false )
+	{
+		fclose( fin );
+		return false;
+	}
+
+	BodyIndexRuns Frame( Width, Height );
+	std::vector<unsigned char> RawFrame( Width*Height );
+	std::vector<unsigned char> Compressed;
+
+	bool Ret = true;
+	while( fread( &RawFrame[0], Width*Height, 1, fin ) == 1 )
+	{
+		Frame.Encode( &RawFrame[0] );
+		int Size = Frame.Compress( Compressed );
+		if ( Writer.AddFrame( &Compressed[0], Size, Width*Height ) == false )
+		{
+			Ret = false;
+			break;
+		}
+	}
+
+	if ( ferror( fin ) != 0 )
+	{
+		Ret = false;
+	}
+	fclose( fin );
+
+	// Do not leave truncated files
+	return Writer.Close( Ret == false ) && Ret;
+}
+
+/** @brief Expand the runs in a body index frame.
+ *
+ * @param Frame [out] Body index frame (Width*Height bytes).
+ */
+void BodyIndexRuns::Decode( unsigned char * Frame ) const
+{
+	memset( Frame, Background, Width*Height );
+
+	for( size_t r = 0; r < Runs.size(); r++ )
+	{
+		memset( Frame + Runs[r].Line*Width + Runs[r].Column, Runs[r].Body, Runs[r].Length );
+	}
+}
+
+/** @brief Get inner pixels of a run (ends excluded) not covered by runs of the same body on another line.
+ *
+ * @param Run [in] The run.
+ * @param OtherLine [in] The line above or below, -1 or Height if out of the frame.
+ * @param Uncovered [out] Uncovered columns.
+ */
+void BodyIndexRuns::GetUncoveredPixels( const BodyIndexRun& Run, int OtherLine, Intervals& Uncovered ) const
+{
+	Uncovered.clear();
+
+	// Run ends are always in the outline, inner pixels only
+	int First = Run.Column+1;
+	int Last = Run.Column + Run.Length - 2;
+	if ( First > Last )
+	{
+		return;
+	}
+
+	int Pos = First;
+	if ( OtherLine >= 0 && OtherLine < Height )
+	{
+		for( int r = LineStarts[OtherLine]; r < LineStarts[OtherLine+1] && Pos <= Last; r++ )
+		{
+			const BodyIndexRun& Other = Runs[r];
+			int OtherEnd = Other.Column + Other.Length - 1;
+			if ( Other.Body != Run.Body || OtherEnd < Pos )
+			{
+				continue;
+			}
+			if ( Other.Column > Last )
+			{
+				break;
+			}
+
+			// Uncovered pixels before Other
+			if ( Pos < Other.Column )
+			{
+				Uncovered.push_back( std::make_pair( Pos, (int)Other.Column-1 ) );
+			}
+			Pos = std::max( Pos, OtherEnd+1 );
+		}
+	}
+
+	if ( Pos <= Last )
+	{
+		Uncovered.push_back( std::make_pair( Pos, Last ) );
+	}
+}
+
+/** @brief Compute statistics of each body from the runs.
+ *
+ * @param Statistics [out] Statistics of each body (NumberOfBodies elements).
+ * @param ComputeOutlines [in] Compute outlines of bodies (Default = true).
+ */
+void BodyIndexRuns::ComputeStatistics( BodyStatistics * Statistics, bool ComputeOutlines /* = true */ ) const
+{
+	int MinX[NumberOfBodies], MinY[NumberOfBodies], MaxX[NumberOfBodies], MaxY[NumberOfBodies];
+	double SumX[NumberOfBodies], SumY[NumberOfBodies];
+	Intervals Above, Below;
+
+	for( int b = 0; b < NumberOfBodies; b++ )
+	{
+		Statistics[b].PixelCount = 0;
+		Statistics[b].Outline.clear();
+		MinX[b] = Width;
+		MinY[b] = Height;
+		MaxX[b] = -1;
+		MaxY[b] = -1;
+		SumX[b] = 0.0;
+		SumY[b] = 0.0;
+	}
+
+	for( size_t r = 0; r < Runs.size(); r++ )
+	{
+		const BodyIndexRun& Run = Runs[r];
+		int b = Run.Body;
+		int End = Run.Column + Run.Length - 1;
+
+		Statistics[b].PixelCount += Run.Length;
+		MinX[b] = std::min( MinX[b], (int)Run.Column );
+		MaxX[b] = std::max( MaxX[b], End );
+		MinY[b] = std::min( MinY[b], (int)Run.Line );
+		MaxY[b] = std::max( MaxY[b], (int)Run.Line );
+		SumX[b] += (double)Run.Length*((double)Run.Column + (double)End)*0.5;
+		SumY[b] += (double)Run.Length*(double)Run.Line;
+
+		if ( ComputeOutlines )
+		{
+			std::vector<cv::Point>& Outline = Statistics[b].Outline;
+			Outline.push_back( cv::Point( Run.Column, Run.Line ) );
+			if ( Run.Length > 1 )
+			{
+				Outline.push_back( cv::Point( End, Run.Line ) );
+			}
+
+			// Inner pixels uncovered above or below, each pixel once
+			GetUncoveredPixels( Run, Run.Line-1, Above );
+			GetUncoveredPixels( Run, Run.Line+1, Below );
+			size_t a = 0, u = 0;
+			while( a < Above.size() || u < Below.size() )
+			{
+				// Take the interval starting first, then merge all intervals overlapping it
+				std::pair<int,int> Current = (u == Below.size() || (a < Above.size() && Above[a].first <= Below[u].first)) ? Above[a++] : Below[u++];
+				for(;;)
+				{
+					if ( a < Above.size() && Above[a].first <= Current.second+1 )
+					{
+						Current.second = std::max( Current.second, Above[a++].second );
+					}
+					else if ( u < Below.size() && Below[u].first <= Current.second+1 )
+					{
+						Current.second = std::max( Current.second, Below[u++].second );
+					}
+					else
+					{
+						break;
+					}
+				}
+
+				for( int x = Current.first; x <= Current.second; x++ )
+				{
+					Outline.push_back( cv::Point( x, Run.Line ) );
+				}
+			}
+		}
+	}
+
+	for( int b = 0; b < NumberOfBodies; b++ )
+	{
+		if ( Statistics[b].PixelCount == 0 )
+		{
+			Statistics[b].BoundingBox = cv::Rect( 0, 0, 0, 0 );
+			Statistics[b].Centroid = cv::Point2f( 0.0f, 0.0f );
+			continue;
+		}
+
+		Statistics[b].BoundingBox = cv::Rect( MinX[b], MinY[b], MaxX[b]-MinX[b]+1, MaxY[b]-MinY[b]+1 );
+		Statistics[b].Centroid = cv::Point2f( (float)(SumX[b]/Statistics[b].PixelCount), (float)(SumY[b]/Statistics[b].PixelCount) );
+	}
+}
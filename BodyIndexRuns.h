@@ -0,0 +1,304 @@
+/**
+ * @file BodyIndexRuns.h
+ * @ingroup Drawing
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __BODY_INDEX_RUNS_H__
+#define __BODY_INDEX_RUNS_H__
+
+#include <string>
+#include <vector>
+
+#undef min
+#undef max
+#include <algorithm>
+
+#include "Drawable.h"
+
+namespace MobileRGBD {
+
+/**
+ * @struct BodyIndexRun
+ * @brief Horizontal run of pixels of one body in a body index frame. Runs never cross lines.
+ */
+struct BodyIndexRun
+{
+	unsigned short int Line;		/*!< @brief Line of the run */
+	unsigned short int Column;		/*!< @brief First column of the run */
+	unsigned short int Length;		/*!< @brief Number of pixels */
+	unsigned char Body;				/*!< @brief Body index (0..5) */
+	unsigned char Reserved;			/*!< @brief Alignment, 0 */
+};
+
+/**
+ * @struct BodyStatistics
+ * @brief Statistics of a body in a body index frame.
+ */
+struct BodyStatistics
+{
+	int PixelCount;					/*!< @brief Number of pixels of the body, 0 if absent */
+	cv::Rect BoundingBox;			/*!< @brief Bounding box of the body */
+	cv::Point2f Centroid;			/*!< @brief Center of mass of the body */
+	std::vector<cv::Point> Outline;	/*!< @brief Pixels of the body with a 4-neighbour outside the body */
+};
+
+/**
+ * @class BodyIndexRuns BodyIndexRuns.cpp BodyIndexRuns.h
+ * @brief Run-length encoding of body index frames (one byte per pixel, 0..5 for bodies, 255 for background).
+ *        Frames are encoded in one scan, skipping background 16 pixels at once (SSE2 when available);
+ *        only body pixels produce runs. Per-body pixel counts, bounding boxes, centroids and outlines are
+ *        computed from the runs (edges of runs and parts of runs not covered by the same body on the
+ *        line above or below), without a binary mask per body.
+ *        Runs are also the compressed storage of body index frames (see Compress and IndexedFrameFile): the
+ *        number of runs then, for each run, the number of background pixels since the previous run and the
+ *        length and body of the run, as variable length numbers (7 bits per byte, high bit set if more bytes follow).
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class BodyIndexRuns
+{
+public:
+	enum { NumberOfBodies = 6, Background = 255 };
+
+	/** @brief constructor.
+	 *
+	 * @param _Width [in] Width of frames.
+	 * @param _Height [in] Height of frames.
+	 */
+	BodyIndexRuns( int _Width, int _Height );
+
+	/** @brief Virtual destructor, always.
+	 */
+	virtual ~BodyIndexRuns() {}
+
+	/** @brief Encode a frame.
+	 *
+	 * @param Frame [in] Body index frame (Width*Height bytes).
+	 */
+	void Encode( const unsigned char * Frame );
+
+	/** @brief Set the runs of a frame (i.e. read from a compressed file).
+	 *
+	 * @param NewRuns [in] Runs, ordered by line then column.
+	 * @param NumberOfRuns [in] Number of runs.
+	 * @return false if a run is out of the frame.
+	 */
+	bool SetRuns( const BodyIndexRun * NewRuns, int NumberOfRuns );
+
+	/** @brief Get the runs of the frame, ordered by line then column.
+	 */
+	const std::vector<BodyIndexRun>& GetRuns() const
+	{
+		return Runs;
+	}
+
+	/** @brief Expand the runs in a body index frame.
+	 *
+	 * @param Frame [out] Body index frame (Width*Height bytes).
+	 */
+	void Decode( unsigned char * Frame ) const;
+
+	/** @brief Compress the runs of the frame.
+	 *
+	 * @param Compressed [out] Compressed frame.
+	 * @return the size of the compressed frame.
+	 */
+	int Compress( std::vector<unsigned char>& Compressed ) const;
+
+	/** @brief Set the runs of the frame from a compressed frame.
+	 *
+	 * @param Compressed [in] Compressed frame.
+	 * @param CompressedSize [in] Size of the compressed frame.
+	 * @return true if the frame was decoded.
+	 */
+	bool Decompress( const unsigned char * Compressed, int CompressedSize );
+
+	/** @brief Compress all frames of a raw body index file to a data file and its index (see IndexedFrameFile).
+	 *         Frames are in the same order, so the timestamp file of the raw file remains valid.
+	 *
+	 * @param RawFile [in] Raw body index file.
+	 * @param Width [in] Width of frames (1 byte per pixel).
+	 * @param Height [in] Height of frames.
+	 * @param RleFile [in] Compressed data file to write.
+	 * @param IndexFile [in] Index file to write.
+	 * @return true if the files were written.
+	 */
+	static bool ConvertRawFile( const std::string& RawFile, int Width, int Height, const std::string& RleFile, const std::string& IndexFile );
+
+	/** @brief Decode a compressed frame and give each run to a sink, without building the runs. The sink must
+	 *         have two methods: Background(int Count) for Count background pixels and Run(unsigned char Body, int Count)
+	 *         for Count pixels of a body. Background pixels after the last run are given to the sink.
+	 *
+	 * @param Compressed [in] Compressed frame.
+	 * @param CompressedSize [in] Size of the compressed frame.
+	 * @param NumberOfPixels [in] Number of pixels of the frame.
+	 * @param Sink [in] Receiver of runs.
+	 * @return true if the frame was decoded, false if the data are corrupted (the sink may have received some runs).
+	 */
+	template<class RunSink>
+	static bool Decode( const unsigned char * Compressed, int CompressedSize, int NumberOfPixels, RunSink& Sink )
+	{
+		const unsigned char * End = Compressed + CompressedSize;
+
+		unsigned int NumberOfRuns;
+		if ( DecodeVLE( Compressed, End, NumberOfRuns ) == false )
+		{
+			return false;
+		}
+
+		unsigned int Remaining = (unsigned int)NumberOfPixels;
+		for( unsigned int r = 0; r < NumberOfRuns; r++ )
+		{
+			unsigned int Skip, LengthAndBody;
+			if ( DecodeVLE( Compressed, End, Skip ) == false || DecodeVLE( Compressed, End, LengthAndBody ) == false )
+			{
+				return false;
+			}
+
+			unsigned int Length = LengthAndBody >> 3;
+			unsigned char Body = (unsigned char)(LengthAndBody & 0x7);
+			if ( Skip > Remaining || Length == 0 || Length > Remaining - Skip || Body >= NumberOfBodies )
+			{
+				return false;
+			}
+
+			if ( Skip != 0 )
+			{
+				Sink.Background( (int)Skip );
+			}
+			Sink.Run( Body, (int)Length );
+
+			Remaining -= Skip + Length;
+		}
+
+		if ( Remaining != 0 )
+		{
+			Sink.Background( (int)Remaining );
+		}
+
+		return true;
+	}
+
+	/** @brief Compute statistics of each body from the runs.
+	 *
+	 * @param Statistics [out] Statistics of each body (NumberOfBodies elements).
+	 * @param ComputeOutlines [in] Compute outlines of bodies (Default = true).
+	 */
+	void ComputeStatistics( BodyStatistics * Statistics, bool ComputeOutlines = true ) const;
+
+	/** @brief Get the width of frames.
+	 */
+	int GetWidth() const
+	{
+		return Width;
+	}
+
+	/** @brief Get the height of frames.
+	 */
+	int GetHeight() const
+	{
+		return Height;
+	}
+
+protected:
+	/** @brief Read a variable length number.
+	 *
+	 * @param Pos [in,out] Position in the compressed frame.
+	 * @param End [in] End of the compressed frame.
+	 * @param Value [out] The number.
+	 * @return false if the data are corrupted.
+	 */
+	static bool DecodeVLE( const unsigned char *& Pos, const unsigned char * End, unsigned int& Value )
+	{
+		Value = 0;
+		for( int Shift = 0; Shift < 32; Shift += 7 )
+		{
+			if ( Pos >= End )
+			{
+				return false;
+			}
+			unsigned char Byte = *Pos++;
+			Value |= (unsigned int)(Byte & 0x7f) << Shift;
+			if ( (Byte & 0x80) == 0 )
+			{
+				return true;
+			}
+		}
+
+		// Number too large
+		return false;
+	}
+
+	/** @brief Write a variable length number.
+	 *
+	 * @param Value [in] The number.
+	 * @param Compressed [in,out] Compressed frame.
+	 */
+	static void EncodeVLE( unsigned int Value, std::vector<unsigned char>& Compressed )
+	{
+		while( Value >= 0x80 )
+		{
+			Compressed.push_back( (unsigned char)(Value | 0x80) );
+			Value >>= 7;
+		}
+		Compressed.push_back( (unsigned char)Value );
+	}
+
+	/**
+	 * @struct RunBuilder
+	 * @brief Sink building runs (see Decode), split at line ends.
+	 */
+	struct RunBuilder
+	{
+		/** @brief Skip background pixels.
+		 */
+		void Background( int Count )
+		{
+			Position += Count;
+		}
+
+		/** @brief Add the pixels of a body.
+		 */
+		void Run( unsigned char Body, int Count )
+		{
+			while( Count > 0 )
+			{
+				BodyIndexRun NewRun;
+				NewRun.Line = (unsigned short int)(Position/Width);
+				NewRun.Column = (unsigned short int)(Position%Width);
+				NewRun.Length = (unsigned short int)std::min( Count, Width - (int)NewRun.Column );
+				NewRun.Body = Body;
+				NewRun.Reserved = 0;
+				Runs->push_back( NewRun );
+
+				Position += NewRun.Length;
+				Count -= NewRun.Length;
+			}
+		}
+
+		std::vector<BodyIndexRun> * Runs;	/*!< @brief Runs to build */
+		int Width;							/*!< @brief Width of frames */
+		int Position;						/*!< @brief Current pixel */
+	};
+
+	typedef std::vector< std::pair<int,int> > Intervals;	/*!< @brief Sorted, disjoint [first, last] column intervals */
+
+	/** @brief Get inner pixels of a run (ends excluded) not covered by runs of the same body on another line.
+	 *
+	 * @param Run [in] The run.
+	 * @param OtherLine [in] The line above or below, -1 or Height if out of the frame.
+	 * @param Uncovered [out] Uncovered columns.
+	 */
+	void GetUncoveredPixels( const BodyIndexRun& Run, int OtherLine, Intervals& Uncovered ) const;
+
+	int Width;							/*!< @brief Width of frames */
+	int Height;							/*!< @brief Height of frames */
+	std::vector<BodyIndexRun> Runs;		/*!< @brief Runs of the frame */
+	std::vector<int> LineStarts;		/*!< @brief First run of each line, Height+1 elements */
+};
+
+} // namespace MobileRGBD
+
+#endif // __BODY_INDEX_RUNS_H__
@@ -0,0 +1,29 @@
+/**
+ * @file CompanionRawData.cpp
+ * @ingroup Drawing
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#include "CompanionRawData.h"
+
+#include <stdio.h>
+
+using namespace MobileRGBD;
+
+/** @brief Check if a file exists (to know if a companion is available before creating it).
+ *
+ * @param FileName [in] File to check.
+ */
+// static
+bool CompanionRawData::FileExists( const std::string& FileName )
+{
+	FILE * fin = fopen( FileName.c_str(), "rb" );
+	if ( fin == nullptr )
+	{
+		return false;
+	}
+
+	fclose( fin );
+	return true;
+}
@@ -0,0 +1,84 @@
+/**
+ * @file CompanionRawData.h
+ * @ingroup Drawing
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __COMPANION_RAW_DATA_H__
+#define __COMPANION_RAW_DATA_H__
+
+#include "DrawTimestampRawData.h"
+
+namespace MobileRGBD {
+
+/**
+ * @class CompanionRawData CompanionRawData.cpp CompanionRawData.h
+ * @brief Reader for a raw file stored next to the raw file of a stream (proxy, index of a compressed
+ *        file, ...). It usually shares the timestamp file of the stream: frame i of the companion
+ *        file corresponds to frame i of the stream. When data are ready, ProcessCompanionElement of
+ *        the owner is called.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class CompanionRawData : public ReadTimestampRawFile
+{
+public:
+	/** @brief constructor.
+	 *
+	 * @param _Owner [in] Object receiving the frames of this companion.
+	 * @param _CompanionId [in] Id given back to the owner to know which companion calls it.
+	 * @param TimestampFile [in] Timestamp file (usually the one of the owner).
+	 * @param RawFile [in] Companion raw file.
+	 * @param SizeOfFrame [in] Size of each frame in the companion raw file.
+	 */
+	CompanionRawData( DrawTimestampRawData& _Owner, int _CompanionId, const std::string& TimestampFile, const std::string& RawFile, int SizeOfFrame )
+		: ReadTimestampRawFile( TimestampFile, RawFile, SizeOfFrame ), Owner( _Owner )
+	{
+		CompanionId = _CompanionId;
+		StartingFrame = Owner.GetStartingFrame();
+	}
+
+	/** @brief Virtual destructor, always.
+	 */
+	virtual ~CompanionRawData() {}
+
+	/** @brief Get the current frame of the companion.
+	 */
+	void * GetFrame()
+	{
+		return (void*)FrameBuffer;
+	}
+
+	/** @brief Get the size of frames of the companion.
+	 */
+	int GetFrameSize() const
+	{
+		return FrameSize;
+	}
+
+	/** @brief Check if a file exists (to know if a companion is available before creating it).
+	 *
+	 * @param FileName [in] File to check.
+	 */
+	static bool FileExists( const std::string& FileName );
+
+	/** @brief ProcessElement is a callback function called by mother classes when data are ready.
+	 *         Forward the frame to the owner.
+	 *
+	 * @param RequestTimestamp [in] The timestamp of the data.
+	 * @param UserData [in] User pointer to working data.
+	 */
+	virtual bool ProcessElement( const TimeB &RequestTimestamp, void * UserData = nullptr )
+	{
+		return Owner.ProcessCompanionElement( CompanionId, *this, RequestTimestamp, UserData );
+	}
+
+protected:
+	DrawTimestampRawData& Owner;		/*!< @brief Object receiving the frames */
+	int CompanionId;					/*!< @brief Id of this companion for the owner */
+};
+
+} // namespace MobileRGBD
+
+#endif // __COMPANION_RAW_DATA_H__
@@ -0,0 +1,176 @@
+/**
+ * @file CursorReader.cpp
+ * @ingroup Drawing
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#include "CursorReader.h"
+
+#if defined WIN32 || defined WIN64
+	#define fseek64 _fseeki64
+#else
+	#define fseek64 fseeko
+#endif
+
+using namespace MobileRGBD;
+
+/** @brief constructor. Nothing is opened.
+ */
+CursorReader::CursorReader()
+{
+	SubFrames = false;
+	Cursor = nullptr;
+	TimestampStream = nullptr;
+	RawStream = nullptr;
+}
+
+/** @brief Virtual destructor, always.
+ */
+CursorReader::~CursorReader()
+{
+	Close();
+}
+
+/** @brief Index a stream and open its files.
+ *
+ * @param TimestampFile [in] Timestamp file of the stream.
+ * @param RawFile [in] Raw file of the stream ("" if none).
+ * @param _SubFrames [in] Entries of the raw file have a variable number of sub-frames (see PresenceIndex).
+ * @return true if the stream can be read.
+ */
+bool CursorReader::Open( const std::string& TimestampFile, const std::string& RawFile, bool _SubFrames )
+{
+	Close();
+
+	SubFrames = _SubFrames;
+
+	// Built from the timestamp file, lines offsets are not in presence sidecars
+	bool Indexed = SubFrames ? Presence.Build( TimestampFile ) : Index.Load( TimestampFile );
+	if ( Indexed == false )
+	{
+		return false;
+	}
+
+	if ( RawFile.empty() == false )
+	{
+		RawStream = fopen( RawFile.c_str(), "rb" );
+		if ( RawStream == nullptr )
+		{
+			return false;
+		}
+	}
+
+	TimestampStream = fopen( TimestampFile.c_str(), "rb" );
+	if ( TimestampStream == nullptr )
+	{
+		Close();
+		return false;
+	}
+
+	Cursor = new TimestampCursor( GetIndex() );
+
+	return true;
+}
+
+/** @brief Close files and free the index.
+ */
+void CursorReader::Close()
+{
+	if ( TimestampStream != nullptr )
+	{
+		fclose( TimestampStream );
+		TimestampStream = nullptr;
+	}
+	if ( RawStream != nullptr )
+	{
+		fclose( RawStream );
+		RawStream = nullptr;
+	}
+
+	delete Cursor;
+	Cursor = nullptr;
+
+	Index = TimestampIndex();
+	Presence = PresenceIndex();
+}
+
+/** @brief Search the entry with the nearest timestamp from the previous request.
+ *
+ * @param RequestMilliseconds [in] Searched timestamp in milliseconds since epoch.
+ * @return the entry, NotFound if the stream is empty.
+ */
+int CursorReader::Search( long long RequestMilliseconds )
+{
+	if ( Cursor == nullptr )
+	{
+		return NotFound;
+	}
+
+	// Walks forward or backward from the previous entry, binary search on far jumps
+	int Entry = Cursor->SearchNearest( RequestMilliseconds );
+	return Entry < 0 ? NotFound : Entry;
+}
+
+/** @brief Read the data following the timestamp on the line of an entry.
+ *
+ * @param Entry [in] Index of the entry.
+ * @return the data (valid until the next call), nullptr on error.
+ */
+char * CursorReader::ReadData( int Entry )
+{
+	long long Position = GetIndex().GetOffset( Entry );
+	if ( TimestampStream == nullptr || Position < 0 || fseek64( TimestampStream, Position, SEEK_SET ) != 0 )
+	{
+		return nullptr;
+	}
+
+	long long EntryMilliseconds;
+	const char * EntryData;
+	if ( TimestampIndex::ReadLine( TimestampStream, Line, Position ) == false ||
+		 TimestampIndex::ParseLine( Line.c_str(), EntryMilliseconds, EntryData ) == false )
+	{
+		return nullptr;
+	}
+
+	return &Line[EntryData - Line.c_str()];
+}
+
+/** @brief Read the frames of an entry in the raw file, one frame or all its sub-frames.
+ *
+ * @param Entry [in] Index of the entry.
+ * @param FrameSize [in] Size of a frame (or sub-frame).
+ * @param NumberOfFrames [out] Number of read frames.
+ * @return the frames (valid until the next call), nullptr on error.
+ */
+void * CursorReader::ReadFrames( int Entry, int FrameSize, int& NumberOfFrames )
+{
+	NumberOfFrames = 0;
+	if ( RawStream == nullptr || FrameSize <= 0 || Entry < 0 || Entry >= GetIndex().GetNumberOfEntries() )
+	{
+		return nullptr;
+	}
+
+	long long FirstFrame = Entry;
+	int Count = 1;
+	if ( SubFrames )
+	{
+		FirstFrame = Presence.GetFirstSubFrame( Entry );
+		Count = Presence.GetCount( Entry );
+	}
+
+	// At least one frame, to always return a valid pointer
+	size_t NeededSize = (size_t)(Count > 0 ? Count : 1)*(size_t)FrameSize;
+	if ( Frames.size() < NeededSize )
+	{
+		Frames.resize( NeededSize );
+	}
+
+	if ( Count > 0 && (fseek64( RawStream, FirstFrame*FrameSize, SEEK_SET ) != 0 || fread( &Frames[0], (size_t)Count*(size_t)FrameSize, 1, RawStream ) != 1) )
+	{
+		return nullptr;
+	}
+
+	NumberOfFrames = Count;
+	return &Frames[0];
+}
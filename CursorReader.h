@@ -0,0 +1,109 @@
+/**
+ * @file CursorReader.h
+ * @ingroup Drawing
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __CURSOR_READER_H__
+#define __CURSOR_READER_H__
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "TimestampIndex.h"
+#include "PresenceIndex.h"
+
+namespace MobileRGBD {
+
+/**
+ * @class CursorReader CursorReader.cpp CursorReader.h
+ * @brief Read entries of a stream during playback without searching its timestamp file. The stream is
+ *        indexed once (TimestampIndex, or PresenceIndex for sub-frames streams), requests advance a
+ *        TimestampCursor and the line and frames of the found entry are read by offset in the timestamp
+ *        and raw files. The cursor walks forward or backward from the previous request, far jumps
+ *        (seeks) are binary searches in the index.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class CursorReader
+{
+public:
+	/** @brief Result of Search if no entry was found.
+	 */
+	enum { NotFound = -1 };
+
+	/** @brief constructor. Nothing is opened.
+	 */
+	CursorReader();
+
+	/** @brief Virtual destructor, always.
+	 */
+	virtual ~CursorReader();
+
+	/** @brief Index a stream and open its files.
+	 *
+	 * @param TimestampFile [in] Timestamp file of the stream.
+	 * @param RawFile [in] Raw file of the stream ("" if none).
+	 * @param _SubFrames [in] Entries of the raw file have a variable number of sub-frames (see PresenceIndex).
+	 * @return true if the stream can be read.
+	 */
+	bool Open( const std::string& TimestampFile, const std::string& RawFile, bool _SubFrames );
+
+	/** @brief Close files and free the index.
+	 */
+	void Close();
+
+	/** @brief Is the stream opened?
+	 */
+	bool IsOpen() const
+	{
+		return TimestampStream != nullptr;
+	}
+
+	/** @brief Search the entry with the nearest timestamp from the previous request.
+	 *
+	 * @param RequestMilliseconds [in] Searched timestamp in milliseconds since epoch.
+	 * @return the entry, NotFound if the stream is empty.
+	 */
+	int Search( long long RequestMilliseconds );
+
+	/** @brief Read the data following the timestamp on the line of an entry.
+	 *
+	 * @param Entry [in] Index of the entry.
+	 * @return the data (valid until the next call), nullptr on error.
+	 */
+	char * ReadData( int Entry );
+
+	/** @brief Read the frames of an entry in the raw file, one frame or all its sub-frames.
+	 *
+	 * @param Entry [in] Index of the entry.
+	 * @param FrameSize [in] Size of a frame (or sub-frame).
+	 * @param NumberOfFrames [out] Number of read frames.
+	 * @return the frames (valid until the next call), nullptr on error.
+	 */
+	void * ReadFrames( int Entry, int FrameSize, int& NumberOfFrames );
+
+	/** @brief Get the index of the stream.
+	 */
+	const TimestampIndex& GetIndex() const
+	{
+		return SubFrames ? (const TimestampIndex&)Presence : Index;
+	}
+
+protected:
+	TimestampIndex Index;					/*!< @brief Index of single frame streams */
+	PresenceIndex Presence;					/*!< @brief Index of sub-frames streams */
+	bool SubFrames;							/*!< @brief Entries have a variable number of sub-frames */
+	TimestampCursor * Cursor;				/*!< @brief Cursor on the index of the stream */
+
+	FILE * TimestampStream;					/*!< @brief Timestamp file, read by offset */
+	FILE * RawStream;						/*!< @brief Raw file, read by offset */
+	std::string Line;						/*!< @brief Last read line */
+	std::vector<unsigned char> Frames;		/*!< @brief Last read frames */
+};
+
+} // namespace MobileRGBD
+
+#endif // __CURSOR_READER_H__
@@ -0,0 +1,84 @@
+/**
+ * @file DepthCalibration.h
+ * @ingroup Drawing Kinect
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __DEPTH_CALIBRATION_H__
+#define __DEPTH_CALIBRATION_H__
+
+#ifdef KINECT_2
+
+namespace MobileRGBD { namespace Kinect2 {
+
+/**
+ * @struct DepthIntrinsics
+ * @brief Pinhole parameters of the Kinect2 depth camera, in depth pixels. Default values are
+ *        the usual factory values of Kinect2 sensors.
+ */
+struct DepthIntrinsics
+{
+	float FocalLengthX;			/*!< @brief Horizontal focal length */
+	float FocalLengthY;			/*!< @brief Vertical focal length */
+	float PrincipalPointX;		/*!< @brief Column of the optical center */
+	float PrincipalPointY;		/*!< @brief Line of the optical center */
+
+	/** @brief constructor. Usual Kinect2 values.
+	 */
+	DepthIntrinsics()
+	{
+		FocalLengthX = 365.456f;
+		FocalLengthY = 365.456f;
+		PrincipalPointX = 254.878f;
+		PrincipalPointY = 205.395f;
+	}
+};
+
+/**
+ * @struct ColorIntrinsics
+ * @brief Pinhole parameters of the Kinect2 color camera, in 1920x1080 video pixels. Default values are
+ *        the usual factory values of Kinect2 sensors.
+ */
+struct ColorIntrinsics
+{
+	float FocalLengthX;			/*!< @brief Horizontal focal length */
+	float FocalLengthY;			/*!< @brief Vertical focal length */
+	float PrincipalPointX;		/*!< @brief Column of the optical center */
+	float PrincipalPointY;		/*!< @brief Line of the optical center */
+
+	/** @brief constructor. Usual Kinect2 values.
+	 */
+	ColorIntrinsics()
+	{
+		FocalLengthX = 1081.372f;
+		FocalLengthY = 1081.372f;
+		PrincipalPointX = 959.5f;
+		PrincipalPointY = 539.5f;
+	}
+};
+
+/**
+ * @struct DepthColorCalibration
+ * @brief Calibration between the depth and the color cameras of a Kinect2. Both cameras are considered
+ *        rectified: the color camera is only shifted along the X axis of the depth camera.
+ */
+struct DepthColorCalibration
+{
+	DepthIntrinsics Depth;		/*!< @brief Depth camera */
+	ColorIntrinsics Color;		/*!< @brief Color camera */
+	float Baseline;				/*!< @brief X of the color camera in the depth camera frame, in meters */
+
+	/** @brief constructor. Usual Kinect2 values.
+	 */
+	DepthColorCalibration()
+	{
+		Baseline = 0.052f;
+	}
+};
+
+}} // namespace MobileRGBD::Kinect2
+
+#endif // KINECT_2
+
+#endif // __DEPTH_CALIBRATION_H__
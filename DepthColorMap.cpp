@@ -0,0 +1,126 @@
+/**
+ * @file DepthColorMap.cpp
+ * @ingroup Drawing
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#include "DepthColorMap.h"
+
+using namespace MobileRGBD;
+
+namespace {
+
+const int ColorSteps = 1024;		// Number of colors computed for a color map
+
+/** @brief Clamp to [0, 1].
+ */
+inline float Saturate( float Value )
+{
+	return Value < 0.0f ? 0.0f : (Value > 1.0f ? 1.0f : Value);
+}
+
+} // anonymous namespace
+
+/** @brief constructor.
+ *
+ * @param _Map [in] Color map (Default = Turbo).
+ * @param NearMeters [in] Depth drawn with the first color (Default = 0.5).
+ * @param FarMeters [in] Depth drawn with the last color (Default = 4.5).
+ */
+DepthColorMap::DepthColorMap( Palette _Map /* = Turbo */, float NearMeters /* = 0.5f */, float FarMeters /* = 4.5f */ )
+	: Table( 65536, BGRPixel( 0, 0, 0 ) )
+{
+	Version = 0;
+	Map = _Map;
+	Near = (int)(NearMeters*1000.0f + 0.5f);
+	Far = (int)(FarMeters*1000.0f + 0.5f);
+	Build();
+}
+
+/** @brief Set the color map and its limits in millimeters (i.e. from an AdaptiveRange).
+ *
+ * @param _Map [in] Color map.
+ * @param _Near [in] Depth drawn with the first color.
+ * @param _Far [in] Depth drawn with the last color.
+ */
+void DepthColorMap::SetRange( Palette _Map, int _Near, int _Far )
+{
+	if ( _Map == Map && _Near == Near && _Far == Far )
+	{
+		return;
+	}
+
+	Map = _Map;
+	Near = _Near;
+	Far = _Far;
+	Build();
+}
+
+/** @brief Get the color of a normalised value.
+ *
+ * @param Map [in] Color map.
+ * @param Value [in] Value in [0, 1].
+ */
+// static
+BGRPixel DepthColorMap::GetColor( Palette Map, float Value )
+{
+	float x = Saturate( Value );
+	float r, g, b;
+
+	if ( Map == Jet )
+	{
+		r = Saturate( 1.5f - fabsf( 4.0f*x - 3.0f ) );
+		g = Saturate( 1.5f - fabsf( 4.0f*x - 2.0f ) );
+		b = Saturate( 1.5f - fabsf( 4.0f*x - 1.0f ) );
+	}
+	else
+	{
+		// Polynomial approximation of Turbo (Google AI, Apache 2.0)
+		float x2 = x*x;
+		float x3 = x2*x;
+		float x4 = x3*x;
+		float x5 = x4*x;
+		r = 0.13572138f + 4.61539260f*x - 42.66032258f*x2 + 132.13108234f*x3 - 152.94239396f*x4 + 59.28637943f*x5;
+		g = 0.09140261f + 2.19418839f*x + 4.84296658f*x2 - 14.18503333f*x3 + 4.27729857f*x4 + 2.82956604f*x5;
+		b = 0.10667330f + 12.64194608f*x - 60.58204836f*x2 + 110.36276771f*x3 - 89.90310912f*x4 + 27.34824973f*x5;
+	}
+
+	return BGRPixel( (unsigned char)(Saturate(b)*255.0f + 0.5f), (unsigned char)(Saturate(g)*255.0f + 0.5f), (unsigned char)(Saturate(r)*255.0f + 0.5f) );
+}
+
+/** @brief Build Table for the current color map and limits.
+ */
+void DepthColorMap::Build()
+{
+	if ( Far <= Near )
+	{
+		Far = Near+1;
+	}
+	Version++;
+
+	// Colors of the map, then lookup for each depth value
+	std::vector<BGRPixel> Colors( ColorSteps+1, BGRPixel( 0, 0, 0 ) );
+	for( int Step = 0; Step <= ColorSteps; Step++ )
+	{
+		Colors[Step] = GetColor( Map, (float)Step/(float)ColorSteps );
+	}
+
+	Table[0] = BGRPixel( 0, 0, 0 );
+	const float Scale = (float)ColorSteps/(float)(Far-Near);
+	for( int Depth = 1; Depth < 65536; Depth++ )
+	{
+		if ( Depth <= Near )
+		{
+			Table[Depth] = Colors[0];
+		}
+		else if ( Depth >= Far )
+		{
+			Table[Depth] = Colors[ColorSteps];
+		}
+		else
+		{
+			Table[Depth] = Colors[(int)((float)(Depth-Near)*Scale)];
+		}
+	}
+}
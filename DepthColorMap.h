@@ -0,0 +1,104 @@
+/**
+ * @file DepthColorMap.h
+ * @ingroup Drawing
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __DEPTH_COLOR_MAP_H__
+#define __DEPTH_COLOR_MAP_H__
+
+#include <vector>
+
+#include "PixelKernels.h"
+
+namespace MobileRGBD {
+
+/**
+ * @class DepthColorMap DepthColorMap.cpp DepthColorMap.h
+ * @brief Color of each 16 bits depth value (in millimeters) for a color map between a near and a far
+ *        limit. Depth is drawn in one pass through the table (see DepthColor16), without an intermediate
+ *        grey image and cv::applyColorMap. Near depth is blue, far depth is red, no depth (0) is black.
+ *        The table is rebuilt only when the color map or the limits change.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class DepthColorMap
+{
+public:
+	enum Palette { Jet, Turbo };	/*!< @brief Available color maps (Jet as cv::COLORMAP_JET) */
+
+	/** @brief constructor.
+	 *
+	 * @param _Map [in] Color map (Default = Turbo).
+	 * @param NearMeters [in] Depth drawn with the first color (Default = 0.5).
+	 * @param FarMeters [in] Depth drawn with the last color (Default = 4.5).
+	 */
+	DepthColorMap( Palette _Map = Turbo, float NearMeters = 0.5f, float FarMeters = 4.5f );
+
+	/** @brief Virtual destructor, always.
+	 */
+	virtual ~DepthColorMap() {}
+
+	/** @brief Set the color map and its limits.
+	 *
+	 * @param _Map [in] Color map.
+	 * @param NearMeters [in] Depth drawn with the first color.
+	 * @param FarMeters [in] Depth drawn with the last color.
+	 */
+	void Set( Palette _Map, float NearMeters, float FarMeters )
+	{
+		SetRange( _Map, (int)(NearMeters*1000.0f + 0.5f), (int)(FarMeters*1000.0f + 0.5f) );
+	}
+
+	/** @brief Set the color map and its limits in millimeters (i.e. from an AdaptiveRange).
+	 *
+	 * @param _Map [in] Color map.
+	 * @param _Near [in] Depth drawn with the first color.
+	 * @param _Far [in] Depth drawn with the last color.
+	 */
+	void SetRange( Palette _Map, int _Near, int _Far );
+
+	/** @brief Get the current color map.
+	 */
+	Palette GetPalette() const
+	{
+		return Map;
+	}
+
+	/** @brief Get the number of times the table was built, to detect changes.
+	 */
+	int GetVersion() const
+	{
+		return Version;
+	}
+
+	/** @brief Get the color table (65536 values).
+	 */
+	const BGRPixel * GetTable() const
+	{
+		return &Table[0];
+	}
+
+	/** @brief Get the color of a normalised value.
+	 *
+	 * @param Map [in] Color map.
+	 * @param Value [in] Value in [0, 1].
+	 */
+	static BGRPixel GetColor( Palette Map, float Value );
+
+protected:
+	/** @brief Build Table for the current color map and limits.
+	 */
+	void Build();
+
+	Palette Map;					/*!< @brief Current color map */
+	int Near;						/*!< @brief Depth of the first color, in millimeters */
+	int Far;						/*!< @brief Depth of the last color, in millimeters */
+	int Version;					/*!< @brief Number of times Table was built */
+	std::vector<BGRPixel> Table;	/*!< @brief Color of each depth value */
+};
+
+} // namespace MobileRGBD
+
+#endif // __DEPTH_COLOR_MAP_H__
@@ -0,0 +1,236 @@
+/**
+ * @file DepthColorRegistration.cpp
+ * @ingroup Drawing Kinect
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#include "DepthColorRegistration.h"
+
+#include <math.h>
+
+#undef min
+#undef max
+#include <algorithm>
+
+#ifdef KINECT_2
+
+namespace MobileRGBD { namespace Kinect2 {
+
+namespace {
+
+// Target map entries: depth (13 bits) above pixel index (18 bits), so the nearest pixel has the lowest entry
+const int IndexBits = 18;
+const unsigned int IndexMask = (1u << IndexBits) - 1;
+const unsigned int MaxPackedDepth = (1u << (31-IndexBits)) - 1;
+const unsigned int NoPixel = 0xFFFFFFFFu;
+
+} // anonymous namespace
+
+/** @brief constructor.
+ *
+ * @param _Calibration [in] Calibration of the Kinect2 (Default = usual Kinect2 values).
+ */
+DepthColorRegistration::DepthColorRegistration( const DepthColorCalibration& _Calibration /* = DepthColorCalibration() */ )
+{
+	SetCalibration( _Calibration );
+}
+
+/** @brief Change the calibration. Tables will be recomputed at next use.
+ *
+ * @param _Calibration [in] Calibration of the Kinect2.
+ */
+void DepthColorRegistration::SetCalibration( const DepthColorCalibration& _Calibration )
+{
+	Calibration = _Calibration;
+	TablesReady = false;
+
+	// Shift in pixels of a point at Depth mm: FocalLength*Baseline/Z
+	ShiftFactor = Calibration.Color.FocalLengthX*Calibration.Baseline*1000.0f;
+}
+
+/** @brief Compute tables from the calibration if needed.
+ */
+void DepthColorRegistration::BuildTables()
+{
+	if ( TablesReady )
+	{
+		return;
+	}
+
+	ColorX.resize( DepthWidth*DepthHeight );
+	ColorY.resize( DepthWidth*DepthHeight );
+
+	int Pos = 0;
+	for( int line = 0; line < DepthHeight; line++ )
+	{
+		float RayY = ((float)line - Calibration.Depth.PrincipalPointY)/Calibration.Depth.FocalLengthY;
+		for( int col = 0; col < DepthWidth; col++, Pos++ )
+		{
+			float RayX = ((float)col - Calibration.Depth.PrincipalPointX)/Calibration.Depth.FocalLengthX;
+			ColorX[Pos] = RayX*Calibration.Color.FocalLengthX + Calibration.Color.PrincipalPointX;
+			ColorY[Pos] = RayY*Calibration.Color.FocalLengthY + Calibration.Color.PrincipalPointY;
+		}
+	}
+
+	Shift.resize( ShiftTableSize );
+	Shift[0] = 0.0f;
+	for( int Depth = 1; Depth < ShiftTableSize; Depth++ )
+	{
+		Shift[Depth] = ShiftFactor/(float)Depth;
+	}
+
+	TablesReady = true;
+}
+
+/** @brief Get the video position of a depth pixel.
+ *
+ * @param Col [in] Column of the depth pixel.
+ * @param Line [in] Line of the depth pixel.
+ * @param Depth [in] Depth value in millimeters.
+ * @param _ColorX [out] Column in the 1920x1080 video.
+ * @param _ColorY [out] Line in the 1920x1080 video.
+ * @return false if the pixel has no depth.
+ */
+bool DepthColorRegistration::MapToColor( int Col, int Line, unsigned short int Depth, float& _ColorX, float& _ColorY )
+{
+	if ( Depth == 0 || Col < 0 || Col >= DepthWidth || Line < 0 || Line >= DepthHeight )
+	{
+		return false;
+	}
+
+	BuildTables();
+
+	int Pos = Line*DepthWidth + Col;
+	_ColorX = ColorX[Pos] + GetShift( Depth );
+	_ColorY = ColorY[Pos];
+
+	return true;
+}
+
+/** @brief Warp a depth space image in video space. Each depth pixel covers its footprint in the video,
+ *         the nearest one wins. Pixels without depth pixel are black.
+ *
+ * @param DepthSpaceImage [in] BGR image of DepthWidth*DepthHeight pixels (continuous).
+ * @param DepthFrame [in] Depth frame (DepthWidth*DepthHeight values in millimeters).
+ * @param WhereToDraw [in] BGR image with the video aspect ratio (any size).
+ */
+void DepthColorRegistration::WarpToColor( const cv::Mat& DepthSpaceImage, const unsigned short int * DepthFrame, cv::Mat& WhereToDraw )
+{
+	if ( WhereToDraw.type() != CV_8UC3 || DepthSpaceImage.type() != CV_8UC3 || DepthSpaceImage.isContinuous() == false ||
+		 DepthSpaceImage.cols != DepthWidth || DepthSpaceImage.rows != DepthHeight )
+	{
+		return;
+	}
+
+	BuildTables();
+
+	const int TargetWidth = WhereToDraw.cols;
+	const int TargetHeight = WhereToDraw.rows;
+	const float ScaleX = (float)TargetWidth/(float)CamWidth;
+	const float ScaleY = (float)TargetHeight/(float)CamHeight;
+
+	// Size in target pixels of a depth pixel
+	const int FootprintWidth = std::max( 1, (int)ceilf( Calibration.Color.FocalLengthX/Calibration.Depth.FocalLengthX*ScaleX ) );
+	const int FootprintHeight = std::max( 1, (int)ceilf( Calibration.Color.FocalLengthY/Calibration.Depth.FocalLengthY*ScaleY ) );
+
+	// Keep the nearest depth pixel of each target pixel (no allocation once sized)
+	TargetMap.assign( TargetWidth*TargetHeight, NoPixel );
+
+	for( int Pos = 0; Pos < DepthWidth*DepthHeight; Pos++ )
+	{
+		unsigned short int Depth = DepthFrame[Pos];
+		if ( Depth == 0 )
+		{
+			continue;
+		}
+
+		int x0 = (int)floorf( (ColorX[Pos] + GetShift( Depth ))*ScaleX ) - FootprintWidth/2;
+		int y0 = (int)floorf( ColorY[Pos]*ScaleY ) - FootprintHeight/2;
+		int x1 = std::min( x0 + FootprintWidth, TargetWidth );
+		int y1 = std::min( y0 + FootprintHeight, TargetHeight );
+		x0 = std::max( x0, 0 );
+		y0 = std::max( y0, 0 );
+
+		unsigned int Entry = (std::min( (unsigned int)Depth, MaxPackedDepth ) << IndexBits) | (unsigned int)Pos;
+		for( int y = y0; y < y1; y++ )
+		{
+			unsigned int * Cell = &TargetMap[y*TargetWidth];
+			for( int x = x0; x < x1; x++ )
+			{
+				if ( Entry < Cell[x] )
+				{
+					Cell[x] = Entry;
+				}
+			}
+		}
+	}
+
+	// Gather pass
+	const unsigned char * Source = DepthSpaceImage.data;
+	const unsigned int * Map = &TargetMap[0];
+	for( int y = 0; y < TargetHeight; y++ )
+	{
+		unsigned char * Target = WhereToDraw.ptr<unsigned char>( y );
+		for( int x = 0; x < TargetWidth; x++, Map++, Target += 3 )
+		{
+			if ( *Map == NoPixel )
+			{
+				Target[0] = Target[1] = Target[2] = 0;
+				continue;
+			}
+
+			const unsigned char * Pixel = Source + (*Map & IndexMask)*3;
+			Target[0] = Pixel[0];
+			Target[1] = Pixel[1];
+			Target[2] = Pixel[2];
+		}
+	}
+}
+
+/** @brief Warp a video space image in depth space. Pixels without depth are black.
+ *
+ * @param ColorSpaceImage [in] BGR image with the video aspect ratio (any size).
+ * @param DepthFrame [in] Depth frame (DepthWidth*DepthHeight values in millimeters).
+ * @param WhereToDraw [out] BGR image of DepthWidth*DepthHeight pixels, allocated if needed.
+ */
+void DepthColorRegistration::WarpToDepth( const cv::Mat& ColorSpaceImage, const unsigned short int * DepthFrame, cv::Mat& WhereToDraw )
+{
+	if ( ColorSpaceImage.type() != CV_8UC3 )
+	{
+		return;
+	}
+
+	BuildTables();
+
+	WhereToDraw.create( DepthHeight, DepthWidth, CV_8UC3 );
+
+	const float ScaleX = (float)ColorSpaceImage.cols/(float)CamWidth;
+	const float ScaleY = (float)ColorSpaceImage.rows/(float)CamHeight;
+
+	int Pos = 0;
+	for( int line = 0; line < DepthHeight; line++ )
+	{
+		unsigned char * Target = WhereToDraw.ptr<unsigned char>( line );
+		for( int col = 0; col < DepthWidth; col++, Pos++, Target += 3 )
+		{
+			unsigned short int Depth = DepthFrame[Pos];
+			int x = (int)floorf( (ColorX[Pos] + GetShift( Depth ))*ScaleX );
+			int y = (int)floorf( ColorY[Pos]*ScaleY );
+			if ( Depth == 0 || x < 0 || x >= ColorSpaceImage.cols || y < 0 || y >= ColorSpaceImage.rows )
+			{
+				Target[0] = Target[1] = Target[2] = 0;
+				continue;
+			}
+
+			const unsigned char * Pixel = ColorSpaceImage.ptr<unsigned char>( y ) + x*3;
+			Target[0] = Pixel[0];
+			Target[1] = Pixel[1];
+			Target[2] = Pixel[2];
+		}
+	}
+}
+
+}} // namespace MobileRGBD::Kinect2
+
+#endif // KINECT_2
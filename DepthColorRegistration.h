@@ -0,0 +1,117 @@
+/**
+ * @file DepthColorRegistration.h
+ * @ingroup Drawing Kinect
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __DEPTH_COLOR_REGISTRATION_H__
+#define __DEPTH_COLOR_REGISTRATION_H__
+
+#include <vector>
+
+#include "opencv2/core/core.hpp"
+
+#include "../Kinect/KinectBasics.h"
+#include "DepthCalibration.h"
+
+#ifdef KINECT_2
+
+namespace MobileRGBD { namespace Kinect2 {
+
+/**
+ * @class DepthColorRegistration DepthColorRegistration.cpp DepthColorRegistration.h
+ * @brief Registration of depth space images (depth, body index, infrared) with the 1920x1080 video.
+ *        The video position of each depth pixel at infinite depth and the parallax shift of each depth
+ *        value are computed once per calibration. For each frame, each depth pixel is then placed with
+ *        one table lookup and one addition. Images are warped in one gather pass.
+ *        Tables are computed at first use.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class DepthColorRegistration
+{
+public:
+	enum { ShiftTableSize = 8192 };		/*!< @brief Depth values (mm) with a precomputed shift, farther values are computed */
+
+	/** @brief constructor.
+	 *
+	 * @param _Calibration [in] Calibration of the Kinect2 (Default = usual Kinect2 values).
+	 */
+	DepthColorRegistration( const DepthColorCalibration& _Calibration = DepthColorCalibration() );
+
+	/** @brief Virtual destructor, always.
+	 */
+	virtual ~DepthColorRegistration() {}
+
+	/** @brief Change the calibration. Tables will be recomputed at next use.
+	 *
+	 * @param _Calibration [in] Calibration of the Kinect2.
+	 */
+	void SetCalibration( const DepthColorCalibration& _Calibration );
+
+	/** @brief Get the current calibration.
+	 */
+	const DepthColorCalibration& GetCalibration() const
+	{
+		return Calibration;
+	}
+
+	/** @brief Get the video position of a depth pixel.
+	 *
+	 * @param Col [in] Column of the depth pixel.
+	 * @param Line [in] Line of the depth pixel.
+	 * @param Depth [in] Depth value in millimeters.
+	 * @param _ColorX [out] Column in the 1920x1080 video.
+	 * @param _ColorY [out] Line in the 1920x1080 video.
+	 * @return false if the pixel has no depth.
+	 */
+	bool MapToColor( int Col, int Line, unsigned short int Depth, float& _ColorX, float& _ColorY );
+
+	/** @brief Warp a depth space image in video space. Each depth pixel covers its footprint in the video,
+	 *         the nearest one wins. Pixels without depth pixel are black.
+	 *
+	 * @param DepthSpaceImage [in] BGR image of DepthWidth*DepthHeight pixels (continuous).
+	 * @param DepthFrame [in] Depth frame (DepthWidth*DepthHeight values in millimeters).
+	 * @param WhereToDraw [in] BGR image with the video aspect ratio (any size).
+	 */
+	void WarpToColor( const cv::Mat& DepthSpaceImage, const unsigned short int * DepthFrame, cv::Mat& WhereToDraw );
+
+	/** @brief Warp a video space image in depth space. Pixels without depth are black.
+	 *
+	 * @param ColorSpaceImage [in] BGR image with the video aspect ratio (any size).
+	 * @param DepthFrame [in] Depth frame (DepthWidth*DepthHeight values in millimeters).
+	 * @param WhereToDraw [out] BGR image of DepthWidth*DepthHeight pixels, allocated if needed.
+	 */
+	void WarpToDepth( const cv::Mat& ColorSpaceImage, const unsigned short int * DepthFrame, cv::Mat& WhereToDraw );
+
+protected:
+	/** @brief Compute tables from the calibration if needed.
+	 */
+	void BuildTables();
+
+	/** @brief Horizontal shift in video pixels of a depth value.
+	 */
+	float GetShift( unsigned short int Depth ) const
+	{
+		if ( Depth < ShiftTableSize )
+		{
+			return Shift[Depth];
+		}
+		return ShiftFactor/(float)Depth;
+	}
+
+	DepthColorCalibration Calibration;		/*!< @brief Calibration of the Kinect2 */
+	bool TablesReady;						/*!< @brief Are tables computed for the calibration? */
+	float ShiftFactor;						/*!< @brief Shift = ShiftFactor/Depth */
+	std::vector<float> ColorX;				/*!< @brief Video column of each depth pixel at infinite depth */
+	std::vector<float> ColorY;				/*!< @brief Video line of each depth pixel */
+	std::vector<float> Shift;				/*!< @brief Horizontal shift in video pixels of each depth value */
+	std::vector<unsigned int> TargetMap;	/*!< @brief Nearest depth pixel (depth and index) of each target pixel, kept from frame to frame */
+};
+
+}} // namespace MobileRGBD::Kinect2
+
+#endif // KINECT_2
+
+#endif // __DEPTH_COLOR_REGISTRATION_H__
@@ -0,0 +1,165 @@
+/**
+ * @file DepthPointCloud.cpp
+ * @ingroup Drawing Kinect
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#include "DepthPointCloud.h"
+#include "DrawingTools.h"
+#include "DrawingSimd.h"
+
+#ifdef KINECT_2
+
+namespace MobileRGBD { namespace Kinect2 {
+
+/** @brief constructor.
+ *
+ * @param _Intrinsics [in] Parameters of the depth camera (Default = usual Kinect2 values).
+ */
+DepthPointCloud::DepthPointCloud( const DepthIntrinsics& _Intrinsics /* = DepthIntrinsics() */ )
+	: X( NumberOfPoints ), Y( NumberOfPoints ), Z( NumberOfPoints )
+{
+	SetIntrinsics( _Intrinsics );
+}
+
+/** @brief Change the intrinsics and recompute the ray table.
+ *
+ * @param _Intrinsics [in] Parameters of the depth camera.
+ */
+void DepthPointCloud::SetIntrinsics( const DepthIntrinsics& _Intrinsics )
+{
+	Intrinsics = _Intrinsics;
+
+	RayX.resize( NumberOfPoints );
+	RayY.resize( NumberOfPoints );
+
+	int Pos = 0;
+	for( int line = 0; line < DepthHeight; line++ )
+	{
+		float LineRay = ((float)line - Intrinsics.PrincipalPointY)/Intrinsics.FocalLengthY;
+		for( int col = 0; col < DepthWidth; col++, Pos++ )
+		{
+			RayX[Pos] = ((float)col - Intrinsics.PrincipalPointX)/Intrinsics.FocalLengthX;
+			RayY[Pos] = LineRay;
+		}
+	}
+}
+
+/** @brief Compute points from depth values and rays. Output arrays may be unaligned.
+ *
+ * @param Depth [in] Depth values in millimeters.
+ * @param RayX [in] X of the ray of each value at Z = 1 m.
+ * @param RayY [in] Y of the ray of each value at Z = 1 m.
+ * @param Count [in] Number of values.
+ * @param X [out] X of points in meters.
+ * @param Y [out] Y of points in meters.
+ * @param Z [out] Z of points in meters.
+ */
+// static
+void DepthPointCloud::ComputePoints( const unsigned short int * Depth, const float * RayX, const float * RayY, int Count, float * X, float * Y, float * Z )
+{
+	int i = 0;
+
+#ifdef DRAWING_SSE2
+	const __m128i Zero = _mm_setzero_si128();
+	const __m128 MillimetersToMeters = _mm_set1_ps( 0.001f );
+
+	// 8 depth values per iteration
+	for( ; i+8 <= Count; i += 8 )
+	{
+		__m128i Values = _mm_loadu_si128( (const __m128i*)(Depth+i) );
+
+		__m128 ZLow = _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpacklo_epi16( Values, Zero ) ), MillimetersToMeters );
+		__m128 ZHigh = _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpackhi_epi16( Values, Zero ) ), MillimetersToMeters );
+
+		_mm_storeu_ps( Z+i, ZLow );
+		_mm_storeu_ps( Z+i+4, ZHigh );
+		_mm_storeu_ps( X+i, _mm_mul_ps( ZLow, _mm_loadu_ps( RayX+i ) ) );
+		_mm_storeu_ps( X+i+4, _mm_mul_ps( ZHigh, _mm_loadu_ps( RayX+i+4 ) ) );
+		_mm_storeu_ps( Y+i, _mm_mul_ps( ZLow, _mm_loadu_ps( RayY+i ) ) );
+		_mm_storeu_ps( Y+i+4, _mm_mul_ps( ZHigh, _mm_loadu_ps( RayY+i+4 ) ) );
+	}
+#endif
+
+	// Remaining values (all values without SSE2)
+	for( ; i < Count; i++ )
+	{
+		float Value = (float)Depth[i]*0.001f;
+		Z[i] = Value;
+		X[i] = Value*RayX[i];
+		Y[i] = Value*RayY[i];
+	}
+}
+
+/** @brief Compute points of a depth frame.
+ *
+ * @param DepthFrame [in] Raw Kinect2 depth frame (DepthWidth*DepthHeight values in millimeters).
+ */
+void DepthPointCloud::Compute( const unsigned short int * DepthFrame )
+{
+	ComputePoints( DepthFrame, &RayX[0], &RayY[0], NumberOfPoints, &X[0], &Y[0], &Z[0] );
+}
+
+/** @brief Draw points seen from above, in the same metric frame and scale than DrawLaserData
+ *         (sensor at X_CoordonateToPixelCentered(0)/Y_CoordonateToPixelCentered(0), forward to the top).
+ *
+ * @param WhereToDraw [in] Drawing cv::Mat (BGR).
+ * @param Color [in] Color of points (Default = yellow).
+ * @param MinHeight [in] Points lower than MinHeight meters under the sensor are not drawn (Default = no limit).
+ * @param MaxHeight [in] Points higher than MaxHeight meters above the sensor are not drawn (Default = no limit).
+ */
+void DepthPointCloud::DrawBirdsEye( cv::Mat& WhereToDraw, const cv::Vec3b& Color /* = cv::Vec3b(0,255,255) */, float MinHeight /* = -1.0e6f */, float MaxHeight /* = 1.0e6f */ ) const
+{
+	if ( WhereToDraw.type() != CV_8UC3 )
+	{
+		return;
+	}
+
+	for( int i = 0; i < NumberOfPoints; i++ )
+	{
+		// Y goes down, height goes up
+		float Height = -Y[i];
+		if ( Z[i] == 0.0f || Height < MinHeight || Height > MaxHeight )
+		{
+			continue;
+		}
+
+		// Forward (Z) to the top of the image, like the laser
+		int x = X_CoordonateToPixelCentered( X[i], WhereToDraw.cols );
+		int y = Y_CoordonateToPixelCentered( -Z[i], WhereToDraw.rows );
+		if ( x < 0 || x >= WhereToDraw.cols || y < 0 || y >= WhereToDraw.rows )
+		{
+			continue;
+		}
+
+		WhereToDraw.at<cv::Vec3b>( y, x ) = Color;
+	}
+}
+
+/** @brief ProcessElement is a callback function called by mother classes when data are ready.
+ *
+ * @param RequestTimestamp [in] The timestamp of the data.
+ * @param UserData [in] User pointer to working data. Here a pointer to a cv:Mat to draw in.
+ */
+bool DrawPointCloud::ProcessElement( const TimeB &RequestTimestamp, void * UserData /* = nullptr */ )
+{
+	cv::Mat& WhereToDraw = *((cv::Mat*)UserData);
+
+	DRAWING_FRAME_READ( 1, FrameSize );
+
+	DRAWING_STAGE_TIMER( ConversionStage );
+
+	Cloud.Compute( (const unsigned short int *)FrameBuffer );
+
+	DRAWING_STAGE_STOP( ConversionStage );
+	DRAWING_STAGE_TIMER( OverlayStage );
+
+	Cloud.DrawBirdsEye( WhereToDraw, Color, MinHeight, MaxHeight );
+
+	return true;
+}
+
+}} // namespace MobileRGBD::Kinect2
+
+#endif // KINECT_2
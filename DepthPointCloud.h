@@ -0,0 +1,181 @@
+/**
+ * @file DepthPointCloud.h
+ * @ingroup Drawing Kinect
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __DEPTH_POINT_CLOUD_H__
+#define __DEPTH_POINT_CLOUD_H__
+
+#include <vector>
+
+#include "DrawRawData.h"
+#include "DrawDepthView.h"
+#include "DepthCalibration.h"
+
+#ifdef KINECT_2
+
+namespace MobileRGBD { namespace Kinect2 {
+
+/**
+ * @class DepthPointCloud DepthPointCloud.cpp DepthPointCloud.h
+ * @brief 3D points of Kinect2 depth frames, in meters, in the depth camera frame (X to the right of the
+ *        depth image, Y to the bottom, Z forward). The ray of each pixel (its X and Y at Z = 1 m) is computed
+ *        once from the intrinsics, so a point costs one multiply per axis (SSE2 when available).
+ *        Points are stored as separate X, Y and Z arrays in pixel order; pixels without depth have Z = 0.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class DepthPointCloud
+{
+public:
+	enum { NumberOfPoints = DepthWidth*DepthHeight };	/*!< @brief One point per depth pixel */
+
+	/** @brief constructor.
+	 *
+	 * @param _Intrinsics [in] Parameters of the depth camera (Default = usual Kinect2 values).
+	 */
+	DepthPointCloud( const DepthIntrinsics& _Intrinsics = DepthIntrinsics() );
+
+	/** @brief Virtual destructor, always.
+	 */
+	virtual ~DepthPointCloud() {}
+
+	/** @brief Change the intrinsics and recompute the ray table.
+	 *
+	 * @param _Intrinsics [in] Parameters of the depth camera.
+	 */
+	void SetIntrinsics( const DepthIntrinsics& _Intrinsics );
+
+	/** @brief Get the current intrinsics.
+	 */
+	const DepthIntrinsics& GetIntrinsics() const
+	{
+		return Intrinsics;
+	}
+
+	/** @brief Compute points of a depth frame.
+	 *
+	 * @param DepthFrame [in] Raw Kinect2 depth frame (DepthWidth*DepthHeight values in millimeters).
+	 */
+	void Compute( const unsigned short int * DepthFrame );
+
+	/** @brief Compute points from depth values and rays. Output arrays may be unaligned.
+	 *
+	 * @param Depth [in] Depth values in millimeters.
+	 * @param RayX [in] X of the ray of each value at Z = 1 m.
+	 * @param RayY [in] Y of the ray of each value at Z = 1 m.
+	 * @param Count [in] Number of values.
+	 * @param X [out] X of points in meters.
+	 * @param Y [out] Y of points in meters.
+	 * @param Z [out] Z of points in meters.
+	 */
+	static void ComputePoints( const unsigned short int * Depth, const float * RayX, const float * RayY, int Count, float * X, float * Y, float * Z );
+
+	/** @brief Get X of points (NumberOfPoints values).
+	 */
+	const float * GetX() const
+	{
+		return &X[0];
+	}
+
+	/** @brief Get Y of points (NumberOfPoints values).
+	 */
+	const float * GetY() const
+	{
+		return &Y[0];
+	}
+
+	/** @brief Get Z of points (NumberOfPoints values). 0 means no depth.
+	 */
+	const float * GetZ() const
+	{
+		return &Z[0];
+	}
+
+	/** @brief Draw points seen from above, in the same metric frame and scale than DrawLaserData
+	 *         (sensor at X_CoordonateToPixelCentered(0)/Y_CoordonateToPixelCentered(0), forward to the top).
+	 *
+	 * @param WhereToDraw [in] Drawing cv::Mat (BGR).
+	 * @param Color [in] Color of points (Default = yellow).
+	 * @param MinHeight [in] Points lower than MinHeight meters under the sensor are not drawn (Default = no limit).
+	 * @param MaxHeight [in] Points higher than MaxHeight meters above the sensor are not drawn (Default = no limit).
+	 */
+	void DrawBirdsEye( cv::Mat& WhereToDraw, const cv::Vec3b& Color = cv::Vec3b(0,255,255), float MinHeight = -1.0e6f, float MaxHeight = 1.0e6f ) const;
+
+protected:
+	DepthIntrinsics Intrinsics;		/*!< @brief Parameters of the depth camera */
+	std::vector<float> RayX;		/*!< @brief X of the ray of each pixel at Z = 1 m */
+	std::vector<float> RayY;		/*!< @brief Y of the ray of each pixel at Z = 1 m */
+	std::vector<float> X;			/*!< @brief X of points */
+	std::vector<float> Y;			/*!< @brief Y of points */
+	std::vector<float> Z;			/*!< @brief Z of points */
+};
+
+/**
+ * @class DrawPointCloud DepthPointCloud.cpp DepthPointCloud.h
+ * @brief Class to draw the Kinect2 depth stream as a point cloud seen from above, to be drawn with
+ *        (or without) DrawLaserData.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class DrawPointCloud : public DrawRawData
+{
+public:
+	/** @brief constructor. Draw the point cloud of the depth stream of the Kinect2.
+	 *
+	 * @param Folder [in] Main folder containing the data. Depth data will be search in 'Folder/depth/' subfolder.
+	 * @param Intrinsics [in] Parameters of the depth camera (Default = usual Kinect2 values).
+	 */
+	DrawPointCloud( const std::string& Folder, const DepthIntrinsics& Intrinsics = DepthIntrinsics() )
+		: DrawRawData( Folder + DepthFileName, Folder + RawDepthFileName, DepthWidth*DepthHeight*DepthBytesPerPixel ),
+		  Cloud( Intrinsics )
+	{
+		Color = cv::Vec3b(0,255,255);
+		MinHeight = -1.0e6f;
+		MaxHeight = 1.0e6f;
+	}
+
+	/** @brief Virtual destructor, always.
+	 */
+	virtual ~DrawPointCloud() {}
+
+	/** @brief Set the height band of drawn points, in meters relative to the sensor (e.g. to remove the floor).
+	 *
+	 * @param _MinHeight [in] Lowest drawn height (negative under the sensor).
+	 * @param _MaxHeight [in] Highest drawn height.
+	 */
+	void SetHeightRange( float _MinHeight, float _MaxHeight )
+	{
+		MinHeight = _MinHeight;
+		MaxHeight = _MaxHeight;
+	}
+
+	/** @brief Get the point cloud of the last drawn frame.
+	 */
+	const DepthPointCloud& GetCloud() const
+	{
+		return Cloud;
+	}
+
+	/** @brief ProcessElement is a callback function called by mother classes when data are ready.
+	 *
+	 * @param RequestTimestamp [in] The timestamp of the data.
+	 * @param UserData [in] User pointer to working data. Here a pointer to a cv:Mat to draw in.
+	 */
+	virtual bool ProcessElement( const TimeB &RequestTimestamp, void * UserData = nullptr );
+
+	cv::Vec3b Color;				/*!< @brief Color of points */
+
+protected:
+	DepthPointCloud Cloud;			/*!< @brief Points of the last frame */
+	float MinHeight;				/*!< @brief Lowest drawn height */
+	float MaxHeight;				/*!< @brief Highest drawn height */
+};
+
+}} // namespace MobileRGBD::Kinect2
+
+#endif // KINECT_2
+
+#endif // __DEPTH_POINT_CLOUD_H__
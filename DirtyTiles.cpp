@@ -0,0 +1,172 @@
+/**
+ * @file DirtyTiles.cpp
+ * @ingroup Drawing
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#include "DirtyTiles.h"
+#include "DrawingSimd.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+using namespace MobileRGBD;
+
+/** @brief constructor.
+ *
+ * @param _Width [in] Width of frames.
+ * @param _Height [in] Height of frames.
+ * @param _BytesPerValue [in] Size of raw values, 1 or 2 bytes.
+ * @param _OutputChannels [in] Number of bytes per pixel in the output frame.
+ * @param _Tolerance [in] Maximum difference of a value still considered unchanged (Default = 0).
+ * @param _TileSize [in] Width and height of tiles (Default = 32).
+ */
+DirtyTiles::DirtyTiles( int _Width, int _Height, int _BytesPerValue, int _OutputChannels, int _Tolerance /* = 0 */, int _TileSize /* = 32 */ )
+{
+	Width = _Width;
+	Height = _Height;
+	BytesPerValue = _BytesPerValue == 2 ? 2 : 1;
+	OutputChannels = _OutputChannels;
+	Tolerance = std::max( 0, std::min( _Tolerance, BytesPerValue == 2 ? 65535 : 255 ) );
+	TileSize = _TileSize < 8 ? 8 : _TileSize;
+	TilesX = (Width + TileSize-1)/TileSize;
+	TilesY = (Height + TileSize-1)/TileSize;
+
+	Valid = false;
+	LastFormatKey = 0;
+	Previous.resize( Width*Height*BytesPerValue );
+	Output.resize( Width*Height*OutputChannels );
+	Dirty.resize( TilesX*TilesY );
+
+	LastFraction = 0.0f;
+	SumOfFractions = 0.0;
+	NumberOfFrames = 0;
+}
+
+/** @brief Compare a tile with its last drawn version.
+ *
+ * @return true if at least one value differs by more than Tolerance.
+ */
+bool DirtyTiles::TileChanged( const unsigned char * Frame, int X, int Y, int TileWidth, int TileHeight ) const
+{
+	const int LineSize = Width*BytesPerValue;
+	const int TileLineSize = TileWidth*BytesPerValue;
+
+	for( int line = Y; line < Y+TileHeight; line++ )
+	{
+		const unsigned char * New = Frame + line*LineSize + X*BytesPerValue;
+		const unsigned char * Old = &Previous[line*LineSize + X*BytesPerValue];
+		int Pos = 0;
+
+#ifdef DRAWING_SSE2
+		// |New-Old| > Tolerance on 16 bytes at once (saturated differences)
+		const __m128i Zero = _mm_setzero_si128();
+		if ( BytesPerValue == 2 )
+		{
+			const __m128i Limit = _mm_set1_epi16( (short)Tolerance );
+			for( ; Pos+16 <= TileLineSize; Pos += 16 )
+			{
+				__m128i a = _mm_loadu_si128( (const __m128i*)(New+Pos) );
+				__m128i b = _mm_loadu_si128( (const __m128i*)(Old+Pos) );
+				__m128i Diff = _mm_or_si128( _mm_subs_epu16( a, b ), _mm_subs_epu16( b, a ) );
+				if ( _mm_movemask_epi8( _mm_cmpeq_epi16( _mm_subs_epu16( Diff, Limit ), Zero ) ) != 0xFFFF )
+				{
+					return true;
+				}
+			}
+		}
+		else
+		{
+			const __m128i Limit = _mm_set1_epi8( (char)Tolerance );
+			for( ; Pos+16 <= TileLineSize; Pos += 16 )
+			{
+				__m128i a = _mm_loadu_si128( (const __m128i*)(New+Pos) );
+				__m128i b = _mm_loadu_si128( (const __m128i*)(Old+Pos) );
+				__m128i Diff = _mm_or_si128( _mm_subs_epu8( a, b ), _mm_subs_epu8( b, a ) );
+				if ( _mm_movemask_epi8( _mm_cmpeq_epi8( _mm_subs_epu8( Diff, Limit ), Zero ) ) != 0xFFFF )
+				{
+					return true;
+				}
+			}
+		}
+#endif
+
+		// Remaining values
+		if ( BytesPerValue == 2 )
+		{
+			const unsigned short int * NewValues = (const unsigned short int *)(New+Pos);
+			const unsigned short int * OldValues = (const unsigned short int *)(Old+Pos);
+			for( int i = 0; i < (TileLineSize-Pos)/2; i++ )
+			{
+				if ( abs( (int)NewValues[i] - (int)OldValues[i] ) > Tolerance )
+				{
+					return true;
+				}
+			}
+		}
+		else
+		{
+			for( ; Pos < TileLineSize; Pos++ )
+			{
+				if ( abs( (int)New[Pos] - (int)Old[Pos] ) > Tolerance )
+				{
+					return true;
+				}
+			}
+		}
+	}
+
+	return false;
+}
+
+/** @brief Find changed tiles of a new frame. Changed tiles are kept as last drawn version.
+ *
+ * @param Frame [in] New raw frame.
+ * @param FormatKey [in] Identify the conversion of raw values, all tiles are changed if it differs from the previous one (Default = 0).
+ * @return the number of changed tiles.
+ */
+int DirtyTiles::Update( const void * Frame, long long FormatKey /* = 0 */ )
+{
+	const unsigned char * NewFrame = (const unsigned char *)Frame;
+	const int LineSize = Width*BytesPerValue;
+
+	bool RedrawAll = (Valid == false || FormatKey != LastFormatKey);
+	Valid = true;
+	LastFormatKey = FormatKey;
+
+	int NumberOfDirtyTiles = 0;
+	int RedrawnPixels = 0;
+	for( int ty = 0; ty < TilesY; ty++ )
+	{
+		for( int tx = 0; tx < TilesX; tx++ )
+		{
+			int X = tx*TileSize;
+			int Y = ty*TileSize;
+			int TileWidth = std::min( TileSize, Width-X );
+			int TileHeight = std::min( TileSize, Height-Y );
+
+			bool Changed = RedrawAll || TileChanged( NewFrame, X, Y, TileWidth, TileHeight );
+			Dirty[ty*TilesX + tx] = Changed ? 1 : 0;
+			if ( Changed == false )
+			{
+				continue;
+			}
+
+			// Keep the drawn version of the tile
+			for( int line = Y; line < Y+TileHeight; line++ )
+			{
+				memcpy( &Previous[line*LineSize + X*BytesPerValue], NewFrame + line*LineSize + X*BytesPerValue, TileWidth*BytesPerValue );
+			}
+
+			NumberOfDirtyTiles++;
+			RedrawnPixels += TileWidth*TileHeight;
+		}
+	}
+
+	LastFraction = (float)RedrawnPixels/(float)(Width*Height);
+	SumOfFractions += LastFraction;
+	NumberOfFrames++;
+
+	return NumberOfDirtyTiles;
+}
@@ -0,0 +1,170 @@
+/**
+ * @file DirtyTiles.h
+ * @ingroup Drawing
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __DIRTY_TILES_H__
+#define __DIRTY_TILES_H__
+
+#undef min
+#undef max
+#include <algorithm>
+#include <vector>
+
+namespace MobileRGBD {
+
+/**
+ * @class DirtyTiles DirtyTiles.cpp DirtyTiles.h
+ * @brief Change detection between consecutive raw frames of a stream, tile by tile. Each new frame is
+ *        compared (SSE2 when available) with the last drawn version of each tile; only changed tiles are
+ *        converted again (see FrameKernel::ConvertRect) in a cached output frame. For noisy streams (depth,
+ *        infrared), values within a tolerance are considered unchanged. When the conversion itself changes
+ *        (i.e. a new gamma or color table), a new format key redraws all tiles.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class DirtyTiles
+{
+public:
+	/** @brief constructor.
+	 *
+	 * @param _Width [in] Width of frames.
+	 * @param _Height [in] Height of frames.
+	 * @param _BytesPerValue [in] Size of raw values, 1 or 2 bytes.
+	 * @param _OutputChannels [in] Number of bytes per pixel in the output frame.
+	 * @param _Tolerance [in] Maximum difference of a value still considered unchanged (Default = 0).
+	 * @param _TileSize [in] Width and height of tiles (Default = 32).
+	 */
+	DirtyTiles( int _Width, int _Height, int _BytesPerValue, int _OutputChannels, int _Tolerance = 0, int _TileSize = 32 );
+
+	/** @brief Virtual destructor, always.
+	 */
+	virtual ~DirtyTiles() {}
+
+	/** @brief Is this object configured for these frames?
+	 */
+	bool Matches( int _Width, int _Height, int _BytesPerValue, int _OutputChannels ) const
+	{
+		return Width == _Width && Height == _Height && BytesPerValue == _BytesPerValue && OutputChannels == _OutputChannels;
+	}
+
+	/** @brief Find changed tiles of a new frame. Changed tiles are kept as last drawn version.
+	 *
+	 * @param Frame [in] New raw frame.
+	 * @param FormatKey [in] Identify the conversion of raw values, all tiles are changed if it differs from the previous one (Default = 0).
+	 * @return the number of changed tiles.
+	 */
+	int Update( const void * Frame, long long FormatKey = 0 );
+
+	/** @brief Redraw all tiles at next Update.
+	 */
+	void Invalidate()
+	{
+		Valid = false;
+	}
+
+	/** @brief Is a tile changed in the last Update?
+	 */
+	bool IsDirty( int TileX, int TileY ) const
+	{
+		return Dirty[TileY*TilesX + TileX] != 0;
+	}
+
+	/** @brief Get the fraction of pixels redrawn in the last Update.
+	 */
+	float GetRedrawnFraction() const
+	{
+		return LastFraction;
+	}
+
+	/** @brief Get the average fraction of pixels redrawn since construction.
+	 */
+	float GetAverageRedrawnFraction() const
+	{
+		return NumberOfFrames == 0 ? 0.0f : (float)(SumOfFractions/(double)NumberOfFrames);
+	}
+
+	/** @brief Get the cached output frame.
+	 */
+	unsigned char * GetOutput()
+	{
+		return &Output[0];
+	}
+
+	/** @brief Convert changed tiles of a frame in the cached output frame.
+	 *
+	 * @param Source [in] Raw frame given to the last Update.
+	 * @param Format [in] Source format object.
+	 * @return the cached output frame.
+	 */
+	template<class Kernel, class SourceFormat>
+	unsigned char * Convert( const typename Kernel::SourcePixel * Source, const SourceFormat& Format )
+	{
+		for( int ty = 0; ty < TilesY; ty++ )
+		{
+			for( int tx = 0; tx < TilesX; tx++ )
+			{
+				if ( IsDirty( tx, ty ) )
+				{
+					int X = tx*TileSize;
+					int Y = ty*TileSize;
+					Kernel::ConvertRect( Source, &Output[0], X, Y, std::min( TileSize, Width-X ), std::min( TileSize, Height-Y ), Format );
+				}
+			}
+		}
+
+		return &Output[0];
+	}
+
+	/** @brief Convert a frame, only changed tiles if Tiles is given.
+	 *
+	 * @param Tiles [in] Change detection, nullptr to convert the whole frame.
+	 * @param Source [in] Raw frame (given to the last Update of Tiles).
+	 * @param Output [in] Output buffer used without Tiles.
+	 * @param Format [in] Source format object.
+	 * @return the converted frame (Output or the cached output frame of Tiles).
+	 */
+	template<class Kernel, class SourceFormat>
+	static unsigned char * ConvertFrame( DirtyTiles * Tiles, const typename Kernel::SourcePixel * Source, unsigned char * Output, const SourceFormat& Format )
+	{
+		if ( Tiles == nullptr )
+		{
+			Kernel::Convert( Source, Output, Format );
+			return Output;
+		}
+
+		return Tiles->Convert<Kernel>( Source, Format );
+	}
+
+protected:
+	/** @brief Compare a tile with its last drawn version.
+	 *
+	 * @return true if at least one value differs by more than Tolerance.
+	 */
+	bool TileChanged( const unsigned char * Frame, int X, int Y, int TileWidth, int TileHeight ) const;
+
+	int Width;							/*!< @brief Width of frames */
+	int Height;							/*!< @brief Height of frames */
+	int BytesPerValue;					/*!< @brief Size of raw values */
+	int OutputChannels;					/*!< @brief Bytes per pixel in the output frame */
+	int Tolerance;						/*!< @brief Maximum difference of an unchanged value */
+	int TileSize;						/*!< @brief Width and height of tiles */
+	int TilesX;							/*!< @brief Number of tiles per line */
+	int TilesY;							/*!< @brief Number of tiles per column */
+
+	bool Valid;							/*!< @brief Previous and Output contain a drawn frame */
+	long long LastFormatKey;			/*!< @brief Format key of Output */
+	std::vector<unsigned char> Previous;	/*!< @brief Last drawn version of each tile (raw values) */
+	std::vector<unsigned char> Output;		/*!< @brief Cached output frame */
+	std::vector<unsigned char> Dirty;		/*!< @brief Changed tiles of the last Update */
+
+	float LastFraction;					/*!< @brief Fraction of pixels redrawn in the last Update */
+	double SumOfFractions;				/*!< @brief Sum of redrawn fractions */
+	long long NumberOfFrames;			/*!< @brief Number of Update */
+};
+
+} // namespace MobileRGBD
+
+#endif // __DIRTY_TILES_H__
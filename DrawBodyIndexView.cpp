@@ -6,11 +6,78 @@
  */
 
 #include "DrawBodyIndexView.h"
+#include "DrawDepthView.h"
+
+#undef min
+#undef max
+#include <algorithm>
+#include <string.h>
 
 #ifdef KINECT_2
 
 namespace MobileRGBD { namespace Kinect2 {
 
+namespace {
+
+/**
+ * @struct BodyIndexDrawingSink
+ * @brief Receive decoded runs (see BodyIndexRuns::Decode) and write BGR pixels, one palette lookup per run.
+ */
+struct BodyIndexDrawingSink
+{
+	BodyIndexDrawingSink( unsigned char * _Pos, const BodyIndex8& _Format ) : Pos( _Pos ), Format( _Format ) {}
+
+	/** @brief Write background pixels (black).
+	 */
+	void Background( int Count )
+	{
+		memset( Pos, 0, Count*BGR24::Channels );
+		Pos += Count*BGR24::Channels;
+	}
+
+	/** @brief Write pixels of a body.
+	 */
+	void Run( unsigned char Body, int Count )
+	{
+		BGRPixel Color = Format( Body );
+		for( int i = 0; i < Count; i++ )
+		{
+			BGR24::Write( Pos, Color );
+			Pos += BGR24::Channels;
+		}
+	}
+
+	unsigned char * Pos;				/*!< @brief Next BGR pixel */
+	BodyIndex8 Format;					/*!< @brief Palette */
+};
+
+/**
+ * @struct BodyIndexFrameSink
+ * @brief Receive decoded runs (see BodyIndexRuns::Decode) and write raw body_index values.
+ */
+struct BodyIndexFrameSink
+{
+	/** @brief Write background pixels.
+	 */
+	void Background( int Count )
+	{
+		memset( Pos, BodyIndexRuns::Background, Count );
+		Pos += Count;
+	}
+
+	/** @brief Write pixels of a body.
+	 */
+	void Run( unsigned char Body, int Count )
+	{
+		memset( Pos, Body, Count );
+		Pos += Count;
+	}
+
+	unsigned char * Pos;				/*!< @brief Next value */
+};
+
+} // anonymous namespace
+
 /*!< @brief shared BRG color index for body drawing. First body will always have the sale color, etc. */
 unsigned char DrawBodyIndexView::Colors[6][3] = {
 		{ 255, 0, 0 },
@@ -25,11 +92,28 @@ unsigned char DrawBodyIndexView::Colors[6][3] = {
  *
  * @param Folder [in] Main folder containing the data. Body data will be search in 'Folder/body_index/' subfolder.
  * @param SizeOfFrame [in] Size of each frame. Default value = DepthWidth*DepthHeight (1 byte per pixel).
+ * @param _DrawInDepth [in] Draw in a depth frame or registered in a video frame (see DepthColorRegistration). Default = true.
  */
-DrawBodyIndexView::DrawBodyIndexView( const std::string& Folder, int SizeOfFrame /* = DepthWidth*DepthHeight */ )
-	: DrawRawData( Folder + BodyIndexFileName, Folder + RawBodyIndexFileName, SizeOfFrame )
+DrawBodyIndexView::DrawBodyIndexView( const std::string& _Folder, int SizeOfFrame /* = DepthWidth*DepthHeight */, bool _DrawInDepth /* = true */ )
+	: DrawRawData( _Folder + BodyIndexFileName, _Folder + RawBodyIndexFileName, SizeOfFrame ), Folder( _Folder ), Runs( DepthWidth, DepthHeight )
 {
 	ImageBuffer = new unsigned char[DepthWidth*DepthHeight*3]; // BGR data
+	OpenProxy( Folder + ProxyBodyIndexFileName, ProxyDepthFrameSize, ProxyDepthWidth, ProxyDepthHeight );
+
+	Depth = nullptr;
+	SetDrawInDepth( _DrawInDepth );
+
+	// Read compressed body_index instead of raw file if available
+	Compressed = new IndexedFrameFile( *this, CompressedCompanion, Folder + CompressedBodyIndexFileName, Folder + CompressedBodyIndexIndexFileName );
+	UseCompressed = true;
+	ConvertedFrame = ImageBuffer;
+
+	Analysis = false;
+	DrawAnalysis = false;
+	for( int b = 0; b < BodyIndexRuns::NumberOfBodies; b++ )
+	{
+		Statistics[b].PixelCount = 0;
+	}
 }
 
 /** @brief Virtual destructor, always.
@@ -40,6 +124,65 @@ DrawBodyIndexView::~DrawBodyIndexView()
 	{
 		delete ImageBuffer;
 	}
+	if ( Depth != nullptr )
+	{
+		delete Depth;
+	}
+	delete Compressed;
+}
+
+/** @brief Set if we draw in a depth frame or registered in a video frame. Drawing in a video frame
+ *         reads the depth stream of the recording.
+ *
+ * @param Value [in] Draw in a depth frame or not.
+ */
+void DrawBodyIndexView::SetDrawInDepth( bool Value )
+{
+	DrawInDepth = Value;
+
+	if ( DrawInDepth == false && Depth == nullptr )
+	{
+		// Depth frames are searched on their own timestamps
+		Depth = new CompanionRawData( *this, DepthCompanion, Folder + DepthFileName, Folder + RawDepthFileName, DepthWidth*DepthHeight*DepthBytesPerPixel );
+	}
+}
+
+/** @brief Draw data in image. Read the proxy if it can be used (only in a depth frame without analysis), then the compressed body_index if available, otherwise the raw file.
+ * @param WhereToDraw [in] Drawing cv::Mat.
+ * @param RequestTimestamp [in] Timestamp of the data.
+ */
+bool DrawBodyIndexView::Draw( cv::Mat& WhereToDraw, const TimeB &RequestTimestamp )
+{
+	if ( LiveSource != nullptr )
+	{
+		return DrawLive( WhereToDraw );
+	}
+
+	// Proxy frames can not be registered in a video frame, depth has full resolution. Analysis needs full resolution.
+	if ( DrawInDepth && Analysis == false && CanUseProxy( WhereToDraw ) )
+	{
+		return DrawRawData::Draw( WhereToDraw, RequestTimestamp );
+	}
+
+	if ( Compressed->IsOpen() == false || UseCompressed == false )
+	{
+		return DrawTimestampRawData::Draw( WhereToDraw, RequestTimestamp );
+	}
+
+	DRAWING_STREAM_SCOPE();
+
+	return Compressed->Process( RequestTimestamp, (void*)&WhereToDraw );
+}
+
+/** @brief Write the run length compressed version of the raw body_index file of a recording (see BodyIndexRuns).
+ *
+ * @param Folder [in] Main folder containing the data.
+ * @return true if the compressed file was written.
+ */
+// static
+bool DrawBodyIndexView::Compress( const std::string& Folder )
+{
+	return BodyIndexRuns::ConvertRawFile( Folder + RawBodyIndexFileName, DepthWidth, DepthHeight, Folder + CompressedBodyIndexFileName, Folder + CompressedBodyIndexIndexFileName );
 }
 
 /** @brief ProcessElement is a callback function called by mother classes when data are ready.
@@ -48,46 +191,245 @@ DrawBodyIndexView::~DrawBodyIndexView()
  * @param UserData [in] User pointer to working data. Here a pointer to a cv:Mat to draw in.
  */
 bool DrawBodyIndexView::ProcessElement( const TimeB &RequestTimestamp, void * UserData )
+{
+	DRAWING_FRAME_READ( 1, FrameSize );
+
+	return DrawBodyIndexFrame( (const unsigned char*)FrameBuffer, RequestTimestamp, UserData );
+}
+
+/** @brief Draw a raw body_index frame: convert it, analyse it, then draw it in a depth frame or in a video frame.
+ *
+ * @param Frame [in] Body_index frame (DepthWidth*DepthHeight bytes).
+ * @param RequestTimestamp [in] The timestamp of the data.
+ * @param UserData [in] Pointer to a cv:Mat to draw in.
+ */
+bool DrawBodyIndexView::DrawBodyIndexFrame( const unsigned char * Frame, const TimeB &RequestTimestamp, void * UserData )
+{
+	try
+	{
+
+	DRAWING_STAGE_TIMER( ConversionStage );
+
+	// In dirty tile mode, only changed tiles are converted
+	DirtyTiles * ChangedTiles = GetDirtyTiles( DepthWidth, DepthHeight, 1, BGR24::Channels );
+	if ( ChangedTiles != nullptr )
+	{
+		ChangedTiles->Update( Frame );
+	}
+
+	ConvertedFrame = DirtyTiles::ConvertFrame<Kernel>( ChangedTiles, (const Kernel::SourcePixel*)Frame, ImageBuffer, BodyIndex8(Colors) );
+
+	cv::Mat MatForConversion(DepthHeight, DepthWidth, CV_8UC3, ConvertedFrame );
+
+	DRAWING_STAGE_STOP( ConversionStage );
+
+	if ( Analysis == true )
+	{
+		DRAWING_STAGE_TIMER( OverlayStage );
+
+		// One scan of the frame, statistics and outlines come from the runs
+		Runs.Encode( Frame );
+		Runs.ComputeStatistics( Statistics );
+	}
+
+	return DrawConvertedFrame( MatForConversion, RequestTimestamp, UserData );
+
+	} catch (  cv::Exception )
+	{
+	}
+
+	return true;
+}
+
+/** @brief Draw a converted (BGR) body_index frame in a depth frame or in a video frame, with the analysis overlay.
+ *
+ * @param MatForConversion [in] Converted frame.
+ * @param RequestTimestamp [in] The timestamp of the data.
+ * @param UserData [in] Pointer to a cv:Mat to draw in.
+ */
+bool DrawBodyIndexView::DrawConvertedFrame( cv::Mat& MatForConversion, const TimeB &RequestTimestamp, void * UserData )
 {
 	cv::Mat& WhereToDraw = *((cv::Mat*)UserData);
 
+	if ( DrawInDepth == false )
+	{
+		// Warped with the depth frame in ProcessCompanionElement
+		return Depth->Process( RequestTimestamp, UserData );
+	}
+
 	try
 	{
 
-	char * Table = (char*)FrameBuffer;
-	int PosBuffer = 0;
-	int PosRef =0;
-	cv::Vec3b Pixel;
-	for( int i = 0; i < DepthWidth*DepthHeight; i++, PosBuffer++ )
+	DRAWING_STAGE_TIMER( ResizeStage );
+
+	CopyToFinalSize( MatForConversion, WhereToDraw );
+
+	DRAWING_STAGE_STOP( ResizeStage );
+
+	if ( Analysis == true && DrawAnalysis == true )
+	{
+		// Drawn on WhereToDraw, not in the converted frame kept in dirty tile mode
+		DRAWING_STAGE_TIMER( OverlayStage );
+
+		DrawAnalysisOverlay( WhereToDraw );
+	}
+
+	} catch (  cv::Exception )
 	{
-		if ( Table[PosBuffer] < 0 || Table[PosBuffer] > 5 )
+	}
+
+	return true;
+}
+
+/** @brief Draw bounding boxes and outlines of bodies from Statistics.
+ *
+ * @param WhereToDraw [in] Drawing cv::Mat, containing the depth frame at any size.
+ */
+void DrawBodyIndexView::DrawAnalysisOverlay( cv::Mat& WhereToDraw )
+{
+	const float ScaleX = (float)WhereToDraw.cols/(float)DepthWidth;
+	const float ScaleY = (float)WhereToDraw.rows/(float)DepthHeight;
+
+	for( int b = 0; b < BodyIndexRuns::NumberOfBodies; b++ )
+	{
+		const BodyStatistics& Body = Statistics[b];
+		if ( Body.PixelCount == 0 )
 		{
-			ImageBuffer[PosRef++] = 0;
-			ImageBuffer[PosRef++] = 0;
-			ImageBuffer[PosRef++] = 0;
+			continue;
 		}
-		else
+
+		// Outline pixels in white, each one covers its scaled cell
+		for( size_t p = 0; p < Body.Outline.size(); p++ )
 		{
-			ImageBuffer[PosRef++] = Colors[Table[PosBuffer]][0];
-			ImageBuffer[PosRef++] = Colors[Table[PosBuffer]][1];
-			ImageBuffer[PosRef++] = Colors[Table[PosBuffer]][2];
+			int x1 = (int)(Body.Outline[p].x*ScaleX);
+			int y1 = (int)(Body.Outline[p].y*ScaleY);
+			int x2 = std::max( x1+1, (int)((Body.Outline[p].x+1)*ScaleX) );
+			int y2 = std::max( y1+1, (int)((Body.Outline[p].y+1)*ScaleY) );
+			for( int y = y1; y < y2 && y < WhereToDraw.rows; y++ )
+			{
+				unsigned char * Pixel = WhereToDraw.ptr<unsigned char>(y) + x1*3;
+				for( int x = x1; x < x2 && x < WhereToDraw.cols; x++, Pixel += 3 )
+				{
+					Pixel[0] = Pixel[1] = Pixel[2] = 255;
+				}
+			}
 		}
+
+		cv::Scalar Color( Colors[b][0], Colors[b][1], Colors[b][2] );
+		const cv::Rect& Box = Body.BoundingBox;
+		cv::rectangle( WhereToDraw, cv::Point( (int)(Box.x*ScaleX), (int)(Box.y*ScaleY) ),
+			cv::Point( (int)((Box.x+Box.width)*ScaleX)-1, (int)((Box.y+Box.height)*ScaleY)-1 ), Color, 1 );
+		cv::circle( WhereToDraw, cv::Point( (int)(Body.Centroid.x*ScaleX), (int)(Body.Centroid.y*ScaleY) ), 3, Color, -1 );
 	}
+}
+
+/** @brief ProcessCompanionElement is a callback function called by the proxy or the depth stream when data are ready.
+ *
+ * @param CompanionId [in] Id of the companion (ProxyCompanion or DepthCompanion).
+ * @param Companion [in] The proxy or the depth stream.
+ * @param RequestTimestamp [in] The timestamp of the data.
+ * @param UserData [in] User pointer to working data. Here a pointer to a cv:Mat to draw in.
+ */
+bool DrawBodyIndexView::ProcessCompanionElement( int CompanionId, CompanionRawData& Companion, const TimeB &RequestTimestamp, void * UserData )
+{
+	cv::Mat& WhereToDraw = *((cv::Mat*)UserData);
+
+	if ( CompanionId == DepthCompanion )
+	{
+		// ConvertedFrame (ImageBuffer or the cached frame in dirty tile mode) contains the body index frame drawn before
+		try
+		{
+			DRAWING_STAGE_TIMER( ResizeStage );
 
-	cv::Mat MatForConversion(DepthHeight, DepthWidth, CV_8UC3, ImageBuffer );
+			cv::Mat MatForConversion( DepthHeight, DepthWidth, CV_8UC3, ConvertedFrame );
+			Registration.WarpToColor( MatForConversion, (const unsigned short int *)Companion.GetFrame(), WhereToDraw );
+
+		} catch (  cv::Exception )
+		{
+		}
+
+		return true;
+	}
 
-	// Resize it to finel size
-	if ( MatForConversion.rows != WhereToDraw.rows || MatForConversion.cols != WhereToDraw.cols )
+	if ( CompanionId == CompressedCompanion )
 	{
-		cv::Mat MatForFinal( WhereToDraw.rows, WhereToDraw.cols, CV_8UC3 );
-		cv::resize( MatForConversion, MatForFinal, cv::Size(WhereToDraw.cols,WhereToDraw.rows), 0, 0 );
-		MatForFinal.copyTo( WhereToDraw );
+		IndexedFrameEntry Entry;
+		const unsigned char * Frame = Compressed->ReadFrame( Companion, Entry );
+		if ( Frame == nullptr || Entry.Info != DepthWidth*DepthHeight )
+		{
+			return false;
+		}
+
+		DRAWING_FRAME_READ( 1, Entry.Size );
+
+		if ( UseDirtyTiles )
+		{
+			// Dirty tiles compare raw values
+			DecodedFrame.resize( DepthWidth*DepthHeight );
+			BodyIndexFrameSink Sink;
+			Sink.Pos = &DecodedFrame[0];
+			if ( BodyIndexRuns::Decode( Frame, Entry.Size, DepthWidth*DepthHeight, Sink ) == false )
+			{
+				return false;
+			}
+
+			return DrawBodyIndexFrame( &DecodedFrame[0], RequestTimestamp, UserData );
+		}
+
+		try
+		{
+			DRAWING_STAGE_TIMER( ConversionStage );
+
+			// Expand runs directly to BGR pixels, no intermediate body_index frame
+			BodyIndexDrawingSink Sink( ImageBuffer, BodyIndex8(Colors) );
+			if ( BodyIndexRuns::Decode( Frame, Entry.Size, DepthWidth*DepthHeight, Sink ) == false )
+			{
+				return false;
+			}
+			ConvertedFrame = ImageBuffer;
+
+			cv::Mat MatForConversion( DepthHeight, DepthWidth, CV_8UC3, ImageBuffer );
+
+			DRAWING_STAGE_STOP( ConversionStage );
+
+			if ( Analysis == true )
+			{
+				DRAWING_STAGE_TIMER( OverlayStage );
+
+				// Runs are stored, no scan of the frame
+				Runs.Decompress( Frame, Entry.Size );
+				Runs.ComputeStatistics( Statistics );
+			}
+
+			return DrawConvertedFrame( MatForConversion, RequestTimestamp, UserData );
+
+		} catch (  cv::Exception )
+		{
+		}
+
+		return true;
 	}
-	else
+
+	if ( CompanionId != ProxyCompanion )
 	{
-		MatForConversion.copyTo( WhereToDraw );
+		return false;
 	}
 
+	DRAWING_FRAME_READ( 1, Companion.GetFrameSize() );
+
+	try
+	{
+		DRAWING_STAGE_TIMER( ConversionStage );
+
+		ProxyKernel::Convert( (const ProxyKernel::SourcePixel*)Companion.GetFrame(), ImageBuffer, BodyIndex8(Colors) );
+
+		cv::Mat MatForConversion( ProxyDepthHeight, ProxyDepthWidth, CV_8UC3, ImageBuffer );
+
+		DRAWING_STAGE_STOP( ConversionStage );
+		DRAWING_STAGE_TIMER( ResizeStage );
+
+		CopyToFinalSize( MatForConversion, WhereToDraw );
+
 	} catch (  cv::Exception )
 	{
 	}
@@ -98,6 +440,8 @@ bool DrawBodyIndexView::ProcessElement( const TimeB &RequestTimestamp, void * Us
 // Remove file name defines
 #undef BodyIndexFileName
 #undef RawBodyIndexFileName
+#undef CompressedBodyIndexFileName
+#undef CompressedBodyIndexIndexFileName
 
 }} // namespace MobileRGBD::Kinect2
 
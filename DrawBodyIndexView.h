@@ -11,11 +11,20 @@
 #ifdef KINECT_2
 
 #include "DrawRawData.h"
+#include "ProxyGenerator.h"
+#include "PixelKernels.h"
+#include "DepthColorRegistration.h"
+#include "BodyIndexRuns.h"
+#include "IndexedFrameFile.h"
+
+#include <vector>
 
 namespace MobileRGBD { namespace Kinect2 {
 
 #define BodyIndexFileName "/body_index/body_index.timestamp"	/*!< @brief Timestamp file for the body_index from Kinect2 */
 #define RawBodyIndexFileName "/body_index/body_index.raw"		/*!< @brief Raw file for the body_index from Kinect2 */
+#define CompressedBodyIndexFileName "/body_index/body_index.rle"				/*!< @brief Run length compressed body_index file (see BodyIndexRuns) for Kinect2 */
+#define CompressedBodyIndexIndexFileName "/body_index/body_index.rle.index"	/*!< @brief Index of the compressed body_index file for Kinect2 */
 
 /**
  * @class DrawBodyIndexView DrawBodyIndexView.cpp DrawBodyIndexView.h
@@ -28,17 +37,102 @@ class DrawBodyIndexView : public DrawRawData
 public:
 	static unsigned char Colors[6][3];		/*!< @brief shared BRG color index for body drawing. First body will always have the sale color, etc. */
 
+	typedef FrameKernel<BodyIndex8, BGR24, DepthWidth, DepthHeight> Kernel;				/*!< @brief Kernel drawing raw body_index frames */
+	typedef FrameKernel<BodyIndex8, BGR24, ProxyDepthWidth, ProxyDepthHeight> ProxyKernel;	/*!< @brief Kernel drawing body_index proxy frames */
+
 	/** @brief constructor. Draw data from the Body stream of the Kinect2.
 	 *
 	 * @param Folder [in] Main folder containing the data. Body data will be search in 'Folder/body_index/' subfolder.
 	 * @param SizeOfFrame [in] Size of each frame. Default value = DepthWidth*DepthHeight (1 byte per pixel).
+	 * @param _DrawInDepth [in] Draw in a depth frame or registered in a video frame (see DepthColorRegistration). Default = true.
 	 */
-	DrawBodyIndexView( const std::string& Folder, int SizeOfFrame = DepthWidth*DepthHeight );	// 1 byte per pixel
+	DrawBodyIndexView( const std::string& Folder, int SizeOfFrame = DepthWidth*DepthHeight, bool _DrawInDepth = true );	// 1 byte per pixel
 
 	/** @brief Virtual destructor, always.
 	 */
 	virtual ~DrawBodyIndexView();
 
+	enum { DepthCompanion = 1, CompressedCompanion = 2 };	/*!< @brief Companion ids of the depth stream and of the compressed body_index index in ProcessCompanionElement */
+
+	/** @brief Write the run length compressed version of the raw body_index file of a recording (see BodyIndexRuns).
+	 *
+	 * @param Folder [in] Main folder containing the data.
+	 * @return true if the compressed file was written.
+	 */
+	static bool Compress( const std::string& Folder );
+
+	/** @brief Is the compressed body_index available?
+	 */
+	bool IsCompressedAvailable() const
+	{
+		return Compressed->IsOpen();
+	}
+
+	/** @brief Set if the compressed body_index (if available) must be read instead of the raw file (Default = true).
+	 *
+	 * @param Value [in] Use compressed body_index or not.
+	 */
+	void SetUseCompressed( bool Value )
+	{
+		UseCompressed = Value;
+	}
+
+	/** @brief Set if we draw in a depth frame or registered in a video frame. Drawing in a video frame
+	 *         reads the depth stream of the recording.
+	 *
+	 * @param Value [in] Draw in a depth frame or not.
+	 */
+	void SetDrawInDepth( bool Value );
+
+	/** @brief Get the registration used to draw in a video frame, to change its calibration.
+	 */
+	DepthColorRegistration& GetRegistration()
+	{
+		return Registration;
+	}
+
+	/** @brief Set analysis mode. Each frame is run-length encoded and per-body statistics (pixel count,
+	 *         bounding box, centroid, outline) are computed from the runs. Analysis needs full resolution
+	 *         frames, the proxy is not used.
+	 *
+	 * @param Value [in] Analyse frames or not.
+	 * @param DrawOverlay [in] Draw bounding boxes and outlines over bodies, only in a depth frame (Default = true).
+	 */
+	void SetAnalysis( bool Value, bool DrawOverlay = true )
+	{
+		Analysis = Value;
+		DrawAnalysis = DrawOverlay;
+	}
+
+	/** @brief Get if analysis mode is active.
+	 */
+	bool GetAnalysis() const
+	{
+		return Analysis;
+	}
+
+	/** @brief Get the statistics of a body in the last drawn frame (analysis mode only).
+	 *
+	 * @param Body [in] Body index (0..5).
+	 */
+	const BodyStatistics& GetStatistics( int Body ) const
+	{
+		return Statistics[Body];
+	}
+
+	/** @brief Get the runs of the last drawn frame (analysis mode only).
+	 */
+	const BodyIndexRuns& GetRuns() const
+	{
+		return Runs;
+	}
+
+	/** @brief Draw data in image. Read the proxy if it can be used (only in a depth frame without analysis), then the compressed body_index if available, otherwise the raw file.
+	 * @param WhereToDraw [in] Drawing cv::Mat.
+	 * @param RequestTimestamp [in] Timestamp of the data.
+	 */
+	virtual bool Draw( cv::Mat& WhereToDraw, const TimeB &RequestTimestamp );
+
 	/** @brief ProcessElement is a callback function called by mother classes when data are ready.
 	 *
 	 * @param RequestTimestamp [in] The timestamp of the data.
@@ -46,8 +140,52 @@ public:
 	 */
 	virtual bool ProcessElement( const TimeB &RequestTimestamp, void * UserData = nullptr );
 
+	/** @brief ProcessCompanionElement is a callback function called by the proxy or the depth stream when data are ready.
+	 *
+	 * @param CompanionId [in] Id of the companion (ProxyCompanion, DepthCompanion or CompressedCompanion).
+	 * @param Companion [in] The proxy, the depth stream or the compressed body_index index.
+	 * @param RequestTimestamp [in] The timestamp of the data.
+	 * @param UserData [in] User pointer to working data. Here a pointer to a cv:Mat to draw in.
+	 */
+	virtual bool ProcessCompanionElement( int CompanionId, CompanionRawData& Companion, const TimeB &RequestTimestamp, void * UserData );
+
 protected:
+	/** @brief Draw a raw body_index frame: convert it, analyse it, then draw it in a depth frame or in a video frame.
+	 *
+	 * @param Frame [in] Body_index frame (DepthWidth*DepthHeight bytes).
+	 * @param RequestTimestamp [in] The timestamp of the data.
+	 * @param UserData [in] Pointer to a cv:Mat to draw in.
+	 */
+	bool DrawBodyIndexFrame( const unsigned char * Frame, const TimeB &RequestTimestamp, void * UserData );
+
+	/** @brief Draw a converted (BGR) body_index frame in a depth frame or in a video frame, with the analysis overlay.
+	 *
+	 * @param MatForConversion [in] Converted frame.
+	 * @param RequestTimestamp [in] The timestamp of the data.
+	 * @param UserData [in] Pointer to a cv:Mat to draw in.
+	 */
+	bool DrawConvertedFrame( cv::Mat& MatForConversion, const TimeB &RequestTimestamp, void * UserData );
+
+	/** @brief Draw bounding boxes and outlines of bodies from Statistics.
+	 *
+	 * @param WhereToDraw [in] Drawing cv::Mat, containing the depth frame at any size.
+	 */
+	void DrawAnalysisOverlay( cv::Mat& WhereToDraw );
+
 	unsigned char * ImageBuffer;		/*!< @brief Buffer to work on the data. */
+	std::string Folder;					/*!< @brief Main folder of the recording */
+	bool DrawInDepth;					/*!< @brief Draw in a depth frame or registered in a video frame */
+	CompanionRawData * Depth;			/*!< @brief Depth stream, opened when drawing in a video frame */
+	IndexedFrameFile * Compressed;		/*!< @brief Compressed body_index, if available */
+	bool UseCompressed;					/*!< @brief Read the compressed body_index when available */
+	std::vector<unsigned char> DecodedFrame;	/*!< @brief Compressed frame expanded to raw values (dirty tile mode) */
+	unsigned char * ConvertedFrame;		/*!< @brief Last converted frame, warped with the depth frame in ProcessCompanionElement */
+	DepthColorRegistration Registration;	/*!< @brief Registration with the video frame */
+
+	bool Analysis;						/*!< @brief Analyse frames */
+	bool DrawAnalysis;					/*!< @brief Draw analysis overlay */
+	BodyIndexRuns Runs;					/*!< @brief Runs of the last analysed frame */
+	BodyStatistics Statistics[BodyIndexRuns::NumberOfBodies];	/*!< @brief Statistics of bodies in the last analysed frame */
 };
 
 }} // namespace MobileRGBD::Kinect2
@@ -7,6 +7,9 @@
 
 #include "DrawCameraView.h"
 
+#include <stdio.h>
+#include <string.h>
+
 using namespace cv;
 using namespace std;
 
@@ -23,22 +26,18 @@ bool DrawCameraView::ProcessElement( const TimeB &RequestTimestamp, void * UserD
 {
 	cv::Mat& WhereToDraw = *((cv::Mat*)UserData);
 
+	DRAWING_FRAME_READ( 1, FrameSize );
+	DRAWING_STAGE_TIMER( ConversionStage );
+
 	cv::Mat MatInit( CamHeight, CamWidth, CV_8UC4, FrameBuffer );
-	cv::Mat MatForConversion( CamHeight, CamWidth, CV_8UC3 );
+	cv::Mat& MatForConversion = ConversionImage;	// allocated at first frame
 	// Concert color space (removing alpha channel)
 	cv::cvtColor( MatInit, MatForConversion, CV_BGRA2BGR, 0 );
 
-	// Resize it to final size
-	if ( MatForConversion.rows != WhereToDraw.rows || MatForConversion.cols != WhereToDraw.cols )
-	{
-		cv::Mat MatForFinal( WhereToDraw.rows, WhereToDraw.cols, CV_8UC3 );
-		cv::resize( MatForConversion, MatForFinal, cv::Size(WhereToDraw.cols,WhereToDraw.rows), 0, 0 );
-		MatForFinal.copyTo( WhereToDraw );
-	}
-	else
-	{
-		MatForConversion.copyTo( WhereToDraw );
-	}
+	DRAWING_STAGE_STOP( ConversionStage );
+	DRAWING_STAGE_TIMER( ResizeStage );
+
+	CopyToFinalSize( MatForConversion, WhereToDraw );
 
 	return true;
 }
@@ -51,7 +50,7 @@ bool DrawCameraView::ProcessElement( const TimeB &RequestTimestamp, void * UserD
 
 namespace MobileRGBD { namespace Kinect2 {
 
-/* static */ KinectImageConverter DrawCameraView::ImageConverter;	
+/* static */ thread_local KinectImageConverter DrawCameraView::ImageConverter;	
 
 /** @brief Static function to draw data from RGB raw Kinect buffer.
  *
@@ -59,20 +58,14 @@ namespace MobileRGBD { namespace Kinect2 {
 void DrawCameraView::Draw( cv::Mat& WhereToDraw, void * FrameBuffer, int ScaleFactor )
 {
 	// convert it to BGR
+	DRAWING_STAGE_TIMER( ConversionStage );
 	unsigned char * TmpFrame = ImageConverter.ConvertYVY2ToBRG((unsigned char*)FrameBuffer, Kinect2::CamWidth, Kinect2::CamHeight, ScaleFactor );
 	cv::Mat MatForConversion( Kinect2::CamHeight/ScaleFactor, Kinect2::CamWidth/ScaleFactor, CV_8UC3, TmpFrame );
+	DRAWING_STAGE_STOP( ConversionStage );
 
-	// Resize it to final size
-	if ( MatForConversion.rows != WhereToDraw.rows || MatForConversion.cols != WhereToDraw.cols )
-	{
-		cv::Mat MatForFinal( WhereToDraw.rows, WhereToDraw.cols, CV_8UC3 );
-		cv::resize( MatForConversion, MatForFinal, cv::Size(WhereToDraw.cols,WhereToDraw.rows), 0, 0 );
-		MatForFinal.copyTo( WhereToDraw );   
-	}
-	else
-	{
-		MatForConversion.copyTo( WhereToDraw );
-	}
+	DRAWING_STAGE_TIMER( ResizeStage );
+
+	CopyToFinalSize( MatForConversion, WhereToDraw );
 }
 
 /** @brief ProcessElement is a callback function called by mother classes when data are ready.
@@ -84,6 +77,8 @@ bool DrawCameraView::ProcessElement( const TimeB &RequestTimestamp, void * UserD
 {
 	cv::Mat& WhereToDraw = *((cv::Mat*)UserData);
 
+	DRAWING_FRAME_READ( 1, FrameSize );
+
 	const int ScaleFactor = 2;
 
 	// Draw it
@@ -92,6 +87,184 @@ bool DrawCameraView::ProcessElement( const TimeB &RequestTimestamp, void * UserD
 	return true;
 }
 
+/** @brief Draw data in image. Read the proxy if it can be used, then the compressed video if available, otherwise the raw file.
+ * @param WhereToDraw [in] Drawing cv::Mat.
+ * @param RequestTimestamp [in] Timestamp of the data.
+ */
+bool DrawCameraView::Draw( cv::Mat& WhereToDraw, const TimeB &RequestTimestamp )
+{
+	if ( LiveSource != nullptr )
+	{
+		return DrawLive( WhereToDraw );
+	}
+
+	if ( Compressed->IsOpen() == false || UseCompressed == false || CanUseProxy( WhereToDraw ) )
+	{
+		return DrawRawData::Draw( WhereToDraw, RequestTimestamp );
+	}
+
+	DRAWING_STREAM_SCOPE();
+
+	return Compressed->Process( RequestTimestamp, (void*)&WhereToDraw );
+}
+
+/** @brief Write the compressed version of the raw video file of a recording: each frame is converted
+ *         at half resolution (as drawn from the raw file) and stored as a JPEG image. All frames are
+ *         key frames, so any frame is decoded directly after a seek.
+ *
+ * @param Folder [in] Main folder containing the data.
+ * @param Quality [in] JPEG quality, 0 to 100 (Default = 90).
+ * @return true if the compressed file was written.
+ */
+// static
+bool DrawCameraView::Compress( const std::string& Folder, int Quality /* = 90 */ )
+{
+	const int ScaleFactor = 2;
+	const int FrameSize = CamWidth*CamHeight*CamBytesPerPixel;
+
+	FILE * fin = fopen( (Folder + RawVideoFileName).c_str(), "rb" );
+	if ( fin == nullptr )
+	{
+		return false;
+	}
+
+	IndexedFrameFileWriter Writer;
+	if ( Writer.Open( Folder + CompressedVideoFileName, Folder + CompressedVideoIndexFileName ) == false )
+	{
+		fclose( fin );
+		return false;
+	}
+
+	std::vector<unsigned char> Frame( FrameSize );
+	std::vector<unsigned char> Jpeg;
+	std::vector<int> Params;
+	Params.push_back( cv::IMWRITE_JPEG_QUALITY );
+	Params.push_back( Quality );
+
+	// Frame i of the compressed file is frame i of the raw file, so the timestamp file is valid for both
+	bool Ret = true;
+	while( fread( &Frame[0], FrameSize, 1, fin ) == 1 )
+	{
+		unsigned char * TmpFrame = ImageConverter.ConvertYVY2ToBRG( &Frame[0], CamWidth, CamHeight, ScaleFactor );
+		cv::Mat MatForConversion( CamHeight/ScaleFactor, CamWidth/ScaleFactor, CV_8UC3, TmpFrame );
+
+		// Info = 0: key frame
+		if ( cv::imencode( ".jpg", MatForConversion, Jpeg, Params ) == false || Writer.AddFrame( &Jpeg[0], (int)Jpeg.size(), 0 ) == false )
+		{
+			Ret = false;
+			break;
+		}
+	}
+
+	if ( ferror( fin ) != 0 )
+	{
+		Ret = false;
+	}
+	fclose( fin );
+
+	// Do not leave truncated files
+	return Writer.Close( Ret == false ) && Ret;
+}
+
+/** @brief Get a decoded frame of the compressed video, from the cache or by reading and decoding it.
+ *
+ * @param Entry [in] Index entry of the frame.
+ * @return the decoded frame, empty on error.
+ */
+const cv::Mat& DrawCameraView::GetDecodedFrame( const IndexedFrameEntry& Entry )
+{
+	LastUse++;
+
+	// Search in cache, remember the least recently used entry
+	int Oldest = 0;
+	for( int i = 0; i < DecodedCacheSize; i++ )
+	{
+		if ( DecodedCache[i].Offset == Entry.Offset )
+		{
+			DecodedCache[i].Use = LastUse;
+			return DecodedCache[i].Frame;
+		}
+		if ( DecodedCache[i].Use < DecodedCache[Oldest].Use )
+		{
+			Oldest = i;
+		}
+	}
+
+	const unsigned char * Jpeg = Compressed->ReadFrame( Entry );
+	if ( Jpeg == nullptr )
+	{
+		return EmptyFrame;
+	}
+
+	// Decode in the oldest entry (its buffer is reused)
+	DecodedFrame& Decoded = DecodedCache[Oldest];
+	Decoded.Offset = -1;
+	cv::Mat JpegData( 1, Entry.Size, CV_8UC1, (void*)Jpeg );
+	cv::imdecode( JpegData, cv::IMREAD_COLOR, &Decoded.Frame );
+	if ( Decoded.Frame.empty() )
+	{
+		return EmptyFrame;
+	}
+
+	Decoded.Offset = Entry.Offset;
+	Decoded.Use = LastUse;
+
+	return Decoded.Frame;
+}
+
+/** @brief ProcessCompanionElement is a callback function called by the proxy stream or the compressed video index when data are ready.
+ *
+ * @param CompanionId [in] Id of the companion (ProxyCompanion or CompressedCompanion).
+ * @param Companion [in] The proxy stream or the compressed video index.
+ * @param RequestTimestamp [in] The timestamp of the data.
+ * @param UserData [in] User pointer to working data. Here a pointer to a cv:Mat to draw in.
+ */
+bool DrawCameraView::ProcessCompanionElement( int CompanionId, CompanionRawData& Companion, const TimeB &RequestTimestamp, void * UserData )
+{
+	cv::Mat& WhereToDraw = *((cv::Mat*)UserData);
+
+	if ( CompanionId == CompressedCompanion )
+	{
+		IndexedFrameEntry Entry;
+		memcpy( &Entry, Companion.GetFrame(), sizeof(Entry) );
+
+		DRAWING_FRAME_READ( 1, Entry.Size );
+		DRAWING_STAGE_TIMER( ConversionStage );
+		const cv::Mat& MatForConversion = GetDecodedFrame( Entry );
+		DRAWING_STAGE_STOP( ConversionStage );
+
+		if ( MatForConversion.empty() )
+		{
+			return false;
+		}
+
+		DRAWING_STAGE_TIMER( ResizeStage );
+
+		CopyToFinalSize( MatForConversion, WhereToDraw );
+
+		return true;
+	}
+
+	if ( CompanionId != ProxyCompanion )
+	{
+		return false;
+	}
+
+	DRAWING_FRAME_READ( 1, Companion.GetFrameSize() );
+
+	// Proxy is still YUY2, at 1/4 resolution: convert it without scaling
+	DRAWING_STAGE_TIMER( ConversionStage );
+	unsigned char * TmpFrame = ImageConverter.ConvertYVY2ToBRG((unsigned char*)Companion.GetFrame(), ProxyCamWidth, ProxyCamHeight, 1 );
+	cv::Mat MatForConversion( ProxyCamHeight, ProxyCamWidth, CV_8UC3, TmpFrame );
+	DRAWING_STAGE_STOP( ConversionStage );
+
+	DRAWING_STAGE_TIMER( ResizeStage );
+
+	CopyToFinalSize( MatForConversion, WhereToDraw );
+
+	return true;
+}
+
 }} // namespace MobileRGBD::Kinect2
 
 #endif
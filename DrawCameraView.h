@@ -12,6 +12,8 @@
 
 #define VideoFileName "/video/video.timestamp"	/*!< @brief Timestamp file for the video input from Kinect1 or Kinect2 */
 #define RawVideoFileName "/video/video.raw"		/*!< @brief Raw file for the video input from Kinect1 or Kinect2  */
+#define CompressedVideoFileName "/video/video.mjpeg"				/*!< @brief Compressed video file (JPEG frames) for Kinect2 */
+#define CompressedVideoIndexFileName "/video/video.mjpeg.index"	/*!< @brief Index of the compressed video file for Kinect2 */
 
 #ifdef KINECT_1
 
@@ -48,6 +50,9 @@ public:
 	 * @param UserData [in] User pointer to working data. Here a pointer to a cv:Mat to draw in.
 	 */
 	virtual bool ProcessElement( const TimeB &RequestTimestamp, void * UserData = nullptr );
+
+protected:
+	cv::Mat ConversionImage;		/*!< @brief BGR image converted from BGRA, kept to be reused. */
 };
 
 }} // namesapce MobileRGBD::Kinect1
@@ -57,6 +62,8 @@ public:
 #ifdef KINECT_2
 
 #include "../Kinect/KinectImageConverter.h"
+#include "ProxyGenerator.h"
+#include "IndexedFrameFile.h"
 
 namespace MobileRGBD { namespace Kinect2 {
 
@@ -78,17 +85,61 @@ public:
 		: DrawRawData( Folder + VideoFileName, Folder + RawVideoFileName, SizeOfFrame )
 	{
 		StartingFrame = 0;
+		OpenProxy( Folder + ProxyVideoFileName, ProxyCamFrameSize, ProxyCamWidth, ProxyCamHeight );
+
+		// Read compressed video instead of raw file if available
+		Compressed = new IndexedFrameFile( *this, CompressedCompanion, Folder + CompressedVideoFileName, Folder + CompressedVideoIndexFileName );
+		UseCompressed = true;
+		LastUse = 0;
 	}
 
 	/** @brief Virtual destructor, always.
 	 */
-	~DrawCameraView() {};
+	~DrawCameraView()
+	{
+		delete Compressed;
+	};
 
 	/** @brief Static function to draw data from RGB raw Kinect buffer.
 	 *
 	 */
 	static void Draw( cv::Mat& WhereToDraw, void * FrameBuffer, int ScaleFactor );
 
+	/** @brief Draw data in image. Read the proxy if it can be used, then the compressed video if available, otherwise the raw file.
+	 * @param WhereToDraw [in] Drawing cv::Mat.
+	 * @param RequestTimestamp [in] Timestamp of the data.
+	 */
+	virtual bool Draw( cv::Mat& WhereToDraw, const TimeB &RequestTimestamp );
+
+	/** @brief Write the compressed version of the raw video file of a recording: each frame is converted
+	 *         at half resolution (as drawn from the raw file) and stored as a JPEG image. All frames are
+	 *         key frames, so any frame is decoded directly after a seek.
+	 *
+	 * @param Folder [in] Main folder containing the data.
+	 * @param Quality [in] JPEG quality, 0 to 100 (Default = 90).
+	 * @return true if the compressed file was written.
+	 */
+	static bool Compress( const std::string& Folder, int Quality = 90 );
+
+	enum { CompressedCompanion = 1 };	/*!< @brief Companion id of the compressed video index in ProcessCompanionElement */
+	enum { DecodedCacheSize = 8 };		/*!< @brief Number of decoded frames kept in cache */
+
+	/** @brief Is the compressed video available?
+	 */
+	bool IsCompressedAvailable() const
+	{
+		return Compressed->IsOpen();
+	}
+
+	/** @brief Set if the compressed video (if available) must be read instead of the raw file (Default = true).
+	 *
+	 * @param Value [in] Use compressed video or not.
+	 */
+	void SetUseCompressed( bool Value )
+	{
+		UseCompressed = Value;
+	}
+
 	/** @brief ProcessElement is a callback function called by mother classes when data are ready.
 	 *
 	 * @param RequestTimestamp [in] The timestamp of the data.
@@ -96,8 +147,43 @@ public:
 	 */
 	virtual bool ProcessElement( const TimeB &RequestTimestamp, void * UserData = nullptr );
 
+	/** @brief ProcessCompanionElement is a callback function called by the proxy stream or the compressed video index when data are ready.
+	 *
+	 * @param CompanionId [in] Id of the companion (ProxyCompanion or CompressedCompanion).
+	 * @param Companion [in] The proxy stream or the compressed video index.
+	 * @param RequestTimestamp [in] The timestamp of the data.
+	 * @param UserData [in] User pointer to working data. Here a pointer to a cv:Mat to draw in.
+	 */
+	virtual bool ProcessCompanionElement( int CompanionId, CompanionRawData& Companion, const TimeB &RequestTimestamp, void * UserData );
+
 protected:
-	static KinectImageConverter ImageConverter;		/*!< @brief Converter for the Kinect2 raw YVY2 to BRG */
+	/** @brief Get a decoded frame of the compressed video, from the cache or by reading and decoding it.
+	 *
+	 * @param Entry [in] Index entry of the frame.
+	 * @return the decoded frame, empty on error.
+	 */
+	const cv::Mat& GetDecodedFrame( const IndexedFrameEntry& Entry );
+
+	/**
+	 * @struct DecodedFrame
+	 * @brief A decoded frame of the compressed video.
+	 */
+	struct DecodedFrame
+	{
+		long long Offset;			/*!< @brief Offset of the frame in the compressed file (-1 if empty) */
+		unsigned long long Use;		/*!< @brief Last use of this entry */
+		cv::Mat Frame;				/*!< @brief Decoded BGR frame */
+
+		DecodedFrame() : Offset(-1), Use(0) {}
+	};
+
+	static thread_local KinectImageConverter ImageConverter;	/*!< @brief Converter for the Kinect2 raw YVY2 to BRG (one per thread, its buffer is the conversion output) */
+
+	IndexedFrameFile * Compressed;						/*!< @brief Compressed video, if available */
+	bool UseCompressed;									/*!< @brief Read the compressed video when available */
+	DecodedFrame DecodedCache[DecodedCacheSize];		/*!< @brief Recently decoded frames (scrubbing back and forth, same frame drawn several times) */
+	unsigned long long LastUse;							/*!< @brief Use counter for the cache */
+	cv::Mat EmptyFrame;									/*!< @brief Returned on decoding error */
 };
 
 }} // namesapce MobileRGBD::Kinect2
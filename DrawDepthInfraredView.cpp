@@ -0,0 +1,152 @@
+/**
+ * @file DrawDepthInfraredView.cpp
+ * @ingroup Drawing Kinect
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#include "DrawDepthInfraredView.h"
+#include "DrawRawData.h"
+
+#ifdef KINECT_2
+
+#if defined WIN32 || defined WIN64
+	#define fseek64 _fseeki64
+#else
+	#define fseek64 fseeko
+#endif
+
+namespace MobileRGBD { namespace Kinect2 {
+
+/** @brief constructor. Draw data from the depth and infrared streams of the Kinect2.
+ *
+ * @param Folder [in] Main folder containing the data. Data will be search in 'Folder/depth/' and 'Folder/infrared/' subfolders.
+ */
+DrawDepthInfraredView::DrawDepthInfraredView( const std::string& Folder )
+	: Drawable()
+	DRAWING_STATS_INIT( Folder + DepthFileName ),
+	DepthFrames( Folder + DepthFileName ), InfraredFrames( Folder + InfraredFileName ), DepthCursor( DepthFrames ), InfraredCursor( InfraredFrames )
+{
+	// Same timestamps for each frame: infrared frame i goes with depth frame i
+	SharedTimestamps = DepthFrames.GetNumberOfEntries() == InfraredFrames.GetNumberOfEntries();
+	for( int i = 0; SharedTimestamps && i < DepthFrames.GetNumberOfEntries(); i++ )
+	{
+		SharedTimestamps = DepthFrames.GetMilliseconds( i ) == InfraredFrames.GetMilliseconds( i );
+	}
+	if ( SharedTimestamps )
+	{
+		// Not searched
+		InfraredFrames = TimestampIndex();
+	}
+
+	DepthRaw = fopen( (Folder + RawDepthFileName).c_str(), "rb" );
+	InfraredRaw = fopen( (Folder + RawInfraredFileName).c_str(), "rb" );
+	DepthEntry = -1;
+	InfraredEntry = -1;
+
+	DepthFrame.resize( DepthWidth*DepthHeight );
+	InfraredFrame.resize( InfraredWidth*InfraredHeight );
+	ImageBuffer = new unsigned char[Kernel::OutputFrameSize]; // BGR data
+}
+
+/** @brief Virtual destructor, always.
+ */
+DrawDepthInfraredView::~DrawDepthInfraredView()
+{
+	if ( DepthRaw != nullptr )
+	{
+		fclose( DepthRaw );
+	}
+	if ( InfraredRaw != nullptr )
+	{
+		fclose( InfraredRaw );
+	}
+	delete [] ImageBuffer;
+}
+
+/** @brief Read a frame of a raw file.
+ *
+ * @param Raw [in] Raw file.
+ * @param Entry [in] Index of the frame.
+ * @param Frame [out] Frame (DepthWidth*DepthHeight values).
+ * @return true if the frame was read.
+ */
+// static
+bool DrawDepthInfraredView::ReadFrame( FILE * Raw, int Entry, unsigned short int * Frame )
+{
+	const long long FrameSize = DepthWidth*DepthHeight*DepthBytesPerPixel;
+
+	return fseek64( Raw, (long long)Entry*FrameSize, SEEK_SET ) == 0 && fread( Frame, (size_t)FrameSize, 1, Raw ) == 1;
+}
+
+/** @brief Draw depth and infrared side by side in image.
+ * @param WhereToDraw [in] Drawing cv::Mat, containing both frames (i.e. 2*DepthWidth x DepthHeight).
+ * @param RequestTimestamp [in] Timestamp of the data.
+ */
+bool DrawDepthInfraredView::Draw( cv::Mat& WhereToDraw, const TimeB &RequestTimestamp )
+{
+	if ( IsOpen() == false )
+	{
+		return false;
+	}
+
+	DRAWING_STREAM_SCOPE();
+
+	long long RequestMilliseconds = TimestampIndex::TimestampToMilliseconds( RequestTimestamp );
+
+	int NewDepthEntry = DepthCursor.SearchNearest( RequestMilliseconds );
+	int NewInfraredEntry = SharedTimestamps ? NewDepthEntry : InfraredCursor.SearchNearest( RequestMilliseconds );
+	if ( NewDepthEntry < 0 || NewInfraredEntry < 0 )
+	{
+		return false;
+	}
+
+	if ( NewDepthEntry != DepthEntry || NewInfraredEntry != InfraredEntry )
+	{
+		DRAWING_FRAME_READ( 2, DepthWidth*DepthHeight*DepthBytesPerPixel + InfraredWidth*InfraredHeight*InfraredBytesPerPixel );
+
+		{
+			DRAWING_STAGE_TIMER( FetchStage );
+
+			// Only changed frames are read
+			if ( (NewDepthEntry != DepthEntry && ReadFrame( DepthRaw, NewDepthEntry, &DepthFrame[0] ) == false) ||
+				 (NewInfraredEntry != InfraredEntry && ReadFrame( InfraredRaw, NewInfraredEntry, &InfraredFrame[0] ) == false) )
+			{
+				DepthEntry = -1;
+				InfraredEntry = -1;
+				return false;
+			}
+		}
+
+		DRAWING_STAGE_TIMER( ConversionStage );
+
+		Kernel::Convert( &DepthFrame[0], &InfraredFrame[0], ImageBuffer );
+
+		DepthEntry = NewDepthEntry;
+		InfraredEntry = NewInfraredEntry;
+	}
+
+	try
+	{
+		DRAWING_STAGE_TIMER( ResizeStage );
+
+		cv::Mat MatForConversion = Kernel::Wrap( ImageBuffer );
+		if ( MatForConversion.rows != WhereToDraw.rows || MatForConversion.cols != WhereToDraw.cols )
+		{
+			cv::resize( MatForConversion, WhereToDraw, cv::Size(WhereToDraw.cols,WhereToDraw.rows), 0, 0 );
+		}
+		else
+		{
+			MatForConversion.copyTo( WhereToDraw );
+		}
+
+	} catch (  cv::Exception )
+	{
+	}
+
+	return true;
+}
+
+}} // namespace MobileRGBD::Kinect2
+
+#endif // KINECT_2
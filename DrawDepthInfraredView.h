@@ -0,0 +1,103 @@
+/**
+ * @file DrawDepthInfraredView.h
+ * @ingroup Drawing Kinect
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __DRAW_DEPTH_INFRARED_VIEW_H__
+#define __DRAW_DEPTH_INFRARED_VIEW_H__
+
+#ifdef KINECT_2
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "Drawable.h"
+#include "DrawDepthView.h"
+#include "DrawInfraredView.h"
+#include "PixelKernels.h"
+#include "TimestampIndex.h"
+
+namespace MobileRGBD { namespace Kinect2 {
+
+/**
+ * @class DrawDepthInfraredView DrawDepthInfraredView.cpp DrawDepthInfraredView.h
+ * @brief Draw the depth and infrared streams of the Kinect2 side by side (depth on the left). Both streams
+ *        are captured together with the same resolution: when their timestamp files are identical, the
+ *        infrared frame is the frame with the same index as the depth one, found with one search in the
+ *        depth timestamps (otherwise each stream has its own search). Both frames are read directly from
+ *        the raw files and converted in a single pass (see PairKernel). When the found frames are the
+ *        ones of the previous call, nothing is read nor converted.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class DrawDepthInfraredView : public Drawable
+{
+public:
+	typedef PairKernel<DepthGamma16, InfraredGamma16, BGR24, DepthWidth, DepthHeight> Kernel;	/*!< @brief Kernel drawing depth and infrared frames side by side */
+
+	/** @brief constructor. Draw data from the depth and infrared streams of the Kinect2.
+	 *
+	 * @param Folder [in] Main folder containing the data. Data will be search in 'Folder/depth/' and 'Folder/infrared/' subfolders.
+	 */
+	DrawDepthInfraredView( const std::string& Folder );
+
+	/** @brief Virtual destructor, always.
+	 */
+	virtual ~DrawDepthInfraredView();
+
+	/** @brief Are both streams available?
+	 */
+	bool IsOpen() const
+	{
+		return DepthRaw != nullptr && InfraredRaw != nullptr;
+	}
+
+	/** @brief Do both streams have the same timestamps (one search for both frames)?
+	 */
+	bool AreTimestampsShared() const
+	{
+		return SharedTimestamps;
+	}
+
+	/** @brief Draw depth and infrared side by side in image.
+	 * @param WhereToDraw [in] Drawing cv::Mat, containing both frames (i.e. 2*DepthWidth x DepthHeight).
+	 * @param RequestTimestamp [in] Timestamp of the data.
+	 */
+	virtual bool Draw( cv::Mat& WhereToDraw, const TimeB &RequestTimestamp );
+
+	DRAWING_STATS_MEMBER	/*!< @brief Timing statistics (DRAWING_PROFILING) and trace name (DRAWING_TRACING) of this view */
+
+protected:
+	/** @brief Read a frame of a raw file.
+	 *
+	 * @param Raw [in] Raw file.
+	 * @param Entry [in] Index of the frame.
+	 * @param Frame [out] Frame (DepthWidth*DepthHeight values).
+	 * @return true if the frame was read.
+	 */
+	static bool ReadFrame( FILE * Raw, int Entry, unsigned short int * Frame );
+
+	TimestampIndex DepthFrames;				/*!< @brief Timestamps of depth frames */
+	TimestampIndex InfraredFrames;			/*!< @brief Timestamps of infrared frames, empty when shared with depth */
+	TimestampCursor DepthCursor;			/*!< @brief Search in depth timestamps */
+	TimestampCursor InfraredCursor;			/*!< @brief Search in infrared timestamps, when not shared */
+	bool SharedTimestamps;					/*!< @brief Both streams have the same timestamps */
+
+	FILE * DepthRaw;						/*!< @brief Raw depth file */
+	FILE * InfraredRaw;						/*!< @brief Raw infrared file */
+	int DepthEntry;							/*!< @brief Depth frame in ImageBuffer, -1 if none */
+	int InfraredEntry;						/*!< @brief Infrared frame in ImageBuffer, -1 if none */
+
+	std::vector<unsigned short int> DepthFrame;		/*!< @brief Last read depth frame */
+	std::vector<unsigned short int> InfraredFrame;	/*!< @brief Last read infrared frame */
+	unsigned char * ImageBuffer;			/*!< @brief Both frames converted side by side */
+};
+
+}} // namespace MobileRGBD::Kinect2
+
+#endif // KINECT_2
+
+#endif // __DRAW_DEPTH_INFRARED_VIEW_H__
@@ -23,8 +23,12 @@ bool DrawDepthView::ProcessElement( const TimeB &RequestTimestamp, void * UserDa
 {
 	cv::Mat& WhereToDraw = *((cv::Mat*)UserData);
 
+	DRAWING_FRAME_READ( 1, FrameSize );
+
 	try
 	{
+		DRAWING_STAGE_TIMER( ConversionStage );
+
 		ushort * ImageBuffer2 = (ushort*)FrameBuffer;
 	
 		// Remove player detection information (cause noisy depth)
@@ -39,25 +43,19 @@ bool DrawDepthView::ProcessElement( const TimeB &RequestTimestamp, void * UserDa
 		}
 
 		cv::Mat MatInit( 480, 640, CV_16UC1, FrameBuffer );
-		cv::Mat MatScaled( 480, 640, CV_8UC1 );
-		cv::Mat MatForConversion( 480, 640, CV_8UC3 );
+		// Kept from frame to frame, allocated at first use
+		static thread_local cv::Mat MatScaled( 480, 640, CV_8UC1 );
+		static thread_local cv::Mat MatForConversion( 480, 640, CV_8UC3 );
 
 		MatInit.convertTo( MatScaled, 1.0/16.0, 0.0 );
 
 		// Concert color space
 		cvtColor( MatScaled, MatForConversion, CV_GRAY2BGR, 0 );
 
-		// Resize it to finel size
-		if ( MatForConversion.rows != WhereToDraw.rows || MatForConversion.cols != WhereToDraw.cols )
-		{
-			cv::Mat MatForFinal( WhereToDraw.rows, WhereToDraw.cols, CV_8UC3 );
-			cv::resize( MatForConversion, MatForFinal, cv::Size(WhereToDraw.cols,WhereToDraw.rows), 0, 0 );
-			MatForFinal.copyTo( WhereToDraw );
-		}
-		else
-		{
-			MatForConversion.copyTo( WhereToDraw );
-		}
+		DRAWING_STAGE_STOP( ConversionStage );
+		DRAWING_STAGE_TIMER( ResizeStage );
+
+		CopyToFinalSize( MatForConversion, WhereToDraw );
 
 	} catch (  cv::Exception )
 	{
@@ -74,22 +72,59 @@ bool DrawDepthView::ProcessElement( const TimeB &RequestTimestamp, void * UserDa
 
 #ifdef KINECT_2
 
-#include <System/TypedMemoryBuffer.h>
+#include <string.h>
+#include <vector>
+
+#include "RvlCodec.h"
 
 namespace MobileRGBD { namespace Kinect2 {
 
+namespace {
+
+/**
+ * @struct DepthDrawingSink
+ * @brief Receive decoded depth values (see RvlCodec::Decode) and write BGR pixels.
+ */
+template<class SourceFormat>
+struct DepthDrawingSink
+{
+	DepthDrawingSink( unsigned char * _Pos, const SourceFormat& _Format ) : Pos( _Pos ), Format( _Format ) {}
+
+	/** @brief Write a run of zeros (no depth).
+	 */
+	void Zeros( int Count )
+	{
+		memset( Pos, 0, Count*3 );
+		Pos += Count*3;
+	}
+
+	/** @brief Write a pixel.
+	 */
+	void Value( unsigned short int Depth )
+	{
+		BGR24::Write( Pos, Format( Depth ) );
+		Pos += BGR24::Channels;
+	}
+
+	unsigned char * Pos;				/*!< @brief Next BGR pixel */
+	SourceFormat Format;				/*!< @brief Color of depth values */
+};
+
+} // anonymous namespace
+
 
 
 void DrawDepthView::Draw( cv::Mat& WhereToDraw, void * FrameBuffer, void * DrawingBuffer /* = nullptr */ )
 {
 	try
 	{
-		Omiscid::TypedMemoryBuffer<unsigned char> TempBuff;
+		// Scratch buffer of the thread when no buffer is given, allocated at first use
+		static thread_local std::vector<unsigned char> TempBuff;
 		unsigned char * ImageBuffer;
 		if ( DrawingBuffer == nullptr )
 		{
-			TempBuff.SetNewNumberOfElementsInBuffer(DepthWidth*DepthHeight*3); // RGB
-			ImageBuffer = TempBuff;
+			TempBuff.resize(Kernel::OutputFrameSize); // RGB
+			ImageBuffer = &TempBuff[0];
 		}
 		else
 		{
@@ -97,50 +132,16 @@ void DrawDepthView::Draw( cv::Mat& WhereToDraw, void * FrameBuffer, void * Drawi
 		}
 
 
-		unsigned short int * Table = (unsigned short int*)FrameBuffer;
-		int PosBuffer = 0;
-		int PosRef = 0;
+		DRAWING_STAGE_TIMER( ConversionStage );
 
-		for( int i = 0; i < DepthWidth*DepthHeight; i++, PosBuffer++ )
-		{
-			if ( Table[PosBuffer] == 0 )
-			{
-				ImageBuffer[PosRef++] = 0;
-				ImageBuffer[PosRef++] = 0;
-				ImageBuffer[PosRef++] = 0;
-			}
-			else
-			{
-				float originalBrightnessValue = ((float)Table[PosBuffer])/(65536.f);
- 
-				float amplication=1.0f;
-				float gamma = .32f;
- 
-				// this is where the gamma and amplification levels get applied
-				float gammaAppliedValue = amplication*pow(originalBrightnessValue, gamma);
- 
-				// here we convert it to the desired 0 - 255 range for a byte
-				uchar intensity = (uchar)(std::min((float)gammaAppliedValue, 1.0f)*255.0f);
- 
-				ImageBuffer[PosRef++] = intensity;
-				ImageBuffer[PosRef++] = intensity;
-				ImageBuffer[PosRef++] = intensity;
-			}
-		}
+		Kernel::Convert( (const Kernel::SourcePixel*)FrameBuffer, ImageBuffer );
 
 		cv::Mat MatForConversion(DepthHeight, DepthWidth, CV_8UC3, ImageBuffer );
 
-		// Resize it to finel size
-		if ( MatForConversion.rows != WhereToDraw.rows || MatForConversion.cols != WhereToDraw.cols )
-		{
-			cv::Mat MatForFinal( WhereToDraw.rows, WhereToDraw.cols, CV_8UC3 );
-			cv::resize( MatForConversion, MatForFinal, cv::Size(WhereToDraw.cols,WhereToDraw.rows), 0, 0 );
-			MatForFinal.copyTo( WhereToDraw );
-		}
-		else
-		{
-			MatForConversion.copyTo( WhereToDraw );
-	}
+		DRAWING_STAGE_STOP( ConversionStage );
+		DRAWING_STAGE_TIMER( ResizeStage );
+
+		CopyToFinalSize( MatForConversion, WhereToDraw );
 
 	} catch (  cv::Exception )
 	{
@@ -156,11 +157,215 @@ bool DrawDepthView::ProcessElement( const TimeB &RequestTimestamp, void * UserDa
 {
 	cv::Mat& WhereToDraw = *((cv::Mat*)UserData);
 
+	DRAWING_FRAME_READ( 1, FrameSize );
+
+	if ( DrawInDepth == false || AutoRange || UseColorMap || UseDirtyTiles )
+	{
+		DrawDepthFrame( (const unsigned short int *)FrameBuffer, WhereToDraw );
+		return true;
+	}
+
 	Draw(WhereToDraw, FrameBuffer, ImageBuffer);
 	
 	return true;
 }
 
+/** @brief Draw a depth frame, in a depth frame or registered in a video frame, with fixed or auto range.
+ *
+ * @param DepthFrame [in] Depth frame.
+ * @param WhereToDraw [in] Drawing cv::Mat.
+ */
+void DrawDepthView::DrawDepthFrame( const unsigned short int * DepthFrame, cv::Mat& WhereToDraw )
+{
+	try
+	{
+		DRAWING_STAGE_TIMER( ConversionStage );
+
+		if ( AutoRange )
+		{
+			// Tables are rebuilt only when the range moves
+			Range.Update( DepthFrame, DepthWidth, DepthHeight );
+			if ( UseColorMap )
+			{
+				Colors.SetRange( Colors.GetPalette(), Range.GetLow(), Range.GetHigh() );
+			}
+		}
+
+		// In dirty tile mode, only changed tiles are converted, all of them if the table changed
+		DirtyTiles * ChangedTiles = GetDirtyTiles( DepthWidth, DepthHeight, DepthBytesPerPixel, BGR24::Channels );
+		if ( ChangedTiles != nullptr )
+		{
+			long long FormatKey = UseColorMap ? (long long)Colors.GetVersion()*4+1 : (AutoRange ? (long long)Range.GetVersion()*4+2 : 0);
+			ChangedTiles->Update( DepthFrame, FormatKey );
+		}
+
+		unsigned char * Converted;
+		if ( UseColorMap )
+		{
+			Converted = DirtyTiles::ConvertFrame<ColorKernel>( ChangedTiles, DepthFrame, ImageBuffer, DepthColor16( Colors.GetTable() ) );
+		}
+		else if ( AutoRange )
+		{
+			Converted = DirtyTiles::ConvertFrame<Kernel>( ChangedTiles, DepthFrame, ImageBuffer, DepthGamma16( Range.GetTable() ) );
+		}
+		else
+		{
+			Converted = DirtyTiles::ConvertFrame<Kernel>( ChangedTiles, DepthFrame, ImageBuffer, DepthGamma16() );
+		}
+		cv::Mat MatForConversion( DepthHeight, DepthWidth, CV_8UC3, Converted );
+
+		DRAWING_STAGE_STOP( ConversionStage );
+		DRAWING_STAGE_TIMER( ResizeStage );
+
+		if ( DrawInDepth )
+		{
+			CopyToFinalSize( MatForConversion, WhereToDraw );
+		}
+		else
+		{
+			Registration.WarpToColor( MatForConversion, DepthFrame, WhereToDraw );
+		}
+
+	} catch (  cv::Exception )
+	{
+	}
+}
+
+/** @brief Draw data in image. Read the proxy if it can be used, then the compressed depth if available, otherwise the raw file.
+ * @param WhereToDraw [in] Drawing cv::Mat.
+ * @param RequestTimestamp [in] Timestamp of the data.
+ */
+bool DrawDepthView::Draw( cv::Mat& WhereToDraw, const TimeB &RequestTimestamp )
+{
+	if ( LiveSource != nullptr )
+	{
+		return DrawLive( WhereToDraw );
+	}
+
+	// Proxy frames have no depth values, they can not be registered in a video frame nor give the auto range
+	if ( DrawInDepth && AutoRange == false && UseColorMap == false && CanUseProxy( WhereToDraw ) )
+	{
+		return DrawRawData::Draw( WhereToDraw, RequestTimestamp );
+	}
+
+	if ( Compressed->IsOpen() == false || UseCompressed == false )
+	{
+		return DrawTimestampRawData::Draw( WhereToDraw, RequestTimestamp );
+	}
+
+	DRAWING_STREAM_SCOPE();
+
+	return Compressed->Process( RequestTimestamp, (void*)&WhereToDraw );
+}
+
+/** @brief Write the lossless compressed version of the raw depth file of a recording (see RvlCodec).
+ *
+ * @param Folder [in] Main folder containing the data.
+ * @return true if the compressed file was written.
+ */
+// static
+bool DrawDepthView::Compress( const std::string& Folder )
+{
+	return RvlCodec::ConvertRawFile( Folder + RawDepthFileName, DepthWidth*DepthHeight, Folder + CompressedDepthFileName, Folder + CompressedDepthIndexFileName );
+}
+
+/** @brief ProcessCompanionElement is a callback function called by the proxy stream or the compressed depth index when data are ready.
+ *
+ * @param CompanionId [in] Id of the companion (ProxyCompanion or CompressedCompanion).
+ * @param Companion [in] The proxy stream or the compressed depth index.
+ * @param RequestTimestamp [in] The timestamp of the data.
+ * @param UserData [in] User pointer to working data. Here a pointer to a cv:Mat to draw in.
+ */
+bool DrawDepthView::ProcessCompanionElement( int CompanionId, CompanionRawData& Companion, const TimeB &RequestTimestamp, void * UserData )
+{
+	cv::Mat& WhereToDraw = *((cv::Mat*)UserData);
+
+	if ( CompanionId == CompressedCompanion )
+	{
+		IndexedFrameEntry Entry;
+		const unsigned char * Frame = Compressed->ReadFrame( Companion, Entry );
+		if ( Frame == nullptr || Entry.Info != DepthWidth*DepthHeight )
+		{
+			return false;
+		}
+
+		DRAWING_FRAME_READ( 1, Entry.Size );
+
+		if ( DrawInDepth == false || AutoRange || UseDirtyTiles )
+		{
+			// Registration, auto range and dirty tiles need depth values
+			DecodedDepth.resize( DepthWidth*DepthHeight );
+			if ( RvlCodec::Decompress( Frame, Entry.Size, &DecodedDepth[0], DepthWidth*DepthHeight ) == false )
+			{
+				return false;
+			}
+
+			DrawDepthFrame( &DecodedDepth[0], WhereToDraw );
+			return true;
+		}
+
+		try
+		{
+			DRAWING_STAGE_TIMER( ConversionStage );
+
+			// Decode directly to BGR pixels, no intermediate depth frame
+			bool Decoded;
+			if ( UseColorMap )
+			{
+				DepthDrawingSink<DepthColor16> Sink( ImageBuffer, DepthColor16( Colors.GetTable() ) );
+				Decoded = RvlCodec::Decode( Frame, Entry.Size, DepthWidth*DepthHeight, Sink );
+			}
+			else
+			{
+				DepthDrawingSink<DepthGamma16> Sink( ImageBuffer, DepthGamma16() );
+				Decoded = RvlCodec::Decode( Frame, Entry.Size, DepthWidth*DepthHeight, Sink );
+			}
+			if ( Decoded == false )
+			{
+				return false;
+			}
+
+			cv::Mat MatForConversion( DepthHeight, DepthWidth, CV_8UC3, ImageBuffer );
+
+			DRAWING_STAGE_STOP( ConversionStage );
+			DRAWING_STAGE_TIMER( ResizeStage );
+
+			CopyToFinalSize( MatForConversion, WhereToDraw );
+
+		} catch (  cv::Exception )
+		{
+		}
+
+		return true;
+	}
+
+	if ( CompanionId != ProxyCompanion )
+	{
+		return false;
+	}
+
+	DRAWING_FRAME_READ( 1, Companion.GetFrameSize() );
+
+	try
+	{
+		DRAWING_STAGE_TIMER( ConversionStage );
+
+		// Proxy values are already gamma coded
+		ProxyKernel::Convert( (const ProxyKernel::SourcePixel*)Companion.GetFrame(), ImageBuffer );
+		cv::Mat MatForConversion( ProxyDepthHeight, ProxyDepthWidth, CV_8UC3, ImageBuffer );
+
+		DRAWING_STAGE_STOP( ConversionStage );
+		DRAWING_STAGE_TIMER( ResizeStage );
+
+		CopyToFinalSize( MatForConversion, WhereToDraw );
+
+	} catch (  cv::Exception )
+	{
+	}
+
+	return true;
+}
+
 
 }} // namespace MobileRGBD::Kinect2
 
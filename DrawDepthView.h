@@ -9,9 +9,17 @@
 #define __DRAW_DEPTH_VIEW_H__
 
 #include "DrawRawData.h"
+#include "ProxyGenerator.h"
+#include "IndexedFrameFile.h"
+#include "PixelKernels.h"
+#include "DepthColorRegistration.h"
+#include "AdaptiveRange.h"
+#include "DepthColorMap.h"
 
 #define DepthFileName "/depth/depth.timestamp"	/*!< @brief Timestamp file for the depth input from Kinect1 or Kinect2 */
 #define RawDepthFileName "/depth/depth.raw"		/*!< @brief Raw file for the depth input from Kinect1 or Kinect2  */
+#define CompressedDepthFileName "/depth/depth.rvl"				/*!< @brief Lossless compressed depth file (see RvlCodec) for Kinect2 */
+#define CompressedDepthIndexFileName "/depth/depth.rvl.index"	/*!< @brief Index of the compressed depth file for Kinect2 */
 
 #ifdef KINECT_1
 
@@ -34,15 +42,29 @@ namespace MobileRGBD { namespace Kinect2 {
 class DrawDepthView : public DrawRawData
 {
 public:
+	typedef FrameKernel<DepthGamma16, BGR24, DepthWidth, DepthHeight> Kernel;				/*!< @brief Kernel drawing raw depth frames */
+	typedef FrameKernel<DepthColor16, BGR24, DepthWidth, DepthHeight> ColorKernel;			/*!< @brief Kernel drawing raw depth frames with a color map */
+	typedef FrameKernel<Gray8, BGR24, ProxyDepthWidth, ProxyDepthHeight> ProxyKernel;		/*!< @brief Kernel drawing depth proxy frames */
+
 	/** @brief constructor. Draw data from the depth stream of the Kinect2.
 	 *
 	 * @param Folder [in] Main folder containing the data. Body data will be search in 'Folder/depth/' subfolder.
 	 * @param SizeOfFrame [in] Size of each frame. Default value = DepthWidth*DepthHeight*DepthBytesPerPixel.
+	 * @param _DrawInDepth [in] Draw in a depth frame or registered in a video frame (see DepthColorRegistration). Default = true.
 	 */
-	DrawDepthView( const std::string& Folder, int SizeOfFrame = DepthWidth*DepthHeight*DepthBytesPerPixel )
-		: DrawRawData( Folder + DepthFileName, Folder + RawDepthFileName, SizeOfFrame )
+	DrawDepthView( const std::string& Folder, int SizeOfFrame = DepthWidth*DepthHeight*DepthBytesPerPixel, bool _DrawInDepth = true )
+		: DrawRawData( Folder + DepthFileName, Folder + RawDepthFileName, SizeOfFrame ), Range( 65536 )
 	{
+		DrawInDepth = _DrawInDepth;
+		AutoRange = false;
+		UseColorMap = false;
+
 		ImageBuffer = new unsigned char[DepthWidth*DepthHeight*3]; // BGR data
+		OpenProxy( Folder + ProxyDepthFileName, ProxyDepthFrameSize, ProxyDepthWidth, ProxyDepthHeight );
+
+		// Read compressed depth instead of raw file if available
+		Compressed = new IndexedFrameFile( *this, CompressedCompanion, Folder + CompressedDepthFileName, Folder + CompressedDepthIndexFileName );
+		UseCompressed = true;
 	}
 
 	/** @brief Static function to draw data from RGB raw Kinect buffer.
@@ -50,6 +72,88 @@ public:
 	 */
 	static void Draw( cv::Mat& WhereToDraw, void * FrameBuffer, void * DrawingBuffer = nullptr );
 
+	/** @brief Draw data in image. Read the proxy if it can be used (only in a depth frame in grey without auto range), then the compressed depth if available, otherwise the raw file.
+	 * @param WhereToDraw [in] Drawing cv::Mat.
+	 * @param RequestTimestamp [in] Timestamp of the data.
+	 */
+	virtual bool Draw( cv::Mat& WhereToDraw, const TimeB &RequestTimestamp );
+
+	/** @brief Write the lossless compressed version of the raw depth file of a recording (see RvlCodec).
+	 *
+	 * @param Folder [in] Main folder containing the data.
+	 * @return true if the compressed file was written.
+	 */
+	static bool Compress( const std::string& Folder );
+
+	enum { CompressedCompanion = 1 };	/*!< @brief Companion id of the compressed depth index in ProcessCompanionElement */
+
+	/** @brief Is the compressed depth available?
+	 */
+	bool IsCompressedAvailable() const
+	{
+		return Compressed->IsOpen();
+	}
+
+	/** @brief Set if the compressed depth (if available) must be read instead of the raw file (Default = true).
+	 *
+	 * @param Value [in] Use compressed depth or not.
+	 */
+	void SetUseCompressed( bool Value )
+	{
+		UseCompressed = Value;
+	}
+
+	/** @brief Set if we draw in a depth frame or registered in a video frame.
+	 *
+	 * @param Value [in] Draw in a depth frame or not.
+	 */
+	void SetDrawInDepth( bool Value )
+	{
+		DrawInDepth = Value;
+	}
+
+	/** @brief Set if the display range follows the depth of each frame (see AdaptiveRange) or is fixed (Default = false).
+	 *         Proxies are not used in auto range mode.
+	 *
+	 * @param Value [in] Auto range or not.
+	 */
+	void SetAutoRange( bool Value )
+	{
+		AutoRange = Value;
+		Range.Reset();
+	}
+
+	/** @brief Get the current display range (auto range mode).
+	 */
+	const AdaptiveRange& GetAutoRange() const
+	{
+		return Range;
+	}
+
+	/** @brief Set if depth is drawn with a color map (see GetColorMap) or in grey levels (Default = false).
+	 *         Proxies are not used with a color map. In auto range mode, the auto range replaces the limits of the color map.
+	 *
+	 * @param Value [in] Draw with a color map or not.
+	 */
+	void SetUseColorMap( bool Value )
+	{
+		UseColorMap = Value;
+	}
+
+	/** @brief Get the color map, to change its palette or its near and far limits.
+	 */
+	DepthColorMap& GetColorMap()
+	{
+		return Colors;
+	}
+
+	/** @brief Get the registration used to draw in a video frame, to change its calibration.
+	 */
+	DepthColorRegistration& GetRegistration()
+	{
+		return Registration;
+	}
+
 	/** @brief Virtual destructor, always.
 	 */
 	~DrawDepthView()
@@ -58,6 +162,7 @@ public:
 		{
 			delete ImageBuffer;
 		}
+		delete Compressed;
 	};
 
 	/** @brief ProcessElement is a callback function called by mother classes when data are ready.
@@ -67,8 +172,33 @@ public:
 	 */
 	virtual bool ProcessElement( const TimeB &RequestTimestamp, void * UserData = nullptr );
 
+	/** @brief ProcessCompanionElement is a callback function called by the proxy stream or the compressed depth index when data are ready.
+	 *
+	 * @param CompanionId [in] Id of the companion (ProxyCompanion or CompressedCompanion).
+	 * @param Companion [in] The proxy stream or the compressed depth index.
+	 * @param RequestTimestamp [in] The timestamp of the data.
+	 * @param UserData [in] User pointer to working data. Here a pointer to a cv:Mat to draw in.
+	 */
+	virtual bool ProcessCompanionElement( int CompanionId, CompanionRawData& Companion, const TimeB &RequestTimestamp, void * UserData );
+
 protected:
+	/** @brief Draw a depth frame, in a depth frame or registered in a video frame, with fixed or auto range.
+	 *
+	 * @param DepthFrame [in] Depth frame.
+	 * @param WhereToDraw [in] Drawing cv::Mat.
+	 */
+	void DrawDepthFrame( const unsigned short int * DepthFrame, cv::Mat& WhereToDraw );
+
 	unsigned char * ImageBuffer;		/*!< @brief Buffer to work on the data. */
+	IndexedFrameFile * Compressed;		/*!< @brief Compressed depth, if available */
+	bool UseCompressed;					/*!< @brief Read the compressed depth when available */
+	bool DrawInDepth;					/*!< @brief Draw in a depth frame or registered in a video frame */
+	DepthColorRegistration Registration;	/*!< @brief Registration with the video frame */
+	std::vector<unsigned short int> DecodedDepth;	/*!< @brief Decompressed depth frame when drawing in a video frame or in auto range */
+	bool AutoRange;						/*!< @brief Display range follows the depth of each frame */
+	AdaptiveRange Range;				/*!< @brief Display range in auto range mode */
+	bool UseColorMap;					/*!< @brief Draw with a color map instead of grey levels */
+	DepthColorMap Colors;				/*!< @brief Color map */
 };
 
 }} // namespace MobileRGBD::Kinect2
@@ -44,12 +44,16 @@ bool DrawFace::ProcessElement( const TimeB &RequestTimestamp, void *UserData )
 {
 	cv::Mat& WhereToDraw = *((cv::Mat*)UserData);
 
+	DRAWING_FRAME_READ( NumberOfSubFrames, NumberOfSubFrames*FrameSize );
+
 	if ( NumberOfSubFrames == 0 )
 	{
 		// Nothing to Draw, draw is done
 		return true;
 	}
 
+	DRAWING_STAGE_TIMER( OverlayStage );
+
 	for( int i = 0; i < NumberOfSubFrames; i++ )
 	{
 		// Initialise memory block for a face
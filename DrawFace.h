@@ -44,6 +44,7 @@ public:
 #ifdef KINECT_2
 
 #include "Kinect/KinectFace.h"
+#include "PresenceIndex.h"
 
 #define RawFaceFileName "/face/face.raw"
 
@@ -79,10 +80,25 @@ public:
 		// Correct size of frame
 		CurrentFace.Set((unsigned char*)nullptr);
 		FrameSize = CurrentFace.FaceSize;
+
+		PresenceOpened = false;
 	}
 
 	virtual ~DrawFace() {};
 
+	/** @brief Get the presence index of the stream (number of faces of each frame), opened at first call.
+	 *         Used to jump to frames with faces without reading frames (see PresenceIndex).
+	 */
+	const PresenceIndex& GetPresenceIndex()
+	{
+		if ( PresenceOpened == false )
+		{
+			Presence.Open( TimestampFileName );
+			PresenceOpened = true;
+		}
+		return Presence;
+	}
+
 protected:
 	/** @brief ProcessElement is a callback function called by mother classes when data are ready.
 	 *
@@ -98,6 +114,8 @@ protected:
 	int ImghHeight;		/*!< @brief Memory of the height for scaling purpose */
 
 	MobileRGBD::Kinect2::KinectFace CurrentFace;		/*!< @brief Current face */
+	PresenceIndex Presence;		/*!< @brief Number of faces of each frame */
+	bool PresenceOpened;		/*!< @brief Was Presence opened? */
 };
 
 }} // namespace MobileRGBD::Kinect2
@@ -30,9 +30,11 @@ namespace MobileRGBD { namespace Kinect2 {
  * @param SizeOfFrame [in] Size of each frame. Default value = InfraredWidth*InfraredHeight*InfraredBytesPerPixel.
  */
 DrawInfraredView::DrawInfraredView( const std::string& Folder, int SizeOfFrame /* = InfraredWidth*InfraredHeight*InfraredBytesPerPixel */ )
-	: DrawRawData( Folder + InfraredFileName, Folder + RawInfraredFileName, SizeOfFrame )
+	: DrawRawData( Folder + InfraredFileName, Folder + RawInfraredFileName, SizeOfFrame ), Range( 8192 )
 {
+	AutoRange = false;
 	ImageBuffer = new unsigned char[DepthWidth*DepthHeight*10]; // BGR data
+	OpenProxy( Folder + ProxyInfraredFileName, ProxyDepthFrameSize, ProxyDepthWidth, ProxyDepthHeight );
 }
 
 /** @brief Virtual destructor, always.
@@ -45,6 +47,21 @@ DrawInfraredView::~DrawInfraredView()
 	}
 }
 
+/** @brief Draw data in image. Read the proxy if it can be used (not in auto range mode), otherwise the raw file.
+ * @param WhereToDraw [in] Drawing cv::Mat.
+ * @param RequestTimestamp [in] Timestamp of the data.
+ */
+bool DrawInfraredView::Draw( cv::Mat& WhereToDraw, const TimeB &RequestTimestamp )
+{
+	// Proxy frames are already gamma coded, they can not give the auto range
+	if ( AutoRange && LiveSource == nullptr )
+	{
+		return DrawTimestampRawData::Draw( WhereToDraw, RequestTimestamp );
+	}
+
+	return DrawRawData::Draw( WhereToDraw, RequestTimestamp );
+}
+
 /** @brief ProcessElement is a callback function called by mother classes when data are ready.
  *
  * @param RequestTimestamp [in] The timestamp of the data.
@@ -54,76 +71,95 @@ bool DrawInfraredView::ProcessElement( const TimeB &RequestTimestamp, void * Use
 {
 	cv::Mat& WhereToDraw = *((cv::Mat*)UserData);
 
+	DRAWING_FRAME_READ( 1, FrameSize );
+
 	try
 	{
 
+	DRAWING_STAGE_TIMER( ConversionStage );
+
 	unsigned short int * Table = (unsigned short int*)FrameBuffer;
+
+	// Fixed gamma coding (/8192, gamma .32) or auto range, rebuilt only when the range moves
+	const unsigned char * Gamma = GammaTable16<8192>::Get();
+	if ( AutoRange )
+	{
+		Range.Update( Table, InfraredWidth, InfraredHeight );
+		Gamma = Range.GetTable();
+	}
+
+#ifdef USING_MAP
 	int PosBuffer = 0;
 	int PosRef =0;
 
 	uchar * Img = (uchar*)ImageBuffer;
 
-#ifdef USING_MAP
 	for( int i = 0; i < DepthWidth*DepthHeight; i++, PosBuffer++ )
 	{
-
-
-		float originalBrightnessValue = ((float)Table[PosBuffer])/(8192.f);
- 
-		float amplication=1.0f;
-		float gamma = .32f;
- 
-		// this is where the gamma and amplification levels get applied
-		float gammaAppliedValue = amplication*pow(originalBrightnessValue, gamma);
-		Img[PosRef++] = (uchar)(std::min(gammaAppliedValue, 1.0f)*255.0);
+		Img[PosRef++] = Gamma[Table[PosBuffer]];
 	}
 
 	cv::Mat FloatImg( DepthHeight, DepthWidth, CV_8UC1, Img );
-	cv::Mat MatForConversion;
+	cv::Mat& MatForConversion = ColorMapImage;	// reused from frame to frame
 	cv::applyColorMap(FloatImg, MatForConversion, cv::COLORMAP_JET);
 #else
-	for( int i = 0; i < DepthWidth*DepthHeight; i++, PosBuffer++ )
+	// In dirty tile mode, only changed tiles are converted, all of them if the table changed
+	DirtyTiles * ChangedTiles = GetDirtyTiles( InfraredWidth, InfraredHeight, InfraredBytesPerPixel, BGR24::Channels );
+	if ( ChangedTiles != nullptr )
 	{
-		ImageBuffer[PosRef++] = 0;
-		if ( Table[PosBuffer] == 0 )
-		{
-			ImageBuffer[PosRef++] = 0;
-			ImageBuffer[PosRef++] = 255;
-		}
-		else
-		{
-			float originalBrightnessValue = ((float)Table[PosBuffer])/(8192.f);
- 
-			float amplication=1.0f;
-			float gamma = .32f;
- 
-			// this is where the gamma and amplification levels get applied
-			float gammaAppliedValue = amplication*pow(originalBrightnessValue, gamma);
- 
-			//here we convert it to the desired 0 - 255 range for a byte
-			uchar intensity = (uchar)(std::min(gammaAppliedValue, 1.0f)*255.0);
- 
-			ImageBuffer[PosRef++] = (uchar)intensity;
-			ImageBuffer[PosRef++] = 255;
-		}
+		ChangedTiles->Update( Table, AutoRange ? (long long)Range.GetVersion()*2+1 : 0 );
 	}
 
-	cv::Mat MatForConversion(DepthHeight, DepthWidth, CV_8UC3, ImageBuffer );
+	unsigned char * Converted = DirtyTiles::ConvertFrame<Kernel>( ChangedTiles, Table, ImageBuffer, InfraredGamma16( Gamma ) );
+
+	cv::Mat MatForConversion(InfraredHeight, InfraredWidth, CV_8UC3, Converted );
 
 #endif
 
-	// Resize it to finel size
-	if ( MatForConversion.rows != WhereToDraw.rows || MatForConversion.cols != WhereToDraw.cols )
+	DRAWING_STAGE_STOP( ConversionStage );
+	DRAWING_STAGE_TIMER( ResizeStage );
+
+	CopyToFinalSize( MatForConversion, WhereToDraw );
+
+	} catch (  cv::Exception )
 	{
-		cv::Mat MatForFinal( WhereToDraw.rows, WhereToDraw.cols, CV_8UC3 );
-		cv::resize( MatForConversion, MatForFinal, cv::Size(WhereToDraw.cols,WhereToDraw.rows), 0, 0 );
-		MatForFinal.copyTo( WhereToDraw );
 	}
-	else
+
+	return true;
+}
+
+/** @brief ProcessCompanionElement is a callback function called by the proxy stream when data are ready.
+ *
+ * @param CompanionId [in] Id of the companion (ProxyCompanion).
+ * @param Companion [in] The proxy stream.
+ * @param RequestTimestamp [in] The timestamp of the data.
+ * @param UserData [in] User pointer to working data. Here a pointer to a cv:Mat to draw in.
+ */
+bool DrawInfraredView::ProcessCompanionElement( int CompanionId, CompanionRawData& Companion, const TimeB &RequestTimestamp, void * UserData )
+{
+	if ( CompanionId != ProxyCompanion )
 	{
-		MatForConversion.copyTo( WhereToDraw );
+		return false;
 	}
 
+	cv::Mat& WhereToDraw = *((cv::Mat*)UserData);
+
+	DRAWING_FRAME_READ( 1, Companion.GetFrameSize() );
+
+	try
+	{
+		DRAWING_STAGE_TIMER( ConversionStage );
+
+		// Proxy values are already gamma coded intensities
+		ProxyKernel::Convert( (const ProxyKernel::SourcePixel*)Companion.GetFrame(), ImageBuffer );
+
+		cv::Mat MatForConversion( ProxyDepthHeight, ProxyDepthWidth, CV_8UC3, ImageBuffer );
+
+		DRAWING_STAGE_STOP( ConversionStage );
+		DRAWING_STAGE_TIMER( ResizeStage );
+
+		CopyToFinalSize( MatForConversion, WhereToDraw );
+
 	} catch (  cv::Exception )
 	{
 	}
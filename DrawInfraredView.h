@@ -17,6 +17,9 @@
 #ifdef KINECT_2
 
 #include "DrawRawData.h"
+#include "ProxyGenerator.h"
+#include "PixelKernels.h"
+#include "AdaptiveRange.h"
 
 #define InfraredFileName "/infrared/infrared.timestamp"	/*!< @brief Timestamp file for the infrared input from Kinect1 or Kinect2 */
 #define RawInfraredFileName "/infrared/infrared.raw"	/*!< @brief Raw file for the infrared input from Kinect1 or Kinect2  */
@@ -32,6 +35,9 @@ namespace MobileRGBD { namespace Kinect2 {
 class DrawInfraredView : public DrawRawData
 {
 public:
+	typedef FrameKernel<InfraredGamma16, BGR24, InfraredWidth, InfraredHeight> Kernel;		/*!< @brief Kernel drawing raw infrared frames */
+	typedef FrameKernel<InfraredGray8, BGR24, ProxyDepthWidth, ProxyDepthHeight> ProxyKernel;	/*!< @brief Kernel drawing infrared proxy frames */
+
 	/** @brief constructor. Draw data from the infrared stream of the Kinect2.
 	 *
 	 * @param Folder [in] Main folder containing the data. Body data will be search in 'Folder/infrared/' subfolder.
@@ -43,6 +49,30 @@ public:
 	 */
 	virtual ~DrawInfraredView();
 
+	/** @brief Draw data in image. Read the proxy if it can be used (not in auto range mode), otherwise the raw file.
+	 * @param WhereToDraw [in] Drawing cv::Mat.
+	 * @param RequestTimestamp [in] Timestamp of the data.
+	 */
+	virtual bool Draw( cv::Mat& WhereToDraw, const TimeB &RequestTimestamp );
+
+	/** @brief Set if the display range follows the intensity of each frame (see AdaptiveRange) or is fixed (Default = false).
+	 *         Proxies are not used in auto range mode.
+	 *
+	 * @param Value [in] Auto range or not.
+	 */
+	void SetAutoRange( bool Value )
+	{
+		AutoRange = Value;
+		Range.Reset();
+	}
+
+	/** @brief Get the current display range (auto range mode).
+	 */
+	const AdaptiveRange& GetAutoRange() const
+	{
+		return Range;
+	}
+
 	/** @brief ProcessElement is a callback function called by mother classes when data are ready.
 	 *
 	 * @param RequestTimestamp [in] The timestamp of the data.
@@ -50,8 +80,20 @@ public:
 	 */
 	virtual bool ProcessElement( const TimeB &RequestTimestamp, void * UserData = nullptr );
 
+	/** @brief ProcessCompanionElement is a callback function called by the proxy stream when data are ready.
+	 *
+	 * @param CompanionId [in] Id of the companion (ProxyCompanion).
+	 * @param Companion [in] The proxy stream.
+	 * @param RequestTimestamp [in] The timestamp of the data.
+	 * @param UserData [in] User pointer to working data. Here a pointer to a cv:Mat to draw in.
+	 */
+	virtual bool ProcessCompanionElement( int CompanionId, CompanionRawData& Companion, const TimeB &RequestTimestamp, void * UserData );
+
 protected:
 	unsigned char * ImageBuffer;		/*!< @brief Buffer to work on the data. */
+	cv::Mat ColorMapImage;				/*!< @brief Color mapped image (USING_MAP), kept to be reused. */
+	bool AutoRange;						/*!< @brief Display range follows the intensity of each frame */
+	AdaptiveRange Range;				/*!< @brief Display range in auto range mode */
 };
 
 }} // namespace MobileRGBD::Kinect2
@@ -13,6 +13,9 @@
 #include <System/SimpleList.h>
 #include <Messaging/Serializable.h>
 
+#include <stdlib.h>
+#include <string.h>
+
 using namespace cv;
 using namespace MobileRGBD;
 
@@ -44,7 +47,122 @@ public:
 	}
 };
 
+namespace {
+
+/** @brief Search a key in JSON data and return the position of its value.
+ *
+ * @param Data [in] JSON data.
+ * @param Key [in] Key with quotes.
+ * @return the position of the value, nullptr if not found.
+ */
+const char * FindJsonValue( const char * Data, const char * Key )
+{
+	const char * Pos = strstr( Data, Key );
+	if ( Pos == nullptr )
+	{
+		return nullptr;
+	}
+
+	Pos += strlen( Key );
+	while( *Pos == ' ' || *Pos == '\t' || *Pos == ':' )
+	{
+		Pos++;
+	}
+
+	return Pos;
+}
+
+/** @brief Read a numeric JSON value.
+ *
+ * @param Data [in] JSON data.
+ * @param Key [in] Key with quotes.
+ * @param Value [out] The value.
+ * @return true if the value was read.
+ */
+template<typename TypeOfValue>
+bool ReadJsonNumber( const char * Data, const char * Key, TypeOfValue& Value )
+{
+	const char * Pos = FindJsonValue( Data, Key );
+	if ( Pos == nullptr )
+	{
+		return false;
+	}
+
+	char * End;
+	double Tmp = strtod( Pos, &End );
+	if ( End == Pos )
+	{
+		return false;
+	}
+
+	Value = (TypeOfValue)Tmp;
+	return true;
+}
+
+} // anonymous namespace
+
+/** @brief Parse JSON laser data.
+ *
+ * @param Data [in] JSON data.
+ * @return true if all fields were found.
+ */
+bool LaserScan::Parse( const char * Data )
+{
+	if ( ReadJsonNumber( Data, "\"FirstAngle\"", FirstAngle ) == false || ReadJsonNumber( Data, "\"LastAngle\"", LastAngle ) == false ||
+		 ReadJsonNumber( Data, "\"Step\"", Step ) == false || ReadJsonNumber( Data, "\"NbEchos\"", NbEchos ) == false )
+	{
+		return false;
+	}
+
+	const char * Pos = FindJsonValue( Data, "\"LaserMap\"" );
+	if ( Pos == nullptr || *Pos != '[' )
+	{
+		return false;
+	}
+	Pos++;
+
+	// Keep capacity of LaserMap
+	LaserMap.clear();
+	for(;;)
+	{
+		while( *Pos == ' ' || *Pos == '\t' || *Pos == ',' )
+		{
+			Pos++;
+		}
+		if ( *Pos == ']' )
+		{
+			return true;
+		}
+
+		char * End;
+		double Value = strtod( Pos, &End );
+		if ( End == Pos )
+		{
+			return false;
+		}
+		LaserMap.push_back( (float)Value );
+		Pos = End;
+	}
+}
+
+/** @brief Static function to draw lidar data in opencv image
+ */
 void DrawLaserData::Draw(float FirstAngle, float LastAngle, float Step, int NbEchos, Omiscid::SimpleList<float>& LaserMap, cv::Mat& WhereToDraw, int DrawingMode /*= PointToLine*/ )
+{
+	// Copy values in an array kept for the thread
+	static thread_local std::vector<float> Values;
+	Values.clear();
+	for( LaserMap.First(); LaserMap.NotAtEnd(); LaserMap.Next() )
+	{
+		Values.push_back( LaserMap.GetCurrent() );
+	}
+
+	Draw( FirstAngle, LastAngle, Step, NbEchos, Values.empty() ? nullptr : &Values[0], (int)Values.size(), WhereToDraw, DrawingMode );
+}
+
+/** @brief Static function to draw lidar data in opencv image
+ */
+void DrawLaserData::Draw(float FirstAngle, float LastAngle, float Step, int NbEchos, const float * LaserMap, int NumberOfValues, cv::Mat& WhereToDraw, int DrawingMode /*= PointToLine*/ )
 {
 #ifdef KINECT_2
 	double CurrentAngle;
@@ -92,9 +210,9 @@ void DrawLaserData::Draw(float FirstAngle, float LastAngle, float Step, int NbEc
 			{
 				CurrentAngle = FirstAngle;
 				Point Precedent(WhereToDraw.cols/2,2*WhereToDraw.rows/3);
-				for( LaserMap.First(); LaserMap.NotAtEnd(); LaserMap.Next() )
+				for( int i = 0; i < NumberOfValues; i++ )
 				{
-					double value = LaserMap.GetCurrent();
+					double value = LaserMap[i];
 
 					if ( value >= 10.0 )
 					{
@@ -119,9 +237,9 @@ void DrawLaserData::Draw(float FirstAngle, float LastAngle, float Step, int NbEc
 			case PointCloud:
 			{
 				CurrentAngle = FirstAngle;
-				for( LaserMap.First(); LaserMap.NotAtEnd(); LaserMap.Next() )
+				for( int i = 0; i < NumberOfValues; i++ )
 				{
-					double value = LaserMap.GetCurrent();
+					double value = LaserMap[i];
 
 					if ( value >= 10.0 )
 					{
@@ -151,10 +269,30 @@ bool DrawLaserData::ProcessElement( const TimeB &RequestTimestamp, void * UserDa
 {
 	cv::Mat& WhereToDraw = *((cv::Mat*)UserData);
 
-	TelemeterInfo LaserData;
-	LaserData.Unserialize(Omiscid::SimpleString(DataBuffer));
+	DRAWING_FRAME_READ( 1, strlen(DataBuffer) );
+
+	DRAWING_STAGE_TIMER( ConversionStage );
+	if ( CurrentScan.Parse( DataBuffer ) == false )
+	{
+		// Not the expected layout, use the generic JSON unserializer
+		TelemeterInfo LaserData;
+		LaserData.Unserialize(Omiscid::SimpleString(DataBuffer));
+
+		CurrentScan.FirstAngle = LaserData.FirstAngle;
+		CurrentScan.LastAngle = LaserData.LastAngle;
+		CurrentScan.Step = LaserData.Step;
+		CurrentScan.NbEchos = LaserData.NbEchos;
+		CurrentScan.LaserMap.clear();
+		for( LaserData.LaserMap.First(); LaserData.LaserMap.NotAtEnd(); LaserData.LaserMap.Next() )
+		{
+			CurrentScan.LaserMap.push_back( LaserData.LaserMap.GetCurrent() );
+		}
+	}
+	DRAWING_STAGE_STOP( ConversionStage );
+
+	DRAWING_STAGE_TIMER( OverlayStage );
 
-	Draw(LaserData.FirstAngle, LaserData.LastAngle, LaserData.Step, LaserData.NbEchos, LaserData.LaserMap, WhereToDraw, CurrentDrawingMode );
+	Draw(CurrentScan.FirstAngle, CurrentScan.LastAngle, CurrentScan.Step, CurrentScan.NbEchos, CurrentScan.LaserMap.empty() ? nullptr : &CurrentScan.LaserMap[0], (int)CurrentScan.LaserMap.size(), WhereToDraw, CurrentDrawingMode );
 
 	return true;
 }
\ No newline at end of file
@@ -11,11 +11,36 @@
 // #include "DrawingTools.h"
 #include "DrawTimestampData.h"
 #include <System/SimpleList.h>
+#include <vector>
 
 #define TelemeterFileName "/robulab/Laser.timestamp"
 
 namespace MobileRGBD {
 
+/**
+ * @class LaserScan DrawLaser.cpp DrawLaser.h
+ * @brief Laser data parsed from a line of the laser timestamp file. Values are kept from one
+ *        line to the next, so parsing does not allocate memory once the first scan is read.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class LaserScan
+{
+public:
+	/** @brief Parse JSON laser data.
+	 *
+	 * @param Data [in] JSON data.
+	 * @return true if all fields were found.
+	 */
+	bool Parse( const char * Data );
+
+	float FirstAngle;				/*!< First angle of the laser range finder */
+	float LastAngle;				/*!< Last angle of the laser range finder */
+	float Step;						/*!< Step between angles of the laser range finder */
+	int NbEchos;					/*!< Number of laser echos */
+	std::vector<float> LaserMap;	/*!< Values ordered from First angle to last angle */
+};
+
 /**
  * @class DrawLaserData DrawLaser.cpp DrawLaser.h
  * @brief Class to draw laser range finder around the robot.
@@ -46,6 +71,10 @@ public:
 	 */
 	static void Draw(float FirstAngle, float LastAngle, float Step, int NbEchos, Omiscid::SimpleList<float>& LaserMap, cv::Mat& WhereToDraw, int DrawingMode = PointToLine );
 
+	/** @brief Static function to draw lidar data in opencv image
+	 */
+	static void Draw(float FirstAngle, float LastAngle, float Step, int NbEchos, const float * LaserMap, int NumberOfValues, cv::Mat& WhereToDraw, int DrawingMode = PointToLine );
+
 	/** @brief ProcessElement is a callback function called by mother classes when data are ready.
 	 *
 	 * @param RequestTimestamp [in] The timestamp of the data.
@@ -58,6 +87,9 @@ public:
 	 */
 	enum { PointToLine = 0, PointCloud = 1 };
 	int CurrentDrawingMode;
+
+protected:
+	LaserScan CurrentScan;		/*!< @brief Last parsed laser data, kept to be reused */
 };
 
 } // namespace MobileRGBD
@@ -0,0 +1,321 @@
+/**
+ * @file DrawLayers.cpp
+ * @ingroup Drawing
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#include "DrawLayers.h"
+#include "DrawingSimd.h"
+
+using namespace MobileRGBD;
+
+namespace {
+
+/** @brief Blend pixels with the scalar code.
+ */
+inline void BlendPixels( const unsigned char * Layer, unsigned char * WhereToDraw, int NumberOfPixels, int Alpha, const unsigned char * TransparentColor )
+{
+	int InvAlpha = 256 - Alpha;
+	for( int i = 0; i < NumberOfPixels; i++, Layer += 3, WhereToDraw += 3 )
+	{
+		if ( TransparentColor != nullptr && Layer[0] == TransparentColor[0] && Layer[1] == TransparentColor[1] && Layer[2] == TransparentColor[2] )
+		{
+			continue;
+		}
+
+		WhereToDraw[0] = (unsigned char)((Layer[0]*Alpha + WhereToDraw[0]*InvAlpha) >> 8);
+		WhereToDraw[1] = (unsigned char)((Layer[1]*Alpha + WhereToDraw[1]*InvAlpha) >> 8);
+		WhereToDraw[2] = (unsigned char)((Layer[2]*Alpha + WhereToDraw[2]*InvAlpha) >> 8);
+	}
+}
+
+#ifdef DRAWING_SSE2
+
+/** @brief Blend 16 bytes: (Layer*Alpha + WhereToDraw*InvAlpha) >> 8 on 16 bits values.
+ */
+inline __m128i Blend16Bytes( __m128i Layer, __m128i WhereToDraw, __m128i Alpha, __m128i InvAlpha )
+{
+	const __m128i Zero = _mm_setzero_si128();
+
+	__m128i Low = _mm_add_epi16( _mm_mullo_epi16( _mm_unpacklo_epi8( Layer, Zero ), Alpha ), _mm_mullo_epi16( _mm_unpacklo_epi8( WhereToDraw, Zero ), InvAlpha ) );
+	__m128i High = _mm_add_epi16( _mm_mullo_epi16( _mm_unpackhi_epi8( Layer, Zero ), Alpha ), _mm_mullo_epi16( _mm_unpackhi_epi8( WhereToDraw, Zero ), InvAlpha ) );
+
+	return _mm_packus_epi16( _mm_srli_epi16( Low, 8 ), _mm_srli_epi16( High, 8 ) );
+}
+
+#endif // DRAWING_SSE2
+
+} // anonymous namespace
+
+/** @brief Virtual destructor, always.
+ */
+DrawLayers::~DrawLayers()
+{
+	for( size_t l = 0; l < Layers.size(); l++ )
+	{
+		delete Layers[l].Cursor;
+		delete Layers[l].Source;
+	}
+}
+
+/** @brief Add a layer over the previous ones.
+ *
+ * @param Layer [in] Drawable of the layer.
+ * @param Opacity [in] Opacity of the layer, from 0.0 (invisible) to 1.0 (Default = 1.0).
+ */
+void DrawLayers::AddLayer( Drawable * Layer, float Opacity /* = 1.0f */ )
+{
+	LayerInfo NewLayer;
+	NewLayer.Layer = Layer;
+	NewLayer.Alpha = Opacity <= 0.0f ? 0 : (Opacity >= 1.0f ? 256 : (int)(Opacity*256.0f + 0.5f));
+	NewLayer.UseTransparentColor = false;
+	NewLayer.TransparentColor[0] = NewLayer.TransparentColor[1] = NewLayer.TransparentColor[2] = 0;
+	NewLayer.Source = nullptr;
+	NewLayer.Cursor = nullptr;
+	NewLayer.Cached = false;
+	NewLayer.CachedFrame = 0;
+	NewLayer.CachedResult = false;
+
+	Layers.push_back( NewLayer );
+}
+
+/** @brief Add a layer over the previous ones, pixels of the transparent color are not drawn.
+ *
+ * @param Layer [in] Drawable of the layer.
+ * @param Opacity [in] Opacity of the layer, from 0.0 (invisible) to 1.0.
+ * @param TransparentColor [in] BGR color of transparent pixels (background of the layer).
+ */
+void DrawLayers::AddLayer( Drawable * Layer, float Opacity, const cv::Vec3b& TransparentColor )
+{
+	AddLayer( Layer, Opacity );
+
+	LayerInfo& NewLayer = Layers.back();
+	NewLayer.UseTransparentColor = true;
+	NewLayer.TransparentColor[0] = TransparentColor[0];
+	NewLayer.TransparentColor[1] = TransparentColor[1];
+	NewLayer.TransparentColor[2] = TransparentColor[2];
+}
+
+/** @brief Cache a layer: it is drawn again only when the frame of its stream at the requested timestamp
+ *         or the image size changes. A cached layer is drawn in its own buffer, so an opaque cached layer
+ *         without transparent color replaces the image below it.
+ *
+ * @param LayerNumber [in] Layer, in the order of AddLayer calls.
+ * @param TimestampFile [in] Timestamp file of the stream drawn by the layer.
+ * @return true if the timestamp file was read.
+ */
+bool DrawLayers::SetLayerSource( int LayerNumber, const std::string& TimestampFile )
+{
+	if ( LayerNumber < 0 || LayerNumber >= (int)Layers.size() )
+	{
+		return false;
+	}
+
+	LayerInfo& Current = Layers[LayerNumber];
+	delete Current.Cursor;
+	delete Current.Source;
+	Current.Cursor = nullptr;
+	Current.Source = nullptr;
+	Current.Cached = false;
+
+	TimestampIndex * NewSource = new TimestampIndex;
+	if ( NewSource->Load( TimestampFile ) == false )
+	{
+		delete NewSource;
+		return false;
+	}
+
+	Current.Source = NewSource;
+	Current.Cursor = new TimestampCursor( *NewSource );
+
+	return true;
+}
+
+/** @brief Blend a line of BGR pixels over another one: WhereToDraw = (Layer*Alpha + WhereToDraw*(256-Alpha))/256.
+ *
+ * @param Layer [in] Pixels of the layer.
+ * @param WhereToDraw [in,out] Pixels to blend into.
+ * @param NumberOfPixels [in] Number of pixels of the line.
+ * @param Alpha [in] Opacity from 0 to 256.
+ * @param TransparentColor [in] BGR color of pixels to skip, nullptr if none.
+ */
+// static
+void DrawLayers::BlendLine( const unsigned char * Layer, unsigned char * WhereToDraw, int NumberOfPixels, int Alpha, const unsigned char * TransparentColor )
+{
+	int i = 0;
+
+#ifdef DRAWING_SSE2
+	// 16 pixels (48 bytes, 3 registers) per iteration
+	const __m128i VAlpha = _mm_set1_epi16( (short)Alpha );
+	const __m128i VInvAlpha = _mm_set1_epi16( (short)(256-Alpha) );
+
+	// Transparent color repeated on 48 bytes
+	unsigned char KeyBytes[48];
+	for( int b = 0; b < 48; b++ )
+	{
+		KeyBytes[b] = TransparentColor != nullptr ? TransparentColor[b%3] : 0;
+	}
+	const __m128i Key0 = _mm_loadu_si128( (const __m128i*)KeyBytes );
+	const __m128i Key1 = _mm_loadu_si128( (const __m128i*)(KeyBytes+16) );
+	const __m128i Key2 = _mm_loadu_si128( (const __m128i*)(KeyBytes+32) );
+
+	// Bit 3*p of the byte mask for each pixel p of the block
+	const unsigned long long PixelBits = 0x249249249249ULL;
+
+	for( ; i+16 <= NumberOfPixels; i += 16 )
+	{
+		const unsigned char * Src = Layer + i*3;
+		unsigned char * Dst = WhereToDraw + i*3;
+
+		__m128i S0 = _mm_loadu_si128( (const __m128i*)Src );
+		__m128i S1 = _mm_loadu_si128( (const __m128i*)(Src+16) );
+		__m128i S2 = _mm_loadu_si128( (const __m128i*)(Src+32) );
+
+		if ( TransparentColor != nullptr )
+		{
+			// A pixel is transparent if its 3 bytes are equal to the key
+			unsigned long long Equal = (unsigned long long)(unsigned int)_mm_movemask_epi8( _mm_cmpeq_epi8( S0, Key0 ) ) |
+				((unsigned long long)(unsigned int)_mm_movemask_epi8( _mm_cmpeq_epi8( S1, Key1 ) ) << 16) |
+				((unsigned long long)(unsigned int)_mm_movemask_epi8( _mm_cmpeq_epi8( S2, Key2 ) ) << 32);
+			unsigned long long Transparent = Equal & (Equal >> 1) & (Equal >> 2) & PixelBits;
+
+			if ( Transparent == PixelBits )
+			{
+				// Background only, nothing to do
+				continue;
+			}
+			if ( Transparent != 0 )
+			{
+				// Border of the layer
+				BlendPixels( Src, Dst, 16, Alpha, TransparentColor );
+				continue;
+			}
+		}
+
+		if ( Alpha >= 256 )
+		{
+			_mm_storeu_si128( (__m128i*)Dst, S0 );
+			_mm_storeu_si128( (__m128i*)(Dst+16), S1 );
+			_mm_storeu_si128( (__m128i*)(Dst+32), S2 );
+			continue;
+		}
+
+		_mm_storeu_si128( (__m128i*)Dst, Blend16Bytes( S0, _mm_loadu_si128( (const __m128i*)Dst ), VAlpha, VInvAlpha ) );
+		_mm_storeu_si128( (__m128i*)(Dst+16), Blend16Bytes( S1, _mm_loadu_si128( (const __m128i*)(Dst+16) ), VAlpha, VInvAlpha ) );
+		_mm_storeu_si128( (__m128i*)(Dst+32), Blend16Bytes( S2, _mm_loadu_si128( (const __m128i*)(Dst+32) ), VAlpha, VInvAlpha ) );
+	}
+#endif
+
+	// Remaining pixels (all pixels without SSE2)
+	BlendPixels( Layer + i*3, WhereToDraw + i*3, NumberOfPixels - i, Alpha, TransparentColor );
+}
+
+/** @brief Blend the buffer of a layer in the image.
+ */
+// static
+void DrawLayers::Composite( const LayerInfo& Current, cv::Mat& WhereToDraw )
+{
+	DRAWING_STAGE_TIMER( OverlayStage );
+
+	if ( Current.Alpha >= 256 && Current.UseTransparentColor == false )
+	{
+		// Opaque cached layer
+		Current.Buffer.copyTo( WhereToDraw );
+		return;
+	}
+
+	for( int line = 0; line < WhereToDraw.rows; line++ )
+	{
+		BlendLine( Current.Buffer.ptr<unsigned char>( line ), WhereToDraw.ptr<unsigned char>( line ), WhereToDraw.cols, Current.Alpha,
+			Current.UseTransparentColor ? Current.TransparentColor : nullptr );
+	}
+}
+
+/** @brief Draw all layers in image.
+ *
+ * @param WhereToDraw [in] Drawing cv::Mat (BGR).
+ * @param RequestTimestamp [in] Timestamp of the data.
+ * @return true if at least one layer was drawn.
+ */
+bool DrawLayers::Draw( cv::Mat& WhereToDraw, const TimeB &RequestTimestamp )
+{
+	bool Ret = false;
+
+	if ( WhereToDraw.type() != CV_8UC3 )
+	{
+		return false;
+	}
+
+	for( size_t l = 0; l < Layers.size(); l++ )
+	{
+		LayerInfo& Current = Layers[l];
+		if ( Current.Layer == nullptr || Current.Alpha == 0 )
+		{
+			continue;
+		}
+
+		if ( Current.Source != nullptr )
+		{
+			// Frame of the stream: the previous entry and whether the next one is nearer, so the key
+			// changes when the layer would switch frame with a nearest or a previous entry policy
+			long long RequestMilliseconds = TimestampIndex::TimestampToMilliseconds( RequestTimestamp );
+			int Previous = Current.Cursor->SearchPrevious( RequestMilliseconds );
+			long long Frame = (long long)Previous*2 + (Current.Source->NearestFromPrevious( Previous, RequestMilliseconds ) != Previous ? 1 : 0);
+
+			try
+			{
+				if ( Current.Cached == false || Frame != Current.CachedFrame || Current.Buffer.rows != WhereToDraw.rows || Current.Buffer.cols != WhereToDraw.cols )
+				{
+					Current.Buffer.create( WhereToDraw.rows, WhereToDraw.cols, CV_8UC3 );
+					Current.Buffer.setTo( cv::Scalar( Current.TransparentColor[0], Current.TransparentColor[1], Current.TransparentColor[2] ) );
+					Current.CachedResult = Current.Layer->Draw( Current.Buffer, RequestTimestamp );
+					Current.CachedFrame = Frame;
+					Current.Cached = true;
+				}
+				else
+				{
+					ReusedLayers++;
+				}
+
+				if ( Current.CachedResult )
+				{
+					Composite( Current, WhereToDraw );
+					Ret = true;
+				}
+
+			} catch (  cv::Exception )
+			{
+				Current.Cached = false;
+			}
+			continue;
+		}
+
+		if ( Current.Alpha >= 256 && Current.UseTransparentColor == false )
+		{
+			// Opaque layer, draw directly
+			Ret = Current.Layer->Draw( WhereToDraw, RequestTimestamp ) || Ret;
+			continue;
+		}
+
+		try
+		{
+			// Draw the layer on its background, no allocation once the buffer has the right size
+			Current.Buffer.create( WhereToDraw.rows, WhereToDraw.cols, CV_8UC3 );
+			Current.Buffer.setTo( cv::Scalar( Current.TransparentColor[0], Current.TransparentColor[1], Current.TransparentColor[2] ) );
+			if ( Current.Layer->Draw( Current.Buffer, RequestTimestamp ) == false )
+			{
+				continue;
+			}
+
+			Composite( Current, WhereToDraw );
+
+			Ret = true;
+
+		} catch (  cv::Exception )
+		{
+		}
+	}
+
+	return Ret;
+}
@@ -0,0 +1,137 @@
+/**
+ * @file DrawLayers.h
+ * @ingroup Drawing
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __DRAW_LAYERS_H__
+#define __DRAW_LAYERS_H__
+
+#include <vector>
+
+#include "Drawable.h"
+#include "TimestampIndex.h"
+
+namespace MobileRGBD {
+
+/**
+ * @class DrawLayers DrawLayers.cpp DrawLayers.h
+ * @brief Compose several Drawable objects in one image. Each layer has an opacity and may have a
+ *        transparent color (e.g. body index at 50% over video, black background transparent).
+ *        Opaque layers without transparent color are drawn directly in the image; other layers are
+ *        drawn in their own buffer (so a layer can not modify the others, see DrawLocalization) and
+ *        blended in one pass over the image (SSE2 when available).
+ *        A layer following a low rate stream (map, skeletons, faces...) can be cached (see SetLayerSource):
+ *        it is drawn again only when its frame in the stream or the image size changes, otherwise its
+ *        buffer is composited directly.
+ *        Layers are not deleted by this object.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class DrawLayers : public Drawable
+{
+public:
+	/** @brief constructor. No layer.
+	 */
+	DrawLayers()
+	{
+		ReusedLayers = 0;
+	}
+
+	/** @brief Virtual destructor, always.
+	 */
+	virtual ~DrawLayers();
+
+	/** @brief Not copyable: cached layers own their Source and Cursor.
+	 */
+	DrawLayers( const DrawLayers& ) = delete;
+	DrawLayers& operator=( const DrawLayers& ) = delete;
+
+	/** @brief Add a layer over the previous ones.
+	 *
+	 * @param Layer [in] Drawable of the layer.
+	 * @param Opacity [in] Opacity of the layer, from 0.0 (invisible) to 1.0 (Default = 1.0).
+	 */
+	void AddLayer( Drawable * Layer, float Opacity = 1.0f );
+
+	/** @brief Add a layer over the previous ones, pixels of the transparent color are not drawn.
+	 *
+	 * @param Layer [in] Drawable of the layer.
+	 * @param Opacity [in] Opacity of the layer, from 0.0 (invisible) to 1.0.
+	 * @param TransparentColor [in] BGR color of transparent pixels (background of the layer).
+	 */
+	void AddLayer( Drawable * Layer, float Opacity, const cv::Vec3b& TransparentColor );
+
+	/** @brief Cache a layer: it is drawn again only when the frame of its stream at the requested timestamp
+	 *         or the image size changes. A cached layer is drawn in its own buffer, so an opaque cached layer
+	 *         without transparent color replaces the image below it.
+	 *
+	 * @param LayerNumber [in] Layer, in the order of AddLayer calls.
+	 * @param TimestampFile [in] Timestamp file of the stream drawn by the layer.
+	 * @return true if the timestamp file was read.
+	 */
+	bool SetLayerSource( int LayerNumber, const std::string& TimestampFile );
+
+	/** @brief Get the number of layers.
+	 */
+	int GetNumberOfLayers() const
+	{
+		return (int)Layers.size();
+	}
+
+	/** @brief Get the number of times a cached layer was composited without drawing it again.
+	 */
+	long long GetNumberOfReusedLayers() const
+	{
+		return ReusedLayers;
+	}
+
+	/** @brief Draw all layers in image.
+	 *
+	 * @param WhereToDraw [in] Drawing cv::Mat (BGR).
+	 * @param RequestTimestamp [in] Timestamp of the data.
+	 * @return true if at least one layer was drawn.
+	 */
+	virtual bool Draw( cv::Mat& WhereToDraw, const TimeB &RequestTimestamp );
+
+	/** @brief Blend a line of BGR pixels over another one: WhereToDraw = (Layer*Alpha + WhereToDraw*(256-Alpha))/256.
+	 *
+	 * @param Layer [in] Pixels of the layer.
+	 * @param WhereToDraw [in,out] Pixels to blend into.
+	 * @param NumberOfPixels [in] Number of pixels of the line.
+	 * @param Alpha [in] Opacity from 0 to 256.
+	 * @param TransparentColor [in] BGR color of pixels to skip, nullptr if none.
+	 */
+	static void BlendLine( const unsigned char * Layer, unsigned char * WhereToDraw, int NumberOfPixels, int Alpha, const unsigned char * TransparentColor );
+
+protected:
+	/**
+	 * @struct LayerInfo
+	 * @brief A layer and its blending parameters.
+	 */
+	struct LayerInfo
+	{
+		Drawable * Layer;				/*!< @brief Drawable of the layer */
+		int Alpha;						/*!< @brief Opacity from 0 to 256 */
+		bool UseTransparentColor;		/*!< @brief Are TransparentColor pixels skipped? */
+		unsigned char TransparentColor[3];	/*!< @brief BGR color of transparent pixels */
+		cv::Mat Buffer;					/*!< @brief Image of the layer, kept from frame to frame */
+		TimestampIndex * Source;		/*!< @brief Timestamps of the stream of a cached layer, nullptr if not cached */
+		TimestampCursor * Cursor;		/*!< @brief Search in Source */
+		bool Cached;					/*!< @brief Does Buffer contain a drawn frame? */
+		long long CachedFrame;			/*!< @brief Frame of the stream drawn in Buffer */
+		bool CachedResult;				/*!< @brief Result of the Draw call that filled Buffer */
+	};
+
+	/** @brief Blend the buffer of a layer in the image.
+	 */
+	static void Composite( const LayerInfo& Current, cv::Mat& WhereToDraw );
+
+	std::vector<LayerInfo> Layers;		/*!< @brief Layers, from bottom to top */
+	long long ReusedLayers;				/*!< @brief Number of cached layers composited without drawing */
+};
+
+} // namespace MobileRGBD
+
+#endif // __DRAW_LAYERS_H__
@@ -19,6 +19,9 @@ bool DrawLocalization::ProcessElement( const TimeB &RequestTimestamp, void * Use
 {
 	cv::Mat& WhereToDraw = *((cv::Mat*)UserData);
 
+	DRAWING_FRAME_READ( 1, strlen(DataBuffer) );
+	DRAWING_STAGE_TIMER( OverlayStage );
+
 	float x, y, o;
 	if ( (sscanf(DataBuffer, "{\"x\":%f,\"y\":%f,\"o\":%f}", &x, &y, &o )) != 3 )
 	{
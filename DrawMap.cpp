@@ -67,6 +67,9 @@ bool DrawMap::ProcessElement( const TimeB &RequestTimestamp, void * UserData )
 {
 	cv::Mat& WhereToDraw = *((cv::Mat*)UserData);
 
+	DRAWING_FRAME_READ( 1, strlen(DataBuffer) );
+	DRAWING_STAGE_TIMER( OverlayStage );
+
 	if ( Map.segments.size() == 0 )
 	{
 		// Nothing to draw, thus we draw it!
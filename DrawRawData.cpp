@@ -7,4 +7,249 @@
 
 #include "DrawRawData.h"
 
+#undef min
+#undef max
+#include <algorithm>
+
 using namespace MobileRGBD;
+
+/** @brief Open a proxy of the raw file: a smaller version of each frame, stored in the same order
+ *         so it uses the same timestamp file. Nothing is done if the proxy file does not exist.
+ *
+ * @param ProxyRawFile [in] Proxy raw file.
+ * @param ProxyFrameSize [in] Size of each frame in the proxy raw file.
+ * @param _ProxyWidth [in] Width of proxy frames.
+ * @param _ProxyHeight [in] Height of proxy frames.
+ * @return true if the proxy is available.
+ */
+bool DrawRawData::OpenProxy( const std::string& ProxyRawFile, int ProxyFrameSize, int _ProxyWidth, int _ProxyHeight )
+{
+	if ( Proxy != nullptr )
+	{
+		delete Proxy;
+		Proxy = nullptr;
+	}
+
+	if ( CompanionRawData::FileExists( ProxyRawFile ) == false )
+	{
+		return false;
+	}
+
+	Proxy = new CompanionRawData( *this, ProxyCompanion, TimestampFileName, ProxyRawFile, ProxyFrameSize );
+	ProxyWidth = _ProxyWidth;
+	ProxyHeight = _ProxyHeight;
+
+	return true;
+}
+
+/** @brief Draw data in image. Read the proxy if available, allowed and large enough, otherwise the raw file.
+ * @param WhereToDraw [in] Drawing cv::Mat.
+ * @param RequestTimestamp [in] Timestamp of the data.
+ */
+bool DrawRawData::Draw( cv::Mat& WhereToDraw, const TimeB &RequestTimestamp )
+{
+	if ( LiveSource != nullptr )
+	{
+		return DrawLive( WhereToDraw );
+	}
+
+	if ( CanUseProxy( WhereToDraw ) == false )
+	{
+		return DrawTimestampRawData::Draw( WhereToDraw, RequestTimestamp );
+	}
+
+	DRAWING_STREAM_SCOPE();
+
+	return Proxy->Process( RequestTimestamp, (void*)&WhereToDraw );
+}
+
+/** @brief Draw the same frame at several sizes from one read and one conversion. The largest target
+ *         is drawn with Draw (so the proxy is used if it is large enough for it), others are downsampled
+ *         from the smallest already drawn target containing them, from the largest to the smallest.
+ *
+ * @param Targets [in] Drawing cv::Mat, of any size and in any order. Empty ones are ignored.
+ * @param RequestTimestamp [in] Timestamp of the data.
+ * @return the result of Draw on the largest target.
+ */
+bool DrawRawData::DrawCascade( std::vector<cv::Mat>& Targets, const TimeB &RequestTimestamp )
+{
+	// Targets from the largest to the smallest
+	std::vector<int> Order;
+	for( int t = 0; t < (int)Targets.size(); t++ )
+	{
+		if ( Targets[t].empty() == false )
+		{
+			Order.push_back( t );
+		}
+	}
+	if ( Order.empty() )
+	{
+		return true;
+	}
+
+	std::stable_sort( Order.begin(), Order.end(), [&Targets]( int a, int b ) { return Targets[a].total() > Targets[b].total(); } );
+
+	// Only the largest one reads and converts the frame
+	if ( Draw( Targets[Order[0]], RequestTimestamp ) == false )
+	{
+		return false;
+	}
+
+	DRAWING_STAGE_TIMER( ResizeStage );
+
+	try
+	{
+		for( size_t i = 1; i < Order.size(); i++ )
+		{
+			cv::Mat& Target = Targets[Order[i]];
+
+			// Smallest drawn target containing this one, the largest one otherwise
+			int Source = Order[0];
+			for( size_t j = 0; j < i; j++ )
+			{
+				const cv::Mat& Candidate = Targets[Order[j]];
+				if ( Candidate.cols >= Target.cols && Candidate.rows >= Target.rows && Candidate.total() <= Targets[Source].total() )
+				{
+					Source = Order[j];
+				}
+			}
+
+			const cv::Mat& From = Targets[Source];
+			if ( From.cols == Target.cols && From.rows == Target.rows )
+			{
+				From.copyTo( Target );
+			}
+			else
+			{
+				// Area interpolation when reducing, no aliasing on thumbnails
+				bool Reduce = From.cols >= Target.cols && From.rows >= Target.rows;
+				cv::resize( From, Target, cv::Size(Target.cols,Target.rows), 0, 0, Reduce ? cv::INTER_AREA : cv::INTER_LINEAR );
+			}
+		}
+	} catch (  cv::Exception )
+	{
+	}
+
+	return true;
+}
+
+/** @brief Copy a converted frame in the final image, resizing it if needed. Does not allocate memory
+ *         if WhereToDraw is a BGR image.
+ *
+ * @param MatForConversion [in] Converted frame (BGR).
+ * @param WhereToDraw [in] Final image.
+ */
+// static
+void DrawRawData::CopyToFinalSize( const cv::Mat& MatForConversion, cv::Mat& WhereToDraw )
+{
+	// Resize it to final size, directly in WhereToDraw: no allocation as long as WhereToDraw has the
+	// right type (it may be a part of a larger image)
+	if ( MatForConversion.rows != WhereToDraw.rows || MatForConversion.cols != WhereToDraw.cols )
+	{
+		cv::resize( MatForConversion, WhereToDraw, cv::Size(WhereToDraw.cols,WhereToDraw.rows), 0, 0 );
+	}
+	else
+	{
+		MatForConversion.copyTo( WhereToDraw );
+	}
+}
+
+/** @brief Draw frames from an in memory stream (live capture) instead of the files. Frames are read
+ *         without copy; the last read frame is kept (and drawn again) until a new one is published.
+ *         Drawing thread is the consumer of the ring.
+ *
+ * @param Source [in] In memory stream, its frames must have the size of frames of this stream. nullptr to read files again.
+ * @param Mode [in] Read all frames in order or only the latest one (Default = LatestFrameWins).
+ */
+void DrawRawData::SetLiveSource( FrameRing * Source, FrameRing::ReadMode Mode /* = FrameRing::LatestFrameWins */ )
+{
+	if ( LiveFrame != nullptr )
+	{
+		LiveSource->Release( LiveFrame );
+		LiveFrame = nullptr;
+	}
+
+	LiveSource = Source;
+	LiveMode = Mode;
+}
+
+/** @brief Draw the current frame of the live source with ProcessElement.
+ *
+ * @param WhereToDraw [in] Drawing cv::Mat.
+ * @return false if no frame was ever published.
+ */
+bool DrawRawData::DrawLive( cv::Mat& WhereToDraw )
+{
+	if ( LiveSource->GetFrameSize() != FrameSize )
+	{
+		return false;
+	}
+
+	RingFrame * NewFrame = LiveSource->AcquireForReading( LiveMode );
+	if ( NewFrame != nullptr )
+	{
+		if ( LiveFrame != nullptr )
+		{
+			LiveSource->Release( LiveFrame );
+		}
+		LiveFrame = NewFrame;
+	}
+
+	if ( LiveFrame == nullptr )
+	{
+		return false;
+	}
+
+	DRAWING_STREAM_SCOPE();
+
+	// Process the frame of the ring in place
+	decltype(FrameBuffer) SavedFrameBuffer = FrameBuffer;
+	FrameBuffer = (decltype(FrameBuffer))LiveFrame->Data;
+
+	bool Ret = ProcessElement( LiveFrame->Timestamp, (void*)&WhereToDraw );
+
+	FrameBuffer = SavedFrameBuffer;
+
+	return Ret;
+}
+
+/** @brief Set the dirty tile mode: raw frames are compared with the previous one tile by tile and
+ *         only changed tiles are converted again (see DirtyTiles). Saves conversion time on still scenes.
+ *         Only used by views drawing raw frames tile by tile (depth, infrared and body index).
+ *
+ * @param Value [in] Use dirty tiles or not (Default = false).
+ * @param Tolerance [in] Maximum difference of a raw value still considered unchanged (Default = 0).
+ */
+void DrawRawData::SetDirtyTiles( bool Value, int Tolerance /* = 0 */ )
+{
+	UseDirtyTiles = Value;
+	DirtyTolerance = Tolerance;
+
+	// Created again at next use with the new tolerance
+	delete Tiles;
+	Tiles = nullptr;
+}
+
+/** @brief Get the change detection of raw frames in dirty tile mode, created at first use.
+ *
+ * @param Width [in] Width of raw frames.
+ * @param Height [in] Height of raw frames.
+ * @param BytesPerValue [in] Size of raw values, 1 or 2 bytes.
+ * @param OutputChannels [in] Number of bytes per pixel in the output frame.
+ * @return nullptr if not in dirty tile mode.
+ */
+DirtyTiles * DrawRawData::GetDirtyTiles( int Width, int Height, int BytesPerValue, int OutputChannels )
+{
+	if ( UseDirtyTiles == false )
+	{
+		return nullptr;
+	}
+
+	if ( Tiles == nullptr || Tiles->Matches( Width, Height, BytesPerValue, OutputChannels ) == false )
+	{
+		delete Tiles;
+		Tiles = new DirtyTiles( Width, Height, BytesPerValue, OutputChannels, DirtyTolerance );
+	}
+
+	return Tiles;
+}
@@ -13,8 +13,13 @@
 #endif
 
 #include "DrawTimestampRawData.h"
+#include "CompanionRawData.h"
+#include "FrameRing.h"
+#include "DirtyTiles.h"
 #include "Drawable.h"
 
+#include <vector>
+
 namespace MobileRGBD {
 
 /**
@@ -35,11 +40,152 @@ public:
 	DrawRawData( const std::string& WorkingFile, const std::string& RawFile, int SizeOfFrame )
 		: DrawTimestampRawData( WorkingFile, RawFile, SizeOfFrame )
 	{
+		Proxy = nullptr;
+		ProxyWidth = 0;
+		ProxyHeight = 0;
+		UseProxy = true;
+		LiveSource = nullptr;
+		LiveMode = FrameRing::LatestFrameWins;
+		LiveFrame = nullptr;
+		UseDirtyTiles = false;
+		DirtyTolerance = 0;
+		Tiles = nullptr;
 	}
 
 	/** @brief Virtual destructor, always.
 	 */
-	virtual ~DrawRawData() {}
+	virtual ~DrawRawData()
+	{
+		SetLiveSource( nullptr );
+		if ( Proxy != nullptr )
+		{
+			delete Proxy;
+		}
+		delete Tiles;
+	}
+
+	/** @brief Draw frames from an in memory stream (live capture) instead of the files. Frames are read
+	 *         without copy; the last read frame is kept (and drawn again) until a new one is published.
+	 *         Drawing thread is the consumer of the ring.
+	 *
+	 * @param Source [in] In memory stream, its frames must have the size of frames of this stream. nullptr to read files again.
+	 * @param Mode [in] Read all frames in order or only the latest one (Default = LatestFrameWins).
+	 */
+	void SetLiveSource( FrameRing * Source, FrameRing::ReadMode Mode = FrameRing::LatestFrameWins );
+
+	/** @brief Set the dirty tile mode: raw frames are compared with the previous one tile by tile and
+	 *         only changed tiles are converted again (see DirtyTiles). Saves conversion time on still scenes.
+	 *         Only used by views drawing raw frames tile by tile (depth, infrared and body index).
+	 *
+	 * @param Value [in] Use dirty tiles or not (Default = false).
+	 * @param Tolerance [in] Maximum difference of a raw value still considered unchanged (Default = 0).
+	 */
+	void SetDirtyTiles( bool Value, int Tolerance = 0 );
+
+	/** @brief Get the fraction of the frame redrawn for the last raw frame in dirty tile mode (1 otherwise).
+	 */
+	float GetRedrawnFraction() const
+	{
+		return Tiles == nullptr ? 1.0f : Tiles->GetRedrawnFraction();
+	}
+
+	/** @brief Get the average fraction of the frame redrawn since dirty tile mode was set (1 otherwise).
+	 */
+	float GetAverageRedrawnFraction() const
+	{
+		return Tiles == nullptr ? 1.0f : Tiles->GetAverageRedrawnFraction();
+	}
+
+	enum { ProxyCompanion = 0 };	/*!< @brief Companion id of the proxy stream in ProcessCompanionElement */
+
+	/** @brief Open a proxy of the raw file: a smaller version of each frame, stored in the same order
+	 *         so it uses the same timestamp file. Nothing is done if the proxy file does not exist.
+	 *
+	 * @param ProxyRawFile [in] Proxy raw file.
+	 * @param ProxyFrameSize [in] Size of each frame in the proxy raw file.
+	 * @param _ProxyWidth [in] Width of proxy frames.
+	 * @param _ProxyHeight [in] Height of proxy frames.
+	 * @return true if the proxy is available.
+	 */
+	bool OpenProxy( const std::string& ProxyRawFile, int ProxyFrameSize, int _ProxyWidth, int _ProxyHeight );
+
+	/** @brief Is a proxy available for this stream?
+	 */
+	bool IsProxyAvailable() const
+	{
+		return Proxy != nullptr;
+	}
+
+	/** @brief Set if the proxy (if available) must be read when the target image is not larger than proxy frames (Default = true).
+	 *
+	 * @param Value [in] Use proxy or not.
+	 */
+	void SetUseProxy( bool Value )
+	{
+		UseProxy = Value;
+	}
+
+	/** @brief Draw data in image. Read the proxy if available, allowed and large enough, otherwise the raw file.
+	 * @param WhereToDraw [in] Drawing cv::Mat.
+	 * @param RequestTimestamp [in] Timestamp of the data.
+	 */
+	virtual bool Draw( cv::Mat& WhereToDraw, const TimeB &RequestTimestamp );
+
+	/** @brief Draw the same frame at several sizes from one read and one conversion. The largest target
+	 *         is drawn with Draw (so the proxy is used if it is large enough for it), others are downsampled
+	 *         from the smallest already drawn target containing them, from the largest to the smallest.
+	 *
+	 * @param Targets [in] Drawing cv::Mat, of any size and in any order. Empty ones are ignored.
+	 * @param RequestTimestamp [in] Timestamp of the data.
+	 * @return the result of Draw on the largest target.
+	 */
+	bool DrawCascade( std::vector<cv::Mat>& Targets, const TimeB &RequestTimestamp );
+
+protected:
+	/** @brief Copy a converted frame in the final image, resizing it if needed. Does not allocate memory
+	 *         if WhereToDraw is a BGR image.
+	 *
+	 * @param MatForConversion [in] Converted frame (BGR).
+	 * @param WhereToDraw [in] Final image.
+	 */
+	static void CopyToFinalSize( const cv::Mat& MatForConversion, cv::Mat& WhereToDraw );
+
+	/** @brief Is the proxy available, allowed and large enough to draw in an image?
+	 *
+	 * @param WhereToDraw [in] Final image.
+	 */
+	bool CanUseProxy( const cv::Mat& WhereToDraw ) const
+	{
+		return Proxy != nullptr && UseProxy && WhereToDraw.cols <= ProxyWidth && WhereToDraw.rows <= ProxyHeight;
+	}
+
+	/** @brief Draw the current frame of the live source with ProcessElement.
+	 *
+	 * @param WhereToDraw [in] Drawing cv::Mat.
+	 * @return false if no frame was ever published.
+	 */
+	bool DrawLive( cv::Mat& WhereToDraw );
+
+	/** @brief Get the change detection of raw frames in dirty tile mode, created at first use.
+	 *
+	 * @param Width [in] Width of raw frames.
+	 * @param Height [in] Height of raw frames.
+	 * @param BytesPerValue [in] Size of raw values, 1 or 2 bytes.
+	 * @param OutputChannels [in] Number of bytes per pixel in the output frame.
+	 * @return nullptr if not in dirty tile mode.
+	 */
+	DirtyTiles * GetDirtyTiles( int Width, int Height, int BytesPerValue, int OutputChannels );
+
+	CompanionRawData * Proxy;		/*!< @brief Proxy stream, nullptr if not available */
+	int ProxyWidth;					/*!< @brief Width of proxy frames */
+	int ProxyHeight;				/*!< @brief Height of proxy frames */
+	bool UseProxy;					/*!< @brief Read the proxy when possible */
+	FrameRing * LiveSource;			/*!< @brief In memory stream, nullptr when reading files */
+	FrameRing::ReadMode LiveMode;	/*!< @brief How frames are read from LiveSource */
+	RingFrame * LiveFrame;			/*!< @brief Last frame read from LiveSource, kept until a new one arrives */
+	bool UseDirtyTiles;				/*!< @brief Convert only changed tiles of raw frames */
+	int DirtyTolerance;				/*!< @brief Maximum difference of an unchanged raw value */
+	DirtyTiles * Tiles;				/*!< @brief Change detection in dirty tile mode, nullptr until first use */
 };
 
 } // namespace MobileRGBD
@@ -13,6 +13,25 @@ using namespace cv;
 
 namespace MobileRGBD { namespace Kinect2 {
 
+/** @brief Draw trajectories of joints over a time window with skeletons (see SkeletonTrails).
+ *
+ * @param Joints [in] Joints to follow (Kinect joint types).
+ * @param Extractor [in] Function giving the position of a joint in a body sub-frame.
+ * @param PastSeconds [in] Duration of trails before the current timestamp (Default = 2.0).
+ * @param FutureSeconds [in] Duration of trails after the current timestamp (Default = 0.0).
+ */
+void DrawSkeleton::SetTrails( const std::vector<int>& Joints, SkeletonTrails::JointExtractor Extractor, float PastSeconds /* = 2.0f */, float FutureSeconds /* = 0.0f */ )
+{
+	if ( Trails == nullptr )
+	{
+		// Trails read the raw file with the presence index
+		Trails = new SkeletonTrails( GetPresenceIndex(), RawFileName, FrameSize );
+	}
+
+	Trails->SetJoints( Joints, Extractor );
+	Trails->SetWindow( PastSeconds, FutureSeconds );
+}
+
 /** @brief ProcessElement is a callback function called by mother classes when data are ready.
  *
  * @param RequestTimestamp [in] The timestamp of the data.
@@ -22,12 +41,27 @@ bool DrawSkeleton::ProcessElement( const TimeB &RequestTimestamp, void * UserDat
 {
 	cv::Mat& WhereToDraw = *((cv::Mat*)UserData);
 
+	DRAWING_FRAME_READ( NumberOfSubFrames, NumberOfSubFrames*FrameSize );
+
+	if ( Trails != nullptr )
+	{
+		DRAWING_STAGE_TIMER( OverlayStage );
+
+		// Trails are drawn even without body in the current frame
+		Trails->Update( TimestampIndex::TimestampToMilliseconds( RequestTimestamp ), DrawInDepth );
+		float ReferenceWidth = (float)(DrawInDepth ? DepthWidth : CamWidth);
+		float ReferenceHeight = (float)(DrawInDepth ? DepthHeight : CamHeight);
+		Trails->Draw( WhereToDraw, (float)WhereToDraw.cols/ReferenceWidth, (float)WhereToDraw.rows/ReferenceHeight );
+	}
+
 	if ( NumberOfSubFrames == 0 )
 	{
 		// Nothing to Draw, draw is done
 		return true;
 	}
 
+	DRAWING_STAGE_TIMER( OverlayStage );
+
 	for( int i = 0; i < NumberOfSubFrames; i++ )
 	{
 		// Set memory to store Body
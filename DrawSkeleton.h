@@ -17,6 +17,8 @@
 #ifdef KINECT_2
 
 #include "DrawRawData.h"
+#include "PresenceIndex.h"
+#include "SkeletonTrails.h"
 #include "Kinect/KinectBody.h"
 
 #define RawSkeletonFileName "/skeleton/skeleton.raw"
@@ -48,11 +50,47 @@ public:
 		// Correct size of frame
 		CurrentBody.Set((unsigned char*)nullptr);
 		FrameSize = CurrentBody.BodySize;
+
+		PresenceOpened = false;
+		Trails = nullptr;
 	}
 
 	/** @brief Virtual destructor, always.
 	 */
-	virtual ~DrawSkeleton() {};
+	virtual ~DrawSkeleton()
+	{
+		delete Trails;
+	};
+
+	/** @brief Draw trajectories of joints over a time window with skeletons (see SkeletonTrails).
+	 *
+	 * @param Joints [in] Joints to follow (Kinect joint types).
+	 * @param Extractor [in] Function giving the position of a joint in a body sub-frame.
+	 * @param PastSeconds [in] Duration of trails before the current timestamp (Default = 2.0).
+	 * @param FutureSeconds [in] Duration of trails after the current timestamp (Default = 0.0).
+	 */
+	void SetTrails( const std::vector<int>& Joints, SkeletonTrails::JointExtractor Extractor, float PastSeconds = 2.0f, float FutureSeconds = 0.0f );
+
+	/** @brief Stop drawing trails.
+	 */
+	void RemoveTrails()
+	{
+		delete Trails;
+		Trails = nullptr;
+	}
+
+	/** @brief Get the presence index of the stream (number of bodies of each frame), opened at first call.
+	 *         Used to jump to frames with bodies without reading frames (see PresenceIndex).
+	 */
+	const PresenceIndex& GetPresenceIndex()
+	{
+		if ( PresenceOpened == false )
+		{
+			Presence.Open( TimestampFileName );
+			PresenceOpened = true;
+		}
+		return Presence;
+	}
 
 	bool DrawInDepth;	/*!< @brief Boolean value to store if we draw in Depth or in Video (for scaling purpose) */
 
@@ -65,6 +103,9 @@ protected:
 	virtual bool ProcessElement( const TimeB &RequestTimestamp, void * UserData = nullptr );
 
 	KinectBody CurrentBody;		/*!< @brief KinectBody object to store data to draw */
+	PresenceIndex Presence;		/*!< @brief Number of bodies of each frame */
+	bool PresenceOpened;		/*!< @brief Was Presence opened? */
+	SkeletonTrails * Trails;	/*!< @brief Trails of joints, nullptr if not drawn */
 };
 
 }}	// namespace MobileRGBD::Kinect2
@@ -17,15 +17,52 @@ using namespace MobileRGBD;
  */
 DrawTimestampData::DrawTimestampData( const std::string &WorkingFile )
 	: ReadTimestampFile( WorkingFile )
+	DRAWING_STATS_INIT( WorkingFile )
 {
+	TimestampFileName = WorkingFile;
+	UseCursor = true;
 }
 
 
-/** @brief Draw data in image. Will call the Process function.
+/** @brief Draw data in image. Requests are read through a cursor (see CursorReader), or searched by
+ *         the Process function if the cursor is not used.
  * @param WhereToDraw [in] Drawing cv::Mat.
  * @param pTimestamp [in] Timestamp of the data.
  */
 bool DrawTimestampData::Draw( Mat& WhereToDraw, const TimeB &RequestTimestamp )
 {
+	DRAWING_STREAM_SCOPE();
+
+	// Opened at first use, when subclasses are constructed
+	if ( UseCursor && Reader.IsOpen() == false && Reader.Open( TimestampFileName, "", false ) == false )
+	{
+		UseCursor = false;
+	}
+
+	if ( UseCursor )
+	{
+		int Entry = Reader.Search( TimestampIndex::TimestampToMilliseconds( RequestTimestamp ) );
+		if ( Entry == CursorReader::NotFound )
+		{
+			return false;
+		}
+
+		char * EntryData = Reader.ReadData( Entry );
+		if ( EntryData == nullptr )
+		{
+			return false;
+		}
+
+		// Process the line read by offset in place
+		decltype(DataBuffer) SavedDataBuffer = DataBuffer;
+		DataBuffer = (decltype(DataBuffer))EntryData;
+
+		bool Ret = ProcessElement( RequestTimestamp, (void*)&WhereToDraw );
+
+		DataBuffer = SavedDataBuffer;
+
+		return Ret;
+	}
+
 	return Process( RequestTimestamp, (void*)&WhereToDraw );
 }
@@ -15,6 +15,7 @@
 #include "opencv2/imgproc/imgproc.hpp"
 
 #include "Drawable.h"
+#include "CursorReader.h"
 #include "../DataManagement/ReadTimestampRawFile.h"
 
 #if defined WIN32 || defined WIN64
@@ -43,11 +44,42 @@ public:
 	 */
 	virtual ~DrawTimestampData() {}
 
-	/** @brief Draw data in image. Will call the Process function.
+	/** @brief Draw data in image. Requests are read through a cursor (see CursorReader), or searched by
+	 *         the Process function if the cursor is not used.
 	 * @param WhereToDraw [in] Drawing cv::Mat.
 	 * @param pTimestamp [in] Timestamp of the data.
 	 */
 	virtual bool Draw( cv::Mat& WhereToDraw, const TimeB &pTimestamp );
+
+	/** @brief Set if requests are read through a cursor or searched by the Process function.
+	 *
+	 * @param Value [in] Use the cursor or not (Default = true).
+	 */
+	void SetUseCursor( bool Value = true )
+	{
+		UseCursor = Value;
+	}
+
+	/** @brief Are requests read through a cursor?
+	 */
+	bool GetUseCursor() const
+	{
+		return UseCursor;
+	}
+
+	/** @brief Get the timestamp file of this stream.
+	 */
+	const std::string& GetTimestampFileName() const
+	{
+		return TimestampFileName;
+	}
+
+	DRAWING_STATS_MEMBER	/*!< @brief Timing statistics (DRAWING_PROFILING) and trace name (DRAWING_TRACING) of this stream */
+
+protected:
+	std::string TimestampFileName;		/*!< @brief Timestamp file of this stream */
+	CursorReader Reader;				/*!< @brief Cursor on the stream, opened at first use */
+	bool UseCursor;						/*!< @brief Read requests through Reader */
 };
 
 } // namespace MobileRGBD
@@ -17,14 +17,65 @@ using namespace MobileRGBD;
  */
 DrawTimestampRawData::DrawTimestampRawData( const std::string &WorkingFile, const std::string& RawFile /* = "" */, int SizeOfFrame /* = 0  */ )
 	: ReadTimestampRawFile( WorkingFile, RawFile, SizeOfFrame )
+	DRAWING_STATS_INIT( WorkingFile )
 {
+	TimestampFileName = WorkingFile;
+	RawFileName = RawFile;
+	UseCursor = true;
 }
 
-/** @brief Draw data in image. Will call the Process function.
+/** @brief Draw data in image. Requests are read through a cursor (see CursorReader), or searched by
+ *         the Process function if the cursor is not used.
  * @param WhereToDraw [in] Drawing cv::Mat.
  * @param pTimestamp [in] Timestamp of the data.
  */
 bool DrawTimestampRawData::Draw( Mat& WhereToDraw, const TimeB &RequestTimestamp )
 {
+	DRAWING_STREAM_SCOPE();
+
+	// Opened at first use, when subclasses have set Mode and FrameSize. Raw files starting
+	// after the first frame of their timestamp file are only read by the Process function.
+	if ( UseCursor && Reader.IsOpen() == false &&
+		 (StartingFrame != 0 || Reader.Open( TimestampFileName, RawFileName, Mode == SubFramesMode ) == false) )
+	{
+		UseCursor = false;
+	}
+
+	if ( UseCursor )
+	{
+		int Entry = Reader.Search( TimestampIndex::TimestampToMilliseconds( RequestTimestamp ) );
+		if ( Entry == CursorReader::NotFound )
+		{
+			return false;
+		}
+
+		int NumberOfFrames;
+		void * EntryFrames = Reader.ReadFrames( Entry, FrameSize, NumberOfFrames );
+		char * EntryData = Reader.ReadData( Entry );
+		if ( EntryFrames == nullptr || EntryData == nullptr )
+		{
+			return false;
+		}
+
+		// Process frames and line read by offset in place
+		decltype(FrameBuffer) SavedFrameBuffer = FrameBuffer;
+		decltype(DataBuffer) SavedDataBuffer = DataBuffer;
+		decltype(NumberOfSubFrames) SavedNumberOfSubFrames = NumberOfSubFrames;
+		FrameBuffer = (decltype(FrameBuffer))EntryFrames;
+		DataBuffer = (decltype(DataBuffer))EntryData;
+		if ( Mode == SubFramesMode )
+		{
+			NumberOfSubFrames = NumberOfFrames;
+		}
+
+		bool Ret = ProcessElement( RequestTimestamp, (void*)&WhereToDraw );
+
+		FrameBuffer = SavedFrameBuffer;
+		DataBuffer = SavedDataBuffer;
+		NumberOfSubFrames = SavedNumberOfSubFrames;
+
+		return Ret;
+	}
+
 	return Process( RequestTimestamp, (void*)&WhereToDraw );
 }
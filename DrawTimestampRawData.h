@@ -14,11 +14,14 @@
 #endif
 
 #include "Drawable.h"
+#include "CursorReader.h"
 #include "../DataManagement/ReadTimestampRawFile.h"
 
 
 namespace MobileRGBD {
 
+class CompanionRawData;
+
 /**
  * @class DrawTimestampRawData DrawTimestampRawData.cpp DrawTimestampRawData.h
  * @brief Mother class for all drawing complex class (*with* an associated raw file).
@@ -40,11 +43,63 @@ public:
 	 */
 	~DrawTimestampRawData() {}
 
-	/** @brief Draw data in image. Will call the Process function.
+	/** @brief Draw data in image. Requests are read through a cursor (see CursorReader), or searched by
+	 *         the Process function if the cursor is not used.
 	 * @param WhereToDraw [in] Drawing cv::Mat.
 	 * @param pTimestamp [in] Timestamp of the data.
 	 */
 	virtual bool Draw( cv::Mat& WhereToDraw, const TimeB &pTimestamp );
+
+	/** @brief Set if requests are read through a cursor or searched by the Process function.
+	 *
+	 * @param Value [in] Use the cursor or not (Default = true).
+	 */
+	void SetUseCursor( bool Value = true )
+	{
+		UseCursor = Value;
+	}
+
+	/** @brief Are requests read through a cursor?
+	 */
+	bool GetUseCursor() const
+	{
+		return UseCursor;
+	}
+
+	/** @brief Get the timestamp file of this stream.
+	 */
+	const std::string& GetTimestampFileName() const
+	{
+		return TimestampFileName;
+	}
+
+	/** @brief Get the starting frame of this stream in its raw file.
+	 */
+	int GetStartingFrame() const
+	{
+		return StartingFrame;
+	}
+
+	/** @brief ProcessCompanionElement is a callback function called by companion streams (see CompanionRawData)
+	 *         of this object when their data are ready. Default is to do nothing.
+	 *
+	 * @param CompanionId [in] Id of the companion given at its creation.
+	 * @param Companion [in] The companion stream, its frame is available with GetFrame().
+	 * @param RequestTimestamp [in] The timestamp of the data.
+	 * @param UserData [in] User pointer to working data.
+	 */
+	virtual bool ProcessCompanionElement( int CompanionId, CompanionRawData& Companion, const TimeB &RequestTimestamp, void * UserData )
+	{
+		return false;
+	}
+
+	DRAWING_STATS_MEMBER	/*!< @brief Timing statistics (DRAWING_PROFILING) and trace name (DRAWING_TRACING) of this stream */
+
+protected:
+	std::string TimestampFileName;		/*!< @brief Timestamp file of this stream */
+	std::string RawFileName;			/*!< @brief Raw file of this stream */
+	CursorReader Reader;				/*!< @brief Cursor on the stream, opened at first use */
+	bool UseCursor;						/*!< @brief Read requests through Reader */
 };
 
 } // namespace MobileRGBD
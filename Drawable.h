@@ -15,6 +15,7 @@
 #include "opencv2/imgproc/imgproc.hpp"
 
 #include "../DataManagement/TimestampTools.h"
+#include "DrawingProfiler.h"
 
 #if defined WIN32 || defined WIN64
 #define _WINSOCKAPI_   /* Prevent inclusion of winsock.h in windows.h */
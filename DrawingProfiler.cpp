@@ -0,0 +1,265 @@
+/**
+ * @file DrawingProfiler.cpp
+ * @ingroup Drawing
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#include "DrawingProfiler.h"
+
+#ifdef DRAWING_PROFILING
+
+#include <stdio.h>
+#include <string.h>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+
+using namespace MobileRGBD;
+
+/* static */ thread_local StreamStats * StreamStats::Current = nullptr;
+/* static */ thread_local unsigned long long StreamStats::CurrentElementNanoseconds = 0;
+
+// List of living streams, protected by a mutex (only used at construction/destruction and dump time)
+static std::mutex & GetStreamListMutex()
+{
+	static std::mutex StreamListMutex;
+	return StreamListMutex;
+}
+
+static std::vector<StreamStats*> & GetStreamList()
+{
+	static std::vector<StreamStats*> StreamList;
+	return StreamList;
+}
+
+/** @brief constructor. Register the stream in the global list of streams.
+ *
+ * @param StreamName [in] Name of the stream (usually the timestamp file name).
+ */
+StreamStats::StreamStats( const std::string& StreamName /* = "" */ )
+	: Name( StreamName )
+{
+	Reset();
+
+	std::lock_guard<std::mutex> Lock( GetStreamListMutex() );
+	GetStreamList().push_back( this );
+}
+
+/** @brief Virtual destructor, always. Unregister the stream.
+ */
+StreamStats::~StreamStats()
+{
+	std::lock_guard<std::mutex> Lock( GetStreamListMutex() );
+	std::vector<StreamStats*>& StreamList = GetStreamList();
+	StreamList.erase( std::remove( StreamList.begin(), StreamList.end(), this ), StreamList.end() );
+}
+
+/** @brief Reset all counters.
+ */
+void StreamStats::Reset()
+{
+	Calls = 0;
+	FramesRead = 0;
+	BytesRead = 0;
+	memset( StageCount, 0, sizeof(StageCount) );
+	memset( StageNanoseconds, 0, sizeof(StageNanoseconds) );
+	memset( StageHistogram, 0, sizeof(StageHistogram) );
+}
+
+/** @brief Compute the histogram bucket of a duration. Values below 4 have their own bucket,
+ *         then each power of 2 is split in 4 sub-buckets.
+ */
+// static
+int StreamStats::GetBucket( unsigned long long Nanoseconds )
+{
+	if ( Nanoseconds < 4 )
+	{
+		return (int)Nanoseconds;
+	}
+
+	// Search the highest bit set
+	int HighestBit;
+#if defined __GNUC__
+	HighestBit = 63 - __builtin_clzll( Nanoseconds );
+#else
+	HighestBit = 0;
+	for( unsigned long long Value = Nanoseconds; Value > 1; Value >>= 1 )
+	{
+		HighestBit++;
+	}
+#endif
+
+	// 2 bits after the highest one give the sub-bucket
+	int SubBucket = (int)((Nanoseconds >> (HighestBit-2)) & 3);
+
+	return 4*(HighestBit-1) + SubBucket;
+}
+
+/** @brief Compute the upper bound of a histogram bucket.
+ */
+// static
+unsigned long long StreamStats::GetBucketUpperBound( int Bucket )
+{
+	if ( Bucket < 4 )
+	{
+		return (unsigned long long)Bucket;
+	}
+
+	int HighestBit = Bucket/4 + 1;
+	int SubBucket = Bucket%4;
+
+	return ((unsigned long long)(4+SubBucket+1) << (HighestBit-2)) - 1;
+}
+
+/** @brief Add a time sample to a stage.
+ *
+ * @param WhichStage [in] Stage of the sample.
+ * @param Nanoseconds [in] Duration of the stage.
+ */
+void StreamStats::AddSample( Stage WhichStage, unsigned long long Nanoseconds )
+{
+	StageCount[WhichStage]++;
+	StageNanoseconds[WhichStage] += Nanoseconds;
+	StageHistogram[WhichStage][GetBucket(Nanoseconds)]++;
+}
+
+/** @brief Compute a percentile from the histogram of a stage. Result is the upper bound of the
+ *         histogram bucket containing the percentile (relative error < 25%).
+ *
+ * @param WhichStage [in] Stage to query.
+ * @param Percentile [in] Percentile in [0, 1] (0.5 for median, 0.99 for p99).
+ * @return the percentile value in nanoseconds, 0 if no sample.
+ */
+unsigned long long StreamStats::GetPercentile( Stage WhichStage, double Percentile ) const
+{
+	if ( StageCount[WhichStage] == 0 )
+	{
+		return 0;
+	}
+
+	unsigned long long Rank = (unsigned long long)(Percentile*(double)StageCount[WhichStage]);
+	if ( Rank >= StageCount[WhichStage] )
+	{
+		Rank = StageCount[WhichStage]-1;
+	}
+
+	unsigned long long Cumulated = 0;
+	for( int Bucket = 0; Bucket < NumberOfBuckets; Bucket++ )
+	{
+		Cumulated += StageHistogram[WhichStage][Bucket];
+		if ( Cumulated > Rank )
+		{
+			return GetBucketUpperBound( Bucket );
+		}
+	}
+
+	return GetBucketUpperBound( NumberOfBuckets-1 );
+}
+
+/** @brief Return the name of a stage as used in JSON output.
+ */
+// static
+const char * StreamStats::GetStageName( Stage WhichStage )
+{
+	static const char * StageNames[NumberOfStages] = { "draw", "fetch", "conversion", "resize", "overlay" };
+
+	return StageNames[WhichStage];
+}
+
+/** @brief Write counters of this stream as a JSON object.
+ */
+std::string StreamStats::ToJson() const
+{
+	std::string Json;
+	char tmpc[512];
+
+	// Escape name (file names on Windows contain '\')
+	std::string EscapedName;
+	for( size_t i = 0; i < Name.size(); i++ )
+	{
+		if ( Name[i] == '\\' || Name[i] == '"' )
+		{
+			EscapedName += '\\';
+		}
+		EscapedName += Name[i];
+	}
+
+	Json = "{\"name\":\"" + EscapedName + "\"";
+	sprintf( tmpc, ",\"calls\":%llu,\"frames_read\":%llu,\"bytes_read\":%llu,\"stages\":{", Calls, FramesRead, BytesRead );
+	Json += tmpc;
+
+	for( int i = 0; i < NumberOfStages; i++ )
+	{
+		Stage WhichStage = (Stage)i;
+		unsigned long long Mean = StageCount[i] == 0 ? 0 : StageNanoseconds[i]/StageCount[i];
+
+		sprintf( tmpc, "%s\"%s\":{\"count\":%llu,\"total_ns\":%llu,\"mean_ns\":%llu,\"p50_ns\":%llu,\"p99_ns\":%llu}",
+			i == 0 ? "" : ",", GetStageName(WhichStage), StageCount[i], StageNanoseconds[i], Mean,
+			GetPercentile(WhichStage, 0.50), GetPercentile(WhichStage, 0.99) );
+		Json += tmpc;
+	}
+
+	Json += "}}";
+
+	return Json;
+}
+
+/** @brief Write counters of all living streams as a JSON object.
+ */
+// static
+std::string StreamStats::AllToJson()
+{
+	std::lock_guard<std::mutex> Lock( GetStreamListMutex() );
+	std::vector<StreamStats*>& StreamList = GetStreamList();
+
+	std::string Json = "{\"streams\":[";
+	for( size_t i = 0; i < StreamList.size(); i++ )
+	{
+		if ( i != 0 )
+		{
+			Json += ",";
+		}
+		Json += StreamList[i]->ToJson();
+	}
+	Json += "]}";
+
+	return Json;
+}
+
+/** @brief Write counters of all living streams as JSON in a file.
+ *
+ * @param FileName [in] Output file.
+ * @return true if the file was written.
+ */
+// static
+bool StreamStats::DumpAllAsJson( const std::string& FileName )
+{
+	FILE * fout = fopen( FileName.c_str(), "wb" );
+	if ( fout == nullptr )
+	{
+		return false;
+	}
+
+	std::string Json = AllToJson();
+	bool Ret = (fwrite( Json.c_str(), 1, Json.size(), fout ) == Json.size());
+	fclose( fout );
+
+	return Ret;
+}
+
+/** @brief Reset counters of all living streams.
+ */
+// static
+void StreamStats::ResetAll()
+{
+	std::lock_guard<std::mutex> Lock( GetStreamListMutex() );
+	std::vector<StreamStats*>& StreamList = GetStreamList();
+
+	for( size_t i = 0; i < StreamList.size(); i++ )
+	{
+		StreamList[i]->Reset();
+	}
+}
+
+#endif // DRAWING_PROFILING
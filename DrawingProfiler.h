@@ -0,0 +1,284 @@
+/**
+ * @file DrawingProfiler.h
+ * @ingroup Drawing
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __DRAWING_PROFILER_H__
+#define __DRAWING_PROFILER_H__
+
+/*
+ * Per-stream timing of the drawing pipeline. Everything in this file is compiled only
+ * if DRAWING_PROFILING is defined. Otherwise, the DRAWING_* macros expand to nothing
+ * (or only to the tracing part if DRAWING_TRACING is defined, see DrawingTrace.h)
+ * and Drawable objects do not carry any statistics member.
+ */
+
+#ifdef DRAWING_PROFILING
+
+#include <string.h>
+#include <string>
+#include <chrono>
+
+namespace MobileRGBD {
+
+/**
+ * @class StreamStats DrawingProfiler.cpp DrawingProfiler.h
+ * @brief Counters and stage timers for one stream (one Drawable object). Each stage keeps
+ *        a count, a total time in nanoseconds and a log-scale histogram to compute p50/p99.
+ *        Counters are not atomic: read them while the stream is not drawing.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class StreamStats
+{
+public:
+	/** @enum StreamStats::Stage
+	 *  @brief Stages measured for each Draw call. FetchStage is the timestamp lookup plus the raw/data read, i.e.
+	 *         the part of the Draw call spent before ProcessElement.
+	 */
+	enum Stage { DrawStage = 0, FetchStage, ConversionStage, ResizeStage, OverlayStage, NumberOfStages };
+
+	/** @brief Number of buckets of the time histogram of each stage (4 sub-buckets per power of 2). */
+	static const int NumberOfBuckets = 256;
+
+	/** @brief constructor. Register the stream in the global list of streams.
+	 *
+	 * @param StreamName [in] Name of the stream (usually the timestamp file name).
+	 */
+	StreamStats( const std::string& StreamName = "" );
+
+	/** @brief Virtual destructor, always. Unregister the stream.
+	 */
+	virtual ~StreamStats();
+
+	/** @brief Reset all counters.
+	 */
+	void Reset();
+
+	/** @brief Add a time sample to a stage.
+	 *
+	 * @param WhichStage [in] Stage of the sample.
+	 * @param Nanoseconds [in] Duration of the stage.
+	 */
+	void AddSample( Stage WhichStage, unsigned long long Nanoseconds );
+
+	/** @brief Compute a percentile from the histogram of a stage. Result is the upper bound of the
+	 *         histogram bucket containing the percentile (relative error < 25%).
+	 *
+	 * @param WhichStage [in] Stage to query.
+	 * @param Percentile [in] Percentile in [0, 1] (0.5 for median, 0.99 for p99).
+	 * @return the percentile value in nanoseconds, 0 if no sample.
+	 */
+	unsigned long long GetPercentile( Stage WhichStage, double Percentile ) const;
+
+	/** @brief Write counters of this stream as a JSON object.
+	 */
+	std::string ToJson() const;
+
+	/** @brief Write counters of all living streams as a JSON object.
+	 */
+	static std::string AllToJson();
+
+	/** @brief Write counters of all living streams as JSON in a file.
+	 *
+	 * @param FileName [in] Output file.
+	 * @return true if the file was written.
+	 */
+	static bool DumpAllAsJson( const std::string& FileName );
+
+	/** @brief Reset counters of all living streams.
+	 */
+	static void ResetAll();
+
+	/** @brief Return the name of a stage as used in JSON output.
+	 */
+	static const char * GetStageName( Stage WhichStage );
+
+	std::string Name;						/*!< @brief Name of the stream */
+	unsigned long long Calls;				/*!< @brief Number of Draw calls */
+	unsigned long long FramesRead;			/*!< @brief Number of frames (or data lines) given to ProcessElement */
+	unsigned long long BytesRead;			/*!< @brief Number of bytes of these frames */
+
+	unsigned long long StageCount[NumberOfStages];						/*!< @brief Number of samples per stage */
+	unsigned long long StageNanoseconds[NumberOfStages];				/*!< @brief Total time per stage */
+	unsigned int StageHistogram[NumberOfStages][NumberOfBuckets];		/*!< @brief Time histogram per stage */
+
+	static thread_local StreamStats * Current;		/*!< @brief Stream currently drawing in this thread (nullptr if none) */
+	static thread_local unsigned long long CurrentElementNanoseconds;	/*!< @brief Time spent in ProcessElement during the current Draw */
+
+protected:
+	/** @brief Compute the histogram bucket of a duration.
+	 */
+	static int GetBucket( unsigned long long Nanoseconds );
+
+	/** @brief Compute the upper bound of a histogram bucket.
+	 */
+	static unsigned long long GetBucketUpperBound( int Bucket );
+};
+
+/**
+ * @class StageTimer DrawingProfiler.h
+ * @brief RAII timer adding its lifetime to a stage of the stream currently drawing in this thread.
+ *        Does nothing if no stream is drawing (static drawing functions called directly).
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class StageTimer
+{
+public:
+	/** @brief constructor. Start timing.
+	 *
+	 * @param _WhichStage [in] Stage to time.
+	 */
+	StageTimer( StreamStats::Stage _WhichStage )
+	{
+		WhichStage = _WhichStage;
+		Running = true;
+		Start = std::chrono::steady_clock::now();
+	}
+
+	/** @brief destructor. Stop timing if not already done.
+	 */
+	~StageTimer()
+	{
+		Stop();
+	}
+
+	/** @brief Stop timing and add the sample. Used when a stage ends before the end of the block.
+	 */
+	void Stop()
+	{
+		if ( Running && StreamStats::Current != nullptr )
+		{
+			StreamStats::Current->AddSample( WhichStage, (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()-Start).count() );
+		}
+		Running = false;
+	}
+
+protected:
+	StreamStats::Stage WhichStage;						/*!< @brief Stage to time */
+	bool Running;										/*!< @brief Is the timer still running? */
+	std::chrono::steady_clock::time_point Start;		/*!< @brief Starting time */
+};
+
+/**
+ * @class StreamScope DrawingProfiler.h
+ * @brief RAII object set around a Draw call. Make the stream current for this thread, count the call,
+ *        time the whole Draw and deduce the fetch time (Draw time minus ProcessElement time).
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class StreamScope
+{
+public:
+	/** @brief constructor. Enter a Draw call of a stream.
+	 *
+	 * @param Stats [in] Statistics of the stream.
+	 */
+	StreamScope( StreamStats& Stats )
+	{
+		Previous = StreamStats::Current;
+		PreviousElementNanoseconds = StreamStats::CurrentElementNanoseconds;
+		StreamStats::Current = &Stats;
+		StreamStats::CurrentElementNanoseconds = 0;
+		CurrentStats = &Stats;
+		CurrentStats->Calls++;
+		Start = std::chrono::steady_clock::now();
+	}
+
+	/** @brief destructor. Leave the Draw call.
+	 */
+	~StreamScope()
+	{
+		unsigned long long Total = (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()-Start).count();
+		unsigned long long Element = StreamStats::CurrentElementNanoseconds;
+
+		CurrentStats->AddSample( StreamStats::DrawStage, Total );
+		CurrentStats->AddSample( StreamStats::FetchStage, Total > Element ? Total - Element : 0 );
+
+		StreamStats::Current = Previous;
+		StreamStats::CurrentElementNanoseconds = PreviousElementNanoseconds;
+	}
+
+protected:
+	StreamStats * CurrentStats;								/*!< @brief Stream of this Draw call */
+	StreamStats * Previous;									/*!< @brief Stream drawing before this one (nested Draw calls) */
+	unsigned long long PreviousElementNanoseconds;			/*!< @brief ProcessElement time of the previous stream */
+	std::chrono::steady_clock::time_point Start;			/*!< @brief Starting time */
+};
+
+/**
+ * @class ElementScope DrawingProfiler.h
+ * @brief RAII object set around a ProcessElement call. Count the frame read and its size, and measure
+ *        the ProcessElement time to separate it from the fetch time.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class ElementScope
+{
+public:
+	/** @brief constructor. Enter a ProcessElement call.
+	 *
+	 * @param NumberOfFrames [in] Number of frames given to ProcessElement.
+	 * @param NumberOfBytes [in] Size of these frames.
+	 */
+	ElementScope( unsigned long long NumberOfFrames, unsigned long long NumberOfBytes )
+	{
+		if ( StreamStats::Current != nullptr )
+		{
+			StreamStats::Current->FramesRead += NumberOfFrames;
+			StreamStats::Current->BytesRead += NumberOfBytes;
+		}
+		Start = std::chrono::steady_clock::now();
+	}
+
+	/** @brief destructor. Leave the ProcessElement call.
+	 */
+	~ElementScope()
+	{
+		StreamStats::CurrentElementNanoseconds += (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()-Start).count();
+	}
+
+protected:
+	std::chrono::steady_clock::time_point Start;		/*!< @brief Starting time */
+};
+
+} // namespace MobileRGBD
+
+#define DRAWING_PROFILE_MEMBER StreamStats Stats;
+#define DRAWING_PROFILE_INIT(Name) , Stats( Name )
+#define DRAWING_PROFILE_STREAM_SCOPE() MobileRGBD::StreamScope DrawingStreamScope( Stats )
+#define DRAWING_PROFILE_FRAME_READ(NumberOfFrames, NumberOfBytes) MobileRGBD::ElementScope DrawingElementScope( (unsigned long long)(NumberOfFrames), (unsigned long long)(NumberOfBytes) )
+#define DRAWING_PROFILE_STAGE(Stage) MobileRGBD::StageTimer DrawingStageTimer_##Stage( MobileRGBD::StreamStats::Stage )
+#define DRAWING_PROFILE_STAGE_STOP(Stage) DrawingStageTimer_##Stage.Stop()
+
+#else
+
+#define DRAWING_PROFILE_MEMBER
+#define DRAWING_PROFILE_INIT(Name)
+#define DRAWING_PROFILE_STREAM_SCOPE()
+#define DRAWING_PROFILE_FRAME_READ(NumberOfFrames, NumberOfBytes)
+#define DRAWING_PROFILE_STAGE(Stage)
+#define DRAWING_PROFILE_STAGE_STOP(Stage)
+
+#endif // DRAWING_PROFILING
+
+// Event tracing (DRAWING_TRACING) is instrumented at the same places
+#include "DrawingTrace.h"
+
+/** @brief Declare the instrumentation members (statistics and/or trace name) of a drawing class. */
+#define DRAWING_STATS_MEMBER DRAWING_PROFILE_MEMBER DRAWING_TRACE_MEMBER
+/** @brief Initialise the instrumentation members of a drawing class in a constructor initialisation list. */
+#define DRAWING_STATS_INIT(Name) DRAWING_PROFILE_INIT(Name) DRAWING_TRACE_INIT(Name)
+/** @brief Time (and trace) the whole Draw call of a stream. */
+#define DRAWING_STREAM_SCOPE() DRAWING_PROFILE_STREAM_SCOPE(); DRAWING_TRACE_STREAM_SCOPE()
+/** @brief Count a frame (or a group of sub frames) given to ProcessElement and time (and trace) ProcessElement. */
+#define DRAWING_FRAME_READ(NumberOfFrames, NumberOfBytes) DRAWING_PROFILE_FRAME_READ(NumberOfFrames, NumberOfBytes); DRAWING_TRACE_FRAME_READ()
+/** @brief Time (and trace) a stage until the end of the current block. */
+#define DRAWING_STAGE_TIMER(Stage) DRAWING_PROFILE_STAGE(Stage); DRAWING_TRACE_STAGE(Stage, #Stage)
+/** @brief Stop timing (and tracing) a stage before the end of the current block. */
+#define DRAWING_STAGE_STOP(Stage) DRAWING_PROFILE_STAGE_STOP(Stage); DRAWING_TRACE_STAGE_STOP(Stage)
+
+#endif // __DRAWING_PROFILER_H__
@@ -0,0 +1,19 @@
+/**
+ * @file DrawingSimd.h
+ * @ingroup Drawing
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __DRAWING_SIMD_H__
+#define __DRAWING_SIMD_H__
+
+/** @brief DRAWING_SSE2 is defined when SSE2 kernels can be compiled (always the case on x86-64).
+ *         Define DRAWING_NO_SIMD to compile the scalar versions only.
+ */
+#if !defined DRAWING_NO_SIMD && (defined __SSE2__ || defined _M_X64 || defined _M_AMD64 || (defined _M_IX86_FP && _M_IX86_FP >= 2))
+	#define DRAWING_SSE2
+	#include <emmintrin.h>
+#endif
+
+#endif // __DRAWING_SIMD_H__
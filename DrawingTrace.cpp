@@ -0,0 +1,310 @@
+/**
+ * @file DrawingTrace.cpp
+ * @ingroup Drawing
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#include "DrawingTrace.h"
+
+#ifdef DRAWING_TRACING
+
+#include <stdio.h>
+#include <mutex>
+#include <vector>
+#include <set>
+
+using namespace MobileRGBD;
+
+/* static */ std::atomic<bool> TraceRecorder::Recording( false );
+/* static */ std::atomic<long long> TraceRecorder::OriginNanoseconds( 0 );
+
+/* static */ thread_local const char * TraceScope::CurrentStream = nullptr;
+/* static */ thread_local bool TraceScope::FetchPending = false;
+/* static */ thread_local std::chrono::steady_clock::time_point TraceScope::FetchBegin;
+
+namespace {
+
+/**
+ * @struct TraceEventRecord
+ * @brief One complete event.
+ */
+struct TraceEventRecord
+{
+	const char * Name;				/*!< @brief Static name of the event */
+	const char * Stream;			/*!< @brief Static name of the stream, nullptr if none */
+	long long BeginNanoseconds;		/*!< @brief Begin, relative to the trace origin */
+	long long DurationNanoseconds;	/*!< @brief Duration of the event */
+};
+
+/**
+ * @struct TraceBuffer
+ * @brief Event buffer of one thread. Only its thread writes events, Count is published
+ *        with release semantic. Readers hold TraceBuffersMutex and read Events[0..Count-1] only
+ *        if Generation is the current one: Start takes the same mutex, so the thread can not
+ *        restart its buffer (new generation) while it is read.
+ */
+struct TraceBuffer
+{
+	int ThreadId;							/*!< @brief Id of the thread in the trace */
+	size_t Capacity;						/*!< @brief Number of events in Events */
+	TraceEventRecord * Events;				/*!< @brief Events */
+	std::atomic<size_t> Count;				/*!< @brief Number of recorded events */
+	std::atomic<unsigned long long> Dropped;	/*!< @brief Number of dropped events */
+	std::atomic<unsigned int> Generation;	/*!< @brief Recording session of the events */
+	bool InUse;								/*!< @brief Is its thread still running? (protected by TraceBuffersMutex) */
+};
+
+std::mutex TraceBuffersMutex;					// Protect the following variables
+std::vector<TraceBuffer*> TraceBuffers;			// All thread buffers
+std::set<std::string> InternedStrings;			// Persistent strings
+size_t TraceCapacity = 1024*1024;				// Capacity of new buffers
+std::atomic<unsigned int> TraceGeneration( 0 );	// Incremented at each Start
+int NextThreadId = 1;							// Id of the next thread buffer in traces
+
+/**
+ * @struct ThreadBufferOwner
+ * @brief Buffer of the current thread, released when the thread ends. Its events are kept
+ *        for WriteChromeTrace, it is freed at next Start.
+ */
+struct ThreadBufferOwner
+{
+	ThreadBufferOwner() : Buffer( nullptr ) {}
+
+	~ThreadBufferOwner()
+	{
+		if ( Buffer != nullptr )
+		{
+			std::lock_guard<std::mutex> Lock( TraceBuffersMutex );
+			Buffer->InUse = false;
+		}
+	}
+
+	TraceBuffer * Buffer;		/*!< @brief Buffer of the thread, nullptr before its first event */
+};
+
+thread_local ThreadBufferOwner CurrentThreadBuffer;
+
+/** @brief Get the buffer of the current thread, allocate it at first call.
+ */
+TraceBuffer * GetThreadBuffer()
+{
+	TraceBuffer * Buffer = CurrentThreadBuffer.Buffer;
+	if ( Buffer == nullptr )
+	{
+		std::lock_guard<std::mutex> Lock( TraceBuffersMutex );
+
+		Buffer = new TraceBuffer;
+		Buffer->ThreadId = NextThreadId++;
+		Buffer->Capacity = TraceCapacity;
+		Buffer->Events = new TraceEventRecord[TraceCapacity];
+		Buffer->Count = 0;
+		Buffer->Dropped = 0;
+		Buffer->Generation = TraceGeneration.load();
+		Buffer->InUse = true;
+
+		TraceBuffers.push_back( Buffer );
+		CurrentThreadBuffer.Buffer = Buffer;
+	}
+
+	// A new recording session started, forget previous events (only this thread writes Count).
+	// Count is reset before Generation is published: a reader seeing the new generation sees the new Count.
+	if ( Buffer->Generation.load( std::memory_order_relaxed ) != TraceGeneration.load( std::memory_order_relaxed ) )
+	{
+		Buffer->Count.store( 0, std::memory_order_release );
+		Buffer->Dropped = 0;
+		Buffer->Generation.store( TraceGeneration.load() );
+	}
+
+	return Buffer;
+}
+
+/** @brief Write a JSON string (with quotes) in a file.
+ */
+void WriteJsonString( FILE * fout, const char * Value )
+{
+	fputc( '"', fout );
+	for( ; *Value != '\0'; Value++ )
+	{
+		if ( *Value == '\\' || *Value == '"' )
+		{
+			fputc( '\\', fout );
+		}
+		fputc( *Value, fout );
+	}
+	fputc( '"', fout );
+}
+
+} // anonymous namespace
+
+/** @brief Start recording. Events are timed relatively to this call. Waits for a trace being
+ *         written and frees buffers of ended threads.
+ *
+ * @param EventsPerThread [in] Capacity of thread buffers allocated after this call. Events are dropped when a buffer is full.
+ */
+// static
+void TraceRecorder::Start( size_t EventsPerThread /* = 1024*1024 */ )
+{
+	// Waits for WriteChromeTrace and GetNumberOfDroppedEvents: buffers are not restarted while read
+	std::lock_guard<std::mutex> Lock( TraceBuffersMutex );
+
+	// Free buffers of ended threads, their events belong to the previous recording
+	size_t Kept = 0;
+	for( size_t i = 0; i < TraceBuffers.size(); i++ )
+	{
+		if ( TraceBuffers[i]->InUse )
+		{
+			TraceBuffers[Kept++] = TraceBuffers[i];
+		}
+		else
+		{
+			delete [] TraceBuffers[i]->Events;
+			delete TraceBuffers[i];
+		}
+	}
+	TraceBuffers.resize( Kept );
+
+	TraceCapacity = EventsPerThread;
+	OriginNanoseconds.store( (long long)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(), std::memory_order_release );
+	TraceGeneration++;
+	Recording.store( true, std::memory_order_release );
+}
+
+/** @brief Stop recording. Recorded events are kept until next Start.
+ */
+// static
+void TraceRecorder::Stop()
+{
+	Recording.store( false );
+}
+
+/** @brief Record a complete event (begin timestamp and duration) in the buffer of the current thread.
+ *
+ * @param Name [in] Name of the event. Must be a static string (literal or interned with Intern).
+ * @param Stream [in] Name of the stream for this event, nullptr if none. Same constraint as Name.
+ * @param Begin [in] Begin of the event.
+ * @param End [in] End of the event.
+ */
+// static
+void TraceRecorder::AddEvent( const char * Name, const char * Stream, std::chrono::steady_clock::time_point Begin, std::chrono::steady_clock::time_point End )
+{
+	if ( IsRecording() == false )
+	{
+		return;
+	}
+
+	TraceBuffer * Buffer = GetThreadBuffer();
+
+	size_t Pos = Buffer->Count.load( std::memory_order_relaxed );
+	if ( Pos >= Buffer->Capacity )
+	{
+		Buffer->Dropped.fetch_add( 1, std::memory_order_relaxed );
+		return;
+	}
+
+	TraceEventRecord& Event = Buffer->Events[Pos];
+	Event.Name = Name;
+	Event.Stream = Stream;
+	// Origin may be written by Start on another thread, read it atomically
+	long long Origin = OriginNanoseconds.load( std::memory_order_acquire );
+	Event.BeginNanoseconds = (long long)std::chrono::duration_cast<std::chrono::nanoseconds>(Begin.time_since_epoch()).count() - Origin;
+	Event.DurationNanoseconds = (long long)std::chrono::duration_cast<std::chrono::nanoseconds>(End-Begin).count();
+
+	// Publish the event
+	Buffer->Count.store( Pos+1, std::memory_order_release );
+}
+
+/** @brief Get a persistent copy of a string, usable as event or stream name.
+ *
+ * @param Name [in] The string to intern.
+ * @return a pointer valid until the end of the program.
+ */
+// static
+const char * TraceRecorder::Intern( const std::string& Name )
+{
+	std::lock_guard<std::mutex> Lock( TraceBuffersMutex );
+
+	return InternedStrings.insert( Name ).first->c_str();
+}
+
+/** @brief Get the number of events dropped because of full buffers since last Start.
+ */
+// static
+unsigned long long TraceRecorder::GetNumberOfDroppedEvents()
+{
+	std::lock_guard<std::mutex> Lock( TraceBuffersMutex );
+
+	unsigned long long Dropped = 0;
+	for( size_t i = 0; i < TraceBuffers.size(); i++ )
+	{
+		if ( TraceBuffers[i]->Generation == TraceGeneration.load() )
+		{
+			Dropped += TraceBuffers[i]->Dropped.load( std::memory_order_relaxed );
+		}
+	}
+
+	return Dropped;
+}
+
+/** @brief Write all recorded events in Chrome Trace Event JSON format.
+ *
+ * @param FileName [in] Output file.
+ * @return true if the file was written.
+ */
+// static
+bool TraceRecorder::WriteChromeTrace( const std::string& FileName )
+{
+	FILE * fout = fopen( FileName.c_str(), "wb" );
+	if ( fout == nullptr )
+	{
+		return false;
+	}
+
+	std::lock_guard<std::mutex> Lock( TraceBuffersMutex );
+
+	fprintf( fout, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" );
+
+	bool FirstEvent = true;
+	for( size_t i = 0; i < TraceBuffers.size(); i++ )
+	{
+		TraceBuffer * Buffer = TraceBuffers[i];
+		if ( Buffer->Generation != TraceGeneration.load() )
+		{
+			// No event since the last Start
+			continue;
+		}
+
+		// Thread name metadata
+		fprintf( fout, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"Drawing thread %d\"}}",
+			FirstEvent ? "" : ",\n", Buffer->ThreadId, Buffer->ThreadId );
+		FirstEvent = false;
+
+		size_t Count = Buffer->Count.load( std::memory_order_acquire );
+		for( size_t e = 0; e < Count; e++ )
+		{
+			const TraceEventRecord& Event = Buffer->Events[e];
+
+			// Chrome trace timestamps are in microseconds
+			fprintf( fout, ",\n{\"name\":" );
+			WriteJsonString( fout, Event.Name );
+			fprintf( fout, ",\"cat\":\"Drawing\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+				Buffer->ThreadId, (double)Event.BeginNanoseconds/1000.0, (double)Event.DurationNanoseconds/1000.0 );
+			if ( Event.Stream != nullptr )
+			{
+				fprintf( fout, ",\"args\":{\"stream\":" );
+				WriteJsonString( fout, Event.Stream );
+				fprintf( fout, "}" );
+			}
+			fprintf( fout, "}" );
+		}
+	}
+
+	fprintf( fout, "]}\n" );
+
+	bool Ret = (ferror( fout ) == 0);
+	fclose( fout );
+
+	return Ret;
+}
+
+#endif // DRAWING_TRACING
@@ -0,0 +1,243 @@
+/**
+ * @file DrawingTrace.h
+ * @ingroup Drawing
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __DRAWING_TRACE_H__
+#define __DRAWING_TRACE_H__
+
+/*
+ * Event tracing of the drawing pipeline, written in Chrome Trace Event JSON format
+ * (load it in chrome://tracing or in Perfetto UI). Everything in this file is compiled
+ * only if DRAWING_TRACING is defined.
+ */
+
+#ifdef DRAWING_TRACING
+
+#include <string>
+#include <atomic>
+#include <chrono>
+
+namespace MobileRGBD {
+
+/**
+ * @class TraceRecorder DrawingTrace.cpp DrawingTrace.h
+ * @brief Record timed events in per-thread buffers. Each buffer has only one writer (its thread)
+ *        and is published with an atomic counter, thus recording is lock-free. Buffers are
+ *        allocated once per thread at its first event. Buffers of ended threads are kept until
+ *        next Start, so a trace can be written after the drawing threads are gone.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class TraceRecorder
+{
+public:
+	/** @brief Start recording. Events are timed relatively to this call. Waits for a trace being
+	 *         written and frees buffers of ended threads.
+	 *
+	 * @param EventsPerThread [in] Capacity of thread buffers allocated after this call. Events are dropped when a buffer is full.
+	 */
+	static void Start( size_t EventsPerThread = 1024*1024 );
+
+	/** @brief Stop recording. Recorded events are kept until next Start.
+	 */
+	static void Stop();
+
+	/** @brief Are we recording?
+	 */
+	static bool IsRecording()
+	{
+		return Recording.load( std::memory_order_relaxed );
+	}
+
+	/** @brief Record a complete event (begin timestamp and duration) in the buffer of the current thread.
+	 *
+	 * @param Name [in] Name of the event. Must be a static string (literal or interned with Intern).
+	 * @param Stream [in] Name of the stream for this event, nullptr if none. Same constraint as Name.
+	 * @param Begin [in] Begin of the event.
+	 * @param End [in] End of the event.
+	 */
+	static void AddEvent( const char * Name, const char * Stream, std::chrono::steady_clock::time_point Begin, std::chrono::steady_clock::time_point End );
+
+	/** @brief Get a persistent copy of a string, usable as event or stream name.
+	 *
+	 * @param Name [in] The string to intern.
+	 * @return a pointer valid until the end of the program.
+	 */
+	static const char * Intern( const std::string& Name );
+
+	/** @brief Write all recorded events in Chrome Trace Event JSON format.
+	 *
+	 * @param FileName [in] Output file.
+	 * @return true if the file was written.
+	 */
+	static bool WriteChromeTrace( const std::string& FileName );
+
+	/** @brief Get the number of events dropped because of full buffers since last Start.
+	 */
+	static unsigned long long GetNumberOfDroppedEvents();
+
+protected:
+	static std::atomic<bool> Recording;									/*!< @brief Are we recording? */
+	static std::atomic<long long> OriginNanoseconds;					/*!< @brief Time origin of the trace (steady clock, nanoseconds since its epoch), published before Recording */
+};
+
+/**
+ * @class TraceScope DrawingTrace.h
+ * @brief RAII object recording an event from its construction to its destruction (or to Stop).
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class TraceScope
+{
+public:
+	/** @brief constructor. Begin the event.
+	 *
+	 * @param _Name [in] Static name of the event.
+	 * @param _Stream [in] Static name of the stream, nullptr means the stream currently drawing in this thread.
+	 */
+	TraceScope( const char * _Name, const char * _Stream = nullptr )
+	{
+		Name = _Name;
+		Stream = _Stream != nullptr ? _Stream : CurrentStream;
+		Running = TraceRecorder::IsRecording();
+		if ( Running )
+		{
+			Begin = std::chrono::steady_clock::now();
+		}
+	}
+
+	/** @brief destructor. End the event if not already done.
+	 */
+	~TraceScope()
+	{
+		Stop();
+	}
+
+	/** @brief End the event before the end of the block.
+	 */
+	void Stop()
+	{
+		if ( Running )
+		{
+			TraceRecorder::AddEvent( Name, Stream, Begin, std::chrono::steady_clock::now() );
+			Running = false;
+		}
+	}
+
+	static thread_local const char * CurrentStream;		/*!< @brief Stream currently drawing in this thread */
+	static thread_local bool FetchPending;				/*!< @brief Is the fetch event of the current Draw still open? */
+	static thread_local std::chrono::steady_clock::time_point FetchBegin;	/*!< @brief Begin of the current fetch */
+
+protected:
+	const char * Name;								/*!< @brief Name of the event */
+	const char * Stream;							/*!< @brief Stream of the event */
+	bool Running;									/*!< @brief Is the event still open? */
+	std::chrono::steady_clock::time_point Begin;	/*!< @brief Begin of the event */
+};
+
+/**
+ * @class TraceDrawScope DrawingTrace.h
+ * @brief RAII object set around a Draw call. Record the Draw event and the fetch event (timestamp
+ *        lookup and data read) from the beginning of Draw to the beginning of ProcessElement.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class TraceDrawScope : public TraceScope
+{
+public:
+	/** @brief constructor. Enter a Draw call.
+	 *
+	 * @param StreamName [in] Static name of the stream.
+	 */
+	TraceDrawScope( const char * StreamName )
+		: TraceScope( "Draw", StreamName )
+	{
+		PreviousStream = CurrentStream;
+		PreviousFetchPending = FetchPending;
+		PreviousFetchBegin = FetchBegin;
+
+		CurrentStream = StreamName;
+		FetchPending = Running;
+		FetchBegin = Begin;
+	}
+
+	/** @brief destructor. Leave the Draw call.
+	 */
+	~TraceDrawScope()
+	{
+		// No ProcessElement call, all the time was spent fetching
+		EndFetch();
+		Stop();
+
+		CurrentStream = PreviousStream;
+		FetchPending = PreviousFetchPending;
+		FetchBegin = PreviousFetchBegin;
+	}
+
+	/** @brief Record the fetch event of the current Draw call if still open.
+	 */
+	static void EndFetch()
+	{
+		if ( FetchPending )
+		{
+			TraceRecorder::AddEvent( "Fetch", CurrentStream, FetchBegin, std::chrono::steady_clock::now() );
+			FetchPending = false;
+		}
+	}
+
+protected:
+	const char * PreviousStream;								/*!< @brief Stream of the enclosing Draw call (if any) */
+	bool PreviousFetchPending;									/*!< @brief Fetch state of the enclosing Draw call */
+	std::chrono::steady_clock::time_point PreviousFetchBegin;	/*!< @brief Fetch begin of the enclosing Draw call */
+};
+
+/**
+ * @class TraceElementScope DrawingTrace.h
+ * @brief RAII object set around a ProcessElement call. Close the fetch event and record ProcessElement.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class TraceElementScope : public TraceScope
+{
+public:
+	/** @brief constructor. Enter ProcessElement.
+	 */
+	TraceElementScope()
+		: TraceScope( BeginElement() )
+	{
+	}
+
+protected:
+	/** @brief Close the fetch event before opening the ProcessElement one.
+	 */
+	static const char * BeginElement()
+	{
+		TraceDrawScope::EndFetch();
+		return "ProcessElement";
+	}
+};
+
+} // namespace MobileRGBD
+
+#define DRAWING_TRACE_MEMBER const char * TraceName;
+#define DRAWING_TRACE_INIT(Name) , TraceName( MobileRGBD::TraceRecorder::Intern( Name ) )
+#define DRAWING_TRACE_STREAM_SCOPE() MobileRGBD::TraceDrawScope DrawingTraceDrawScope( TraceName )
+#define DRAWING_TRACE_FRAME_READ() MobileRGBD::TraceElementScope DrawingTraceElementScope
+#define DRAWING_TRACE_STAGE(Stage, StageName) MobileRGBD::TraceScope DrawingTraceStage_##Stage( StageName )
+#define DRAWING_TRACE_STAGE_STOP(Stage) DrawingTraceStage_##Stage.Stop()
+
+#else
+
+#define DRAWING_TRACE_MEMBER
+#define DRAWING_TRACE_INIT(Name)
+#define DRAWING_TRACE_STREAM_SCOPE()
+#define DRAWING_TRACE_FRAME_READ()
+#define DRAWING_TRACE_STAGE(Stage, StageName)
+#define DRAWING_TRACE_STAGE_STOP(Stage)
+
+#endif // DRAWING_TRACING
+
+#endif // __DRAWING_TRACE_H__
@@ -0,0 +1,109 @@
+/**
+ * @file FrameRing.cpp
+ * @ingroup Drawing
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#include "FrameRing.h"
+
+using namespace MobileRGBD;
+
+/** @brief constructor. Allocate all frames.
+ *
+ * @param _FrameSize [in] Size of each frame.
+ * @param NumberOfFrames [in] Number of frames in the ring, at least 3 (Default = 4).
+ */
+FrameRing::FrameRing( int _FrameSize, int NumberOfFrames /* = 4 */ )
+	: FreeFrames( NumberOfFrames < 3 ? 3 : NumberOfFrames ), PublishedFrames( NumberOfFrames < 3 ? 3 : NumberOfFrames )
+{
+	// One frame for the producer, one for the consumer, at least one in between
+	if ( NumberOfFrames < 3 )
+	{
+		NumberOfFrames = 3;
+	}
+
+	FrameSize = _FrameSize;
+	DroppedFrames = 0;
+
+	Storage.resize( (size_t)FrameSize*NumberOfFrames );
+	Frames.resize( NumberOfFrames );
+	for( int f = 0; f < NumberOfFrames; f++ )
+	{
+		Frames[f].Timestamp = TimeB();
+		Frames[f].Data = &Storage[(size_t)FrameSize*f];
+		Frames[f].Size = FrameSize;
+		Frames[f].Slot = f;
+
+		FreeFrames.Push( f );
+	}
+}
+
+/** @brief Virtual destructor, always.
+ */
+FrameRing::~FrameRing()
+{
+}
+
+/** @brief Get a free frame to fill (producer thread only).
+ *
+ * @return a frame, nullptr if all frames are used (the producer should drop its frame).
+ */
+RingFrame * FrameRing::AcquireForWriting()
+{
+	int Slot;
+	if ( FreeFrames.Pop( Slot ) == false )
+	{
+		DroppedFrames++;
+		return nullptr;
+	}
+
+	return &Frames[Slot];
+}
+
+/** @brief Publish a filled frame (producer thread only).
+ *
+ * @param Frame [in] Frame from AcquireForWriting, with its Timestamp set.
+ */
+void FrameRing::Publish( RingFrame * Frame )
+{
+	// Can not fail: there are never more published frames than frames
+	PublishedFrames.Push( Frame->Slot );
+}
+
+/** @brief Get a published frame (consumer thread only). It must be released after use.
+ *
+ * @param Mode [in] Next frame in order or latest frame (Default = InOrder).
+ * @return a frame, nullptr if no new frame was published.
+ */
+RingFrame * FrameRing::AcquireForReading( ReadMode Mode /* = InOrder */ )
+{
+	int Slot;
+	if ( PublishedFrames.Pop( Slot ) == false )
+	{
+		return nullptr;
+	}
+
+	if ( Mode == LatestFrameWins )
+	{
+		// Give older frames back to the producer
+		int Newer;
+		while( PublishedFrames.Pop( Newer ) )
+		{
+			FreeFrames.Push( Slot );
+			DroppedFrames++;
+			Slot = Newer;
+		}
+	}
+
+	return &Frames[Slot];
+}
+
+/** @brief Give a read frame back to the producer (consumer thread only).
+ *
+ * @param Frame [in] Frame from AcquireForReading.
+ */
+void FrameRing::Release( RingFrame * Frame )
+{
+	FreeFrames.Push( Frame->Slot );
+}
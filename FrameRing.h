@@ -0,0 +1,177 @@
+/**
+ * @file FrameRing.h
+ * @ingroup Drawing
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __FRAME_RING_H__
+#define __FRAME_RING_H__
+
+#include <vector>
+#include <atomic>
+
+#include "../DataManagement/TimestampTools.h"
+
+namespace MobileRGBD {
+
+/**
+ * @class SpscQueue FrameRing.h
+ * @brief Lock-free bounded queue for one producer thread and one consumer thread.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+template<typename T>
+class SpscQueue
+{
+public:
+	/** @brief constructor.
+	 *
+	 * @param MinCapacity [in] Minimum number of elements in the queue (rounded to a power of 2).
+	 */
+	SpscQueue( int MinCapacity )
+	{
+		int Capacity = 2;
+		while( Capacity < MinCapacity )
+		{
+			Capacity *= 2;
+		}
+		Elements.resize( Capacity );
+		Mask = Capacity-1;
+		Head = 0;
+		Tail = 0;
+	}
+
+	/** @brief Add an element (producer thread only).
+	 *
+	 * @return false if the queue is full.
+	 */
+	bool Push( const T& Element )
+	{
+		unsigned int CurrentTail = Tail.load( std::memory_order_relaxed );
+		if ( CurrentTail - Head.load( std::memory_order_acquire ) > Mask )
+		{
+			return false;
+		}
+
+		Elements[CurrentTail & Mask] = Element;
+		Tail.store( CurrentTail+1, std::memory_order_release );
+		return true;
+	}
+
+	/** @brief Remove the oldest element (consumer thread only).
+	 *
+	 * @return false if the queue is empty.
+	 */
+	bool Pop( T& Element )
+	{
+		unsigned int CurrentHead = Head.load( std::memory_order_relaxed );
+		if ( CurrentHead == Tail.load( std::memory_order_acquire ) )
+		{
+			return false;
+		}
+
+		Element = Elements[CurrentHead & Mask];
+		Head.store( CurrentHead+1, std::memory_order_release );
+		return true;
+	}
+
+protected:
+	std::vector<T> Elements;				/*!< @brief Storage, power of 2 size */
+	unsigned int Mask;						/*!< @brief Size of Elements - 1 */
+	std::atomic<unsigned int> Head;			/*!< @brief Next element to pop (written by the consumer) */
+	std::atomic<unsigned int> Tail;			/*!< @brief Next place to push (written by the producer) */
+};
+
+/**
+ * @struct RingFrame
+ * @brief A frame buffer of a FrameRing.
+ */
+struct RingFrame
+{
+	TimeB Timestamp;			/*!< @brief Timestamp of the frame */
+	unsigned char * Data;		/*!< @brief Frame data, FrameRing::GetFrameSize() bytes */
+	int Size;					/*!< @brief Size of the frame */
+	int Slot;					/*!< @brief Index of the buffer in the ring */
+};
+
+/**
+ * @class FrameRing FrameRing.cpp FrameRing.h
+ * @brief In memory stream of fixed size frames, from a producer thread (live capture) to a consumer
+ *        thread (drawing, see DrawRawData::SetLiveSource). Frames are preallocated and handed over without
+ *        copy: the producer fills a free frame and publishes it, the consumer reads it and releases it.
+ *        Free and published frames go through two lock-free single producer/single consumer queues.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class FrameRing
+{
+public:
+	/** @enum FrameRing::ReadMode
+	 *  @brief How the consumer reads published frames: all frames in order, or only the latest one
+	 *         (older frames are released, for display).
+	 */
+	enum ReadMode { InOrder = 0, LatestFrameWins = 1 };
+
+	/** @brief constructor. Allocate all frames.
+	 *
+	 * @param _FrameSize [in] Size of each frame.
+	 * @param NumberOfFrames [in] Number of frames in the ring, at least 3 (Default = 4).
+	 */
+	FrameRing( int _FrameSize, int NumberOfFrames = 4 );
+
+	/** @brief Virtual destructor, always.
+	 */
+	virtual ~FrameRing();
+
+	/** @brief Get the size of frames.
+	 */
+	int GetFrameSize() const
+	{
+		return FrameSize;
+	}
+
+	/** @brief Get a free frame to fill (producer thread only).
+	 *
+	 * @return a frame, nullptr if all frames are used (the producer should drop its frame).
+	 */
+	RingFrame * AcquireForWriting();
+
+	/** @brief Publish a filled frame (producer thread only).
+	 *
+	 * @param Frame [in] Frame from AcquireForWriting, with its Timestamp set.
+	 */
+	void Publish( RingFrame * Frame );
+
+	/** @brief Get a published frame (consumer thread only). It must be released after use.
+	 *
+	 * @param Mode [in] Next frame in order or latest frame (Default = InOrder).
+	 * @return a frame, nullptr if no new frame was published.
+	 */
+	RingFrame * AcquireForReading( ReadMode Mode = InOrder );
+
+	/** @brief Give a read frame back to the producer (consumer thread only).
+	 *
+	 * @param Frame [in] Frame from AcquireForReading.
+	 */
+	void Release( RingFrame * Frame );
+
+	/** @brief Get the number of frames dropped by the producer (no free frame) or skipped by the consumer (LatestFrameWins).
+	 */
+	unsigned long long GetNumberOfDroppedFrames() const
+	{
+		return DroppedFrames.load();
+	}
+
+protected:
+	int FrameSize;								/*!< @brief Size of each frame */
+	std::vector<unsigned char> Storage;			/*!< @brief Data of all frames */
+	std::vector<RingFrame> Frames;				/*!< @brief Frames */
+	SpscQueue<int> FreeFrames;					/*!< @brief Frames given back to the producer */
+	SpscQueue<int> PublishedFrames;				/*!< @brief Frames given to the consumer */
+	std::atomic<unsigned long long> DroppedFrames;	/*!< @brief Dropped and skipped frames */
+};
+
+} // namespace MobileRGBD
+
+#endif // __FRAME_RING_H__
@@ -0,0 +1,201 @@
+/**
+ * @file IndexedFrameFile.cpp
+ * @ingroup Drawing
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#include "IndexedFrameFile.h"
+
+#include <string.h>
+
+#if defined WIN32 || defined WIN64
+	#define fseek64 _fseeki64
+#else
+	#define fseek64 fseeko
+#endif
+
+using namespace MobileRGBD;
+
+/** @brief constructor. Open an indexed frame file if it exists.
+ *
+ * @param Owner [in] Object receiving the frames (in ProcessCompanionElement).
+ * @param CompanionId [in] Companion id given back to the owner.
+ * @param DataFile [in] File containing the frames.
+ * @param IndexFile [in] Index file of DataFile.
+ */
+IndexedFrameFile::IndexedFrameFile( DrawTimestampRawData& Owner, int CompanionId, const std::string& DataFile, const std::string& IndexFile )
+{
+	Index = nullptr;
+	Data = nullptr;
+
+	if ( CompanionRawData::FileExists( IndexFile ) == false )
+	{
+		return;
+	}
+
+	Data = fopen( DataFile.c_str(), "rb" );
+	if ( Data == nullptr )
+	{
+		return;
+	}
+
+	Index = new CompanionRawData( Owner, CompanionId, Owner.GetTimestampFileName(), IndexFile, (int)sizeof(IndexedFrameEntry) );
+}
+
+/** @brief Virtual destructor, always.
+ */
+IndexedFrameFile::~IndexedFrameFile()
+{
+	if ( Index != nullptr )
+	{
+		delete Index;
+	}
+	if ( Data != nullptr )
+	{
+		fclose( Data );
+	}
+}
+
+/** @brief Read the frame of the current index entry. To call from ProcessCompanionElement.
+ *
+ * @param Companion [in] Companion received by ProcessCompanionElement (the index).
+ * @param Entry [out] Index entry of the frame.
+ * @return a pointer to the frame data (valid until next call), nullptr on error.
+ */
+const unsigned char * IndexedFrameFile::ReadFrame( CompanionRawData& Companion, IndexedFrameEntry& Entry )
+{
+	memcpy( &Entry, Companion.GetFrame(), sizeof(IndexedFrameEntry) );
+
+	return ReadFrame( Entry );
+}
+
+/** @brief Read a frame from its index entry.
+ *
+ * @param Entry [in] Index entry of the frame.
+ * @return a pointer to the frame data (valid until next call), nullptr on error.
+ */
+const unsigned char * IndexedFrameFile::ReadFrame( const IndexedFrameEntry& Entry )
+{
+	if ( Data == nullptr || Entry.Offset < 0 || Entry.Size <= 0 )
+	{
+		return nullptr;
+	}
+
+	// Buffer only grows
+	if ( (int)FrameData.size() < Entry.Size )
+	{
+		FrameData.resize( Entry.Size );
+	}
+
+	if ( fseek64( Data, Entry.Offset, SEEK_SET ) != 0 || fread( &FrameData[0], Entry.Size, 1, Data ) != 1 )
+	{
+		return nullptr;
+	}
+
+	return &FrameData[0];
+}
+
+/** @brief constructor.
+ */
+IndexedFrameFileWriter::IndexedFrameFileWriter()
+{
+	Data = nullptr;
+	Index = nullptr;
+	Position = 0;
+	Error = false;
+}
+
+/** @brief Virtual destructor, always. Close files.
+ */
+IndexedFrameFileWriter::~IndexedFrameFileWriter()
+{
+	Close();
+}
+
+/** @brief Create the data file and its index.
+ *
+ * @param _DataFile [in] File containing the frames.
+ * @param _IndexFile [in] Index file of DataFile.
+ * @return true if both files were created.
+ */
+bool IndexedFrameFileWriter::Open( const std::string& _DataFile, const std::string& _IndexFile )
+{
+	Close();
+
+	DataFile = _DataFile;
+	IndexFile = _IndexFile;
+	Position = 0;
+	Error = false;
+
+	Data = fopen( DataFile.c_str(), "wb" );
+	Index = fopen( IndexFile.c_str(), "wb" );
+	if ( Data == nullptr || Index == nullptr )
+	{
+		Close( true );
+		return false;
+	}
+
+	return true;
+}
+
+/** @brief Add a frame.
+ *
+ * @param Frame [in] Frame data.
+ * @param Size [in] Size of the frame.
+ * @param Info [in] Format specific information stored in the index entry.
+ * @return true if the frame was written.
+ */
+bool IndexedFrameFileWriter::AddFrame( const unsigned char * Frame, int Size, int Info )
+{
+	if ( Data == nullptr || Error )
+	{
+		return false;
+	}
+
+	IndexedFrameEntry Entry;
+	Entry.Offset = Position;
+	Entry.Size = Size;
+	Entry.Info = Info;
+
+	if ( fwrite( Frame, Size, 1, Data ) != 1 || fwrite( &Entry, sizeof(Entry), 1, Index ) != 1 )
+	{
+		Error = true;
+		return false;
+	}
+
+	Position += Size;
+	return true;
+}
+
+/** @brief Close files.
+ *
+ * @param Remove [in] Remove files (i.e. after an error) (Default = false).
+ * @return true if all data were written.
+ */
+bool IndexedFrameFileWriter::Close( bool Remove /* = false */ )
+{
+	if ( Data != nullptr && fclose( Data ) != 0 )
+	{
+		Error = true;
+	}
+	if ( Index != nullptr && fclose( Index ) != 0 )
+	{
+		Error = true;
+	}
+
+	if ( Remove && DataFile.empty() == false )
+	{
+		remove( DataFile.c_str() );
+		remove( IndexFile.c_str() );
+	}
+
+	bool Ret = (Error == false && Remove == false);
+
+	Data = nullptr;
+	Index = nullptr;
+	DataFile.clear();
+	IndexFile.clear();
+
+	return Ret;
+}
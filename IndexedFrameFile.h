@@ -0,0 +1,147 @@
+/**
+ * @file IndexedFrameFile.h
+ * @ingroup Drawing
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __INDEXED_FRAME_FILE_H__
+#define __INDEXED_FRAME_FILE_H__
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "CompanionRawData.h"
+
+namespace MobileRGBD {
+
+/**
+ * @struct IndexedFrameEntry
+ * @brief Entry of an index file: where a variable size frame is stored in its data file.
+ *        The index file is an array of these 16 bytes entries, entry i being frame i of the stream.
+ */
+struct IndexedFrameEntry
+{
+	long long Offset;		/*!< @brief Position of the frame in the data file */
+	int Size;				/*!< @brief Size of the frame in the data file */
+	int Info;				/*!< @brief Format specific information about the frame */
+};
+
+/**
+ * @class IndexedFrameFile IndexedFrameFile.cpp IndexedFrameFile.h
+ * @brief Reader for a stream of variable size frames (compressed frames) stored in a data file with
+ *        an index file. The index file has fixed size entries (see IndexedFrameEntry) in the order of the
+ *        raw file they replace, so it is read as a companion (see CompanionRawData) of the owner, using the
+ *        timestamp file of the owner. In ProcessCompanionElement, the owner gets its frame with ReadFrame.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class IndexedFrameFile
+{
+public:
+	/** @brief constructor. Open an indexed frame file if it exists.
+	 *
+	 * @param Owner [in] Object receiving the frames (in ProcessCompanionElement).
+	 * @param CompanionId [in] Companion id given back to the owner.
+	 * @param DataFile [in] File containing the frames.
+	 * @param IndexFile [in] Index file of DataFile.
+	 */
+	IndexedFrameFile( DrawTimestampRawData& Owner, int CompanionId, const std::string& DataFile, const std::string& IndexFile );
+
+	/** @brief Virtual destructor, always.
+	 */
+	virtual ~IndexedFrameFile();
+
+	/** @brief Are the data file and its index available?
+	 */
+	bool IsOpen() const
+	{
+		return Index != nullptr;
+	}
+
+	/** @brief Search the frame at a timestamp, the owner will receive it in ProcessCompanionElement.
+	 *
+	 * @param RequestTimestamp [in] The timestamp of the data.
+	 * @param UserData [in] User pointer to working data, given back to the owner.
+	 */
+	bool Process( const TimeB &RequestTimestamp, void * UserData )
+	{
+		return Index->Process( RequestTimestamp, UserData );
+	}
+
+	/** @brief Read the frame of the current index entry. To call from ProcessCompanionElement.
+	 *
+	 * @param Companion [in] Companion received by ProcessCompanionElement (the index).
+	 * @param Entry [out] Index entry of the frame.
+	 * @return a pointer to the frame data (valid until next call), nullptr on error.
+	 */
+	const unsigned char * ReadFrame( CompanionRawData& Companion, IndexedFrameEntry& Entry );
+
+	/** @brief Read a frame from its index entry.
+	 *
+	 * @param Entry [in] Index entry of the frame.
+	 * @return a pointer to the frame data (valid until next call), nullptr on error.
+	 */
+	const unsigned char * ReadFrame( const IndexedFrameEntry& Entry );
+
+protected:
+	CompanionRawData * Index;				/*!< @brief Index, read as a companion of the owner */
+	FILE * Data;							/*!< @brief Data file */
+	std::vector<unsigned char> FrameData;	/*!< @brief Last read frame */
+};
+
+/**
+ * @class IndexedFrameFileWriter IndexedFrameFile.cpp IndexedFrameFile.h
+ * @brief Write a data file and its index (see IndexedFrameFile). Frames must be added in the order of
+ *        the raw file they replace.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class IndexedFrameFileWriter
+{
+public:
+	/** @brief constructor.
+	 */
+	IndexedFrameFileWriter();
+
+	/** @brief Virtual destructor, always. Close files.
+	 */
+	virtual ~IndexedFrameFileWriter();
+
+	/** @brief Create the data file and its index.
+	 *
+	 * @param _DataFile [in] File containing the frames.
+	 * @param _IndexFile [in] Index file of DataFile.
+	 * @return true if both files were created.
+	 */
+	bool Open( const std::string& _DataFile, const std::string& _IndexFile );
+
+	/** @brief Add a frame.
+	 *
+	 * @param Frame [in] Frame data.
+	 * @param Size [in] Size of the frame.
+	 * @param Info [in] Format specific information stored in the index entry.
+	 * @return true if the frame was written.
+	 */
+	bool AddFrame( const unsigned char * Frame, int Size, int Info );
+
+	/** @brief Close files.
+	 *
+	 * @param Remove [in] Remove files (i.e. after an error) (Default = false).
+	 * @return true if all data were written.
+	 */
+	bool Close( bool Remove = false );
+
+protected:
+	FILE * Data;				/*!< @brief Data file */
+	FILE * Index;				/*!< @brief Index file */
+	long long Position;			/*!< @brief Current position in Data */
+	bool Error;					/*!< @brief Was there a writing error? */
+	std::string DataFile;		/*!< @brief Name of the data file */
+	std::string IndexFile;		/*!< @brief Name of the index file */
+};
+
+} // namespace MobileRGBD
+
+#endif // __INDEXED_FRAME_FILE_H__
@@ -0,0 +1,328 @@
+/**
+ * @file PixelKernels.h
+ * @ingroup Drawing
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __PIXEL_KERNELS_H__
+#define __PIXEL_KERNELS_H__
+
+#include <math.h>
+
+#include "opencv2/core/core.hpp"
+
+namespace MobileRGBD {
+
+/**
+ * @struct BGRPixel
+ * @brief Color of a pixel produced by a source format.
+ */
+struct BGRPixel
+{
+	unsigned char B;	/*!< @brief Blue */
+	unsigned char G;	/*!< @brief Green */
+	unsigned char R;	/*!< @brief Red */
+
+	BGRPixel( unsigned char _B, unsigned char _G, unsigned char _R ) : B(_B), G(_G), R(_R) {}
+};
+
+/**
+ * @class GammaTable16
+ * @brief Gamma coded intensity (gamma .32, as in the Kinect2 views) of each 16 bits value, normalised by
+ *        Normaliser. One table per Normaliser is computed at first use and shared by all threads.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+template<int Normaliser>
+class GammaTable16
+{
+public:
+	/** @brief Get the table (65536 values).
+	 */
+	static const unsigned char * Get()
+	{
+		static const GammaTable16 Table;
+		return Table.Values;
+	}
+
+protected:
+	/** @brief constructor. Compute the table.
+	 */
+	GammaTable16()
+	{
+		Values[0] = 0;
+		for( int Value = 1; Value < 65536; Value++ )
+		{
+			float originalBrightnessValue = ((float)Value)/((float)Normaliser);
+			float gammaAppliedValue = pow(originalBrightnessValue, .32f);
+			Values[Value] = (unsigned char)((gammaAppliedValue < 1.0f ? gammaAppliedValue : 1.0f)*255.0f);
+		}
+	}
+
+	unsigned char Values[65536];	/*!< @brief Intensity of each value */
+};
+
+// Source formats: type of source pixels and their color. A format object is built once per frame.
+
+/**
+ * @struct DepthGamma16
+ * @brief Kinect2 16 bits depth, drawn as gamma coded grey levels (no depth is black).
+ */
+struct DepthGamma16
+{
+	typedef unsigned short int PixelType;
+
+	DepthGamma16() : Table( GammaTable16<65536>::Get() ) {}
+	explicit DepthGamma16( const unsigned char * _Table ) : Table( _Table ) {}
+
+	BGRPixel operator()( PixelType Value ) const
+	{
+		return BGRPixel( Table[Value], Table[Value], Table[Value] );
+	}
+
+	const unsigned char * Table;	/*!< @brief Intensity table */
+};
+
+/**
+ * @struct InfraredGamma16
+ * @brief Kinect2 16 bits infrared, drawn as gamma coded intensity on the green channel over red.
+ */
+struct InfraredGamma16
+{
+	typedef unsigned short int PixelType;
+
+	InfraredGamma16() : Table( GammaTable16<8192>::Get() ) {}
+	explicit InfraredGamma16( const unsigned char * _Table ) : Table( _Table ) {}
+
+	BGRPixel operator()( PixelType Value ) const
+	{
+		return BGRPixel( 0, Table[Value], 255 );
+	}
+
+	const unsigned char * Table;	/*!< @brief Intensity table */
+};
+
+/**
+ * @struct DepthColor16
+ * @brief Kinect2 16 bits depth, drawn with a color table of each 16 bits value (see DepthColorMap).
+ */
+struct DepthColor16
+{
+	typedef unsigned short int PixelType;
+
+	explicit DepthColor16( const BGRPixel * _Colors ) : Colors( _Colors ) {}
+
+	BGRPixel operator()( PixelType Value ) const
+	{
+		return Colors[Value];
+	}
+
+	const BGRPixel * Colors;	/*!< @brief Color table (65536 values) */
+};
+
+/**
+ * @struct Gray8
+ * @brief 8 bits intensity (i.e. already gamma coded depth proxy), drawn as grey levels.
+ */
+struct Gray8
+{
+	typedef unsigned char PixelType;
+
+	BGRPixel operator()( PixelType Value ) const
+	{
+		return BGRPixel( Value, Value, Value );
+	}
+};
+
+/**
+ * @struct InfraredGray8
+ * @brief 8 bits infrared intensity (i.e. infrared proxy), drawn on the green channel over red.
+ */
+struct InfraredGray8
+{
+	typedef unsigned char PixelType;
+
+	BGRPixel operator()( PixelType Value ) const
+	{
+		return BGRPixel( 0, Value, 255 );
+	}
+};
+
+/**
+ * @struct BodyIndex8
+ * @brief Kinect2 body index, drawn with a palette of 6 colors (other values are black).
+ */
+struct BodyIndex8
+{
+	typedef unsigned char PixelType;
+
+	BodyIndex8( const unsigned char (*_Colors)[3] ) : Colors( _Colors ) {}
+
+	BGRPixel operator()( PixelType Value ) const
+	{
+		if ( Value > 5 )
+		{
+			return BGRPixel( 0, 0, 0 );
+		}
+		return BGRPixel( Colors[Value][0], Colors[Value][1], Colors[Value][2] );
+	}
+
+	const unsigned char (*Colors)[3];	/*!< @brief BGR palette */
+};
+
+// Output formats: how a color is written in the output buffer.
+
+/**
+ * @struct BGR24
+ * @brief 3 bytes BGR pixels (CV_8UC3).
+ */
+struct BGR24
+{
+	enum { Channels = 3, MatType = CV_8UC3 };
+
+	static void Write( unsigned char * Output, const BGRPixel& Pixel )
+	{
+		Output[0] = Pixel.B;
+		Output[1] = Pixel.G;
+		Output[2] = Pixel.R;
+	}
+};
+
+/**
+ * @struct BGRA32
+ * @brief 4 bytes BGRA pixels (CV_8UC4), opaque.
+ */
+struct BGRA32
+{
+	enum { Channels = 4, MatType = CV_8UC4 };
+
+	static void Write( unsigned char * Output, const BGRPixel& Pixel )
+	{
+		Output[0] = Pixel.B;
+		Output[1] = Pixel.G;
+		Output[2] = Pixel.R;
+		Output[3] = 255;
+	}
+};
+
+/**
+ * @class FrameKernel PixelKernels.h
+ * @brief Conversion of a whole frame from a source format to an output format. Dimensions are template
+ *        parameters, so the loop has a constant trip count and constant strides and can be unrolled and
+ *        vectorized by the compiler. Views keep their void * entry points (ProcessElement) and call the
+ *        kernel instantiated for their stream.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+template<class SourceFormat, class OutputFormat, int Width, int Height>
+class FrameKernel
+{
+public:
+	typedef typename SourceFormat::PixelType SourcePixel;	/*!< @brief Type of source pixels */
+
+	enum { FrameWidth = Width, FrameHeight = Height, NumberOfPixels = Width*Height };
+	enum { SourceFrameSize = NumberOfPixels*sizeof(SourcePixel), OutputFrameSize = NumberOfPixels*OutputFormat::Channels };
+
+	/** @brief Convert a frame.
+	 *
+	 * @param Source [in] Source frame (NumberOfPixels pixels).
+	 * @param Output [out] Output buffer (OutputFrameSize bytes).
+	 * @param Format [in] Source format object (Default = default constructed).
+	 */
+	static void Convert( const SourcePixel * Source, unsigned char * Output, const SourceFormat& Format = SourceFormat() )
+	{
+		for( int i = 0; i < NumberOfPixels; i++ )
+		{
+			OutputFormat::Write( Output + i*OutputFormat::Channels, Format( Source[i] ) );
+		}
+	}
+
+	/** @brief Convert a rectangle of a frame (see DirtyTiles).
+	 *
+	 * @param Source [in] Source frame (NumberOfPixels pixels).
+	 * @param Output [out] Output buffer (OutputFrameSize bytes), only the rectangle is written.
+	 * @param X [in] Left of the rectangle.
+	 * @param Y [in] Top of the rectangle.
+	 * @param RectWidth [in] Width of the rectangle.
+	 * @param RectHeight [in] Height of the rectangle.
+	 * @param Format [in] Source format object (Default = default constructed).
+	 */
+	static void ConvertRect( const SourcePixel * Source, unsigned char * Output, int X, int Y, int RectWidth, int RectHeight, const SourceFormat& Format = SourceFormat() )
+	{
+		for( int line = Y; line < Y+RectHeight; line++ )
+		{
+			const SourcePixel * Values = Source + line*Width + X;
+			unsigned char * Pixels = Output + (line*Width + X)*OutputFormat::Channels;
+			for( int col = 0; col < RectWidth; col++ )
+			{
+				OutputFormat::Write( Pixels + col*OutputFormat::Channels, Format( Values[col] ) );
+			}
+		}
+	}
+
+	/** @brief Get a cv::Mat header on an output buffer (no copy).
+	 *
+	 * @param Output [in] Output buffer (OutputFrameSize bytes).
+	 */
+	static cv::Mat Wrap( unsigned char * Output )
+	{
+		return cv::Mat( Height, Width, OutputFormat::MatType, Output );
+	}
+};
+
+/**
+ * @class PairKernel PixelKernels.h
+ * @brief Conversion of two frames of the same size (i.e. Kinect2 depth and infrared) to one side by side
+ *        output frame (first frame on the left, second on the right) in a single pass: pixels of both
+ *        sources are read and written together, line by line, so both source buffers are streamed at once.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+template<class FirstFormat, class SecondFormat, class OutputFormat, int Width, int Height>
+class PairKernel
+{
+public:
+	typedef typename FirstFormat::PixelType FirstPixel;		/*!< @brief Type of pixels of the first source */
+	typedef typename SecondFormat::PixelType SecondPixel;	/*!< @brief Type of pixels of the second source */
+
+	enum { FrameWidth = Width, FrameHeight = Height, OutputWidth = 2*Width };
+	enum { OutputFrameSize = OutputWidth*Height*OutputFormat::Channels };
+
+	/** @brief Convert both frames.
+	 *
+	 * @param First [in] First source frame (Width*Height pixels), drawn on the left.
+	 * @param Second [in] Second source frame (Width*Height pixels), drawn on the right.
+	 * @param Output [out] Output buffer (OutputFrameSize bytes).
+	 * @param FirstFormatObject [in] Format of the first source (Default = default constructed).
+	 * @param SecondFormatObject [in] Format of the second source (Default = default constructed).
+	 */
+	static void Convert( const FirstPixel * First, const SecondPixel * Second, unsigned char * Output,
+		const FirstFormat& FirstFormatObject = FirstFormat(), const SecondFormat& SecondFormatObject = SecondFormat() )
+	{
+		for( int line = 0; line < Height; line++ )
+		{
+			const FirstPixel * FirstValues = First + line*Width;
+			const SecondPixel * SecondValues = Second + line*Width;
+			unsigned char * Pixels = Output + line*OutputWidth*OutputFormat::Channels;
+			for( int col = 0; col < Width; col++ )
+			{
+				OutputFormat::Write( Pixels + col*OutputFormat::Channels, FirstFormatObject( FirstValues[col] ) );
+				OutputFormat::Write( Pixels + (Width+col)*OutputFormat::Channels, SecondFormatObject( SecondValues[col] ) );
+			}
+		}
+	}
+
+	/** @brief Get a cv::Mat header on an output buffer (no copy).
+	 *
+	 * @param Output [in] Output buffer (OutputFrameSize bytes).
+	 */
+	static cv::Mat Wrap( unsigned char * Output )
+	{
+		return cv::Mat( Height, OutputWidth, OutputFormat::MatType, Output );
+	}
+};
+
+} // namespace MobileRGBD
+
+#endif // __PIXEL_KERNELS_H__
@@ -0,0 +1,180 @@
+/**
+ * @file PlaybackScheduler.cpp
+ * @ingroup Drawing
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#include "PlaybackScheduler.h"
+
+#include <thread>
+
+using namespace MobileRGBD;
+
+/** @brief constructor.
+ *
+ * @param _Policy [in] Drop policy (Default = DropLateFramesAndBase).
+ */
+PlaybackScheduler::PlaybackScheduler( DropPolicy _Policy /* = DropLateFramesAndBase */ )
+	: Cursor( Frames )
+{
+	Policy = _Policy;
+	NextFrame = 0;
+	Started = false;
+	UnderLoad = false;
+	BaseValid = false;
+
+	Stats.FramesShown = 0;
+	Stats.FramesDropped = 0;
+	Stats.BaseLayersKept = 0;
+	Stats.LateFrames = 0;
+	Stats.AverageRenderMilliseconds = 0.0;
+}
+
+/** @brief Open the reference timestamp file giving the frames to render and rewind.
+ *
+ * @param TimestampFile [in] Reference timestamp file (e.g. Folder + "/video/video.timestamp").
+ * @return true if the file was read.
+ */
+bool PlaybackScheduler::Open( const std::string& TimestampFile )
+{
+	bool Ret = Frames.Load( TimestampFile );
+
+	Cursor.Reset();
+	NextFrame = 0;
+	Started = false;
+	UnderLoad = false;
+	BaseValid = false;
+
+	return Ret;
+}
+
+/** @brief Move to a recording time. Next Step renders the frame at this time.
+ *
+ * @param RecordingMilliseconds [in] Recording time in milliseconds since epoch.
+ */
+void PlaybackScheduler::Seek( long long RecordingMilliseconds )
+{
+	int Frame = Cursor.SearchNearest( RecordingMilliseconds );
+	NextFrame = Frame < 0 ? 0 : Frame;
+	BaseValid = false;
+
+	if ( Started && Frame >= 0 )
+	{
+		bool WasPaused = Clock.IsPaused();
+		Clock.Start( Frames.GetMilliseconds( NextFrame ) );
+		if ( WasPaused )
+		{
+			Clock.Pause();
+		}
+	}
+}
+
+/** @brief Render a frame.
+ *
+ * @param Canvas [in] Drawing cv::Mat.
+ * @param Timestamp [in] Timestamp of the frame.
+ * @param RedrawBase [in] Redraw base layers or keep them from the previous frame.
+ */
+void PlaybackScheduler::Render( cv::Mat& Canvas, const TimeB& Timestamp, bool RedrawBase )
+{
+	if ( BaseValid == false || BaseCanvas.size() != Canvas.size() || BaseCanvas.type() != Canvas.type() )
+	{
+		// Nothing to keep
+		RedrawBase = true;
+	}
+
+	if ( RedrawBase )
+	{
+		BaseCanvas.create( Canvas.rows, Canvas.cols, Canvas.type() );
+		BaseCanvas.setTo( cv::Scalar(0,0,0) );
+		for( size_t l = 0; l < BaseLayers.size(); l++ )
+		{
+			BaseLayers[l]->Draw( BaseCanvas, Timestamp );
+		}
+		BaseValid = true;
+	}
+	else
+	{
+		Stats.BaseLayersKept++;
+	}
+
+	BaseCanvas.copyTo( Canvas );
+	for( size_t l = 0; l < Overlays.size(); l++ )
+	{
+		Overlays[l]->Draw( Canvas, Timestamp );
+	}
+}
+
+/** @brief Wait for the next frame to render and render it. The clock starts at the first call.
+ *
+ * @param Canvas [in] Drawing cv::Mat (BGR), its size is the size of rendered frames.
+ * @param Timestamp [out] Timestamp of the rendered frame.
+ * @return false at the end of the recording.
+ */
+bool PlaybackScheduler::Step( cv::Mat& Canvas, TimeB& Timestamp )
+{
+	if ( NextFrame >= Frames.GetNumberOfEntries() )
+	{
+		return false;
+	}
+
+	if ( Started == false )
+	{
+		Clock.Start( Frames.GetMilliseconds( NextFrame ) );
+		Started = true;
+	}
+
+	int Frame = NextFrame;
+	long long Now = Clock.GetMilliseconds();
+
+	if ( Clock.IsPaused() )
+	{
+		// Render the frame at the paused time, nothing is late
+		Frame = Cursor.SearchNearest( Now );
+		Now = Frames.GetMilliseconds( Frame );
+	}
+	else if ( Frames.GetMilliseconds( Frame ) > Now )
+	{
+		// Early, wait for the frame deadline
+		std::this_thread::sleep_until( Clock.GetWallClock( Frames.GetMilliseconds( Frame ) ) );
+	}
+	else if ( Policy != NoDrop )
+	{
+		// Late, render the most recent frame and drop the previous ones
+		int Current = Cursor.SearchPrevious( Now );
+		if ( Current > Frame )
+		{
+			Stats.FramesDropped += Current - Frame;
+			Frame = Current;
+		}
+	}
+
+	if ( Frames.GetMilliseconds( Frame ) < Now )
+	{
+		Stats.LateFrames++;
+	}
+
+	Timestamp = Frames.GetTimestamp( Frame );
+
+	std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+
+	try
+	{
+		Render( Canvas, Timestamp, Policy != DropLateFramesAndBase || UnderLoad == false );
+	}
+	catch( cv::Exception& )
+	{
+	}
+
+	double RenderMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-Start).count();
+	Stats.AverageRenderMilliseconds = Stats.FramesShown == 0 ? RenderMilliseconds : 0.9*Stats.AverageRenderMilliseconds + 0.1*RenderMilliseconds;
+	Stats.FramesShown++;
+
+	// Under load if the next frame is already late: base layers will be kept for one frame
+	UnderLoad = Clock.IsPaused() == false && Frame+1 < Frames.GetNumberOfEntries() && Clock.GetMilliseconds() > Frames.GetMilliseconds( Frame+1 );
+
+	NextFrame = Frame+1;
+
+	return true;
+}
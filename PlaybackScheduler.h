@@ -0,0 +1,254 @@
+/**
+ * @file PlaybackScheduler.h
+ * @ingroup Drawing
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __PLAYBACK_SCHEDULER_H__
+#define __PLAYBACK_SCHEDULER_H__
+
+#include <string>
+#include <vector>
+#include <chrono>
+
+#include "Drawable.h"
+#include "TimestampIndex.h"
+
+namespace MobileRGBD {
+
+/**
+ * @class PlaybackClock PlaybackScheduler.h
+ * @brief Recording time driven by the wall clock: once started at a recording timestamp, recording
+ *        time advances with the wall clock times the speed.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class PlaybackClock
+{
+public:
+	/** @brief constructor. Clock is paused at 0.
+	 */
+	PlaybackClock()
+	{
+		Speed = 1.0;
+		Paused = true;
+		OriginMilliseconds = 0;
+	}
+
+	/** @brief Start (or restart) the clock at a recording time.
+	 *
+	 * @param RecordingMilliseconds [in] Recording time in milliseconds since epoch.
+	 */
+	void Start( long long RecordingMilliseconds )
+	{
+		OriginMilliseconds = RecordingMilliseconds;
+		Origin = std::chrono::steady_clock::now();
+		Paused = false;
+	}
+
+	/** @brief Get the current recording time in milliseconds since epoch.
+	 */
+	long long GetMilliseconds() const
+	{
+		if ( Paused )
+		{
+			return OriginMilliseconds;
+		}
+		return OriginMilliseconds + (long long)(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-Origin).count()*Speed);
+	}
+
+	/** @brief Get the wall clock time of a recording time.
+	 *
+	 * @param RecordingMilliseconds [in] Recording time in milliseconds since epoch.
+	 */
+	std::chrono::steady_clock::time_point GetWallClock( long long RecordingMilliseconds ) const
+	{
+		return Origin + std::chrono::duration_cast<std::chrono::steady_clock::duration>( std::chrono::duration<double, std::milli>( (double)(RecordingMilliseconds-OriginMilliseconds)/Speed ) );
+	}
+
+	/** @brief Pause the clock.
+	 */
+	void Pause()
+	{
+		if ( Paused == false )
+		{
+			OriginMilliseconds = GetMilliseconds();
+			Paused = true;
+		}
+	}
+
+	/** @brief Resume the clock where it was paused.
+	 */
+	void Resume()
+	{
+		if ( Paused )
+		{
+			Start( OriginMilliseconds );
+		}
+	}
+
+	/** @brief Is the clock paused?
+	 */
+	bool IsPaused() const
+	{
+		return Paused;
+	}
+
+	/** @brief Change the speed (1.0 = real time). The current recording time is kept.
+	 *
+	 * @param _Speed [in] New speed, must be positive.
+	 */
+	void SetSpeed( double _Speed )
+	{
+		if ( _Speed <= 0.0 )
+		{
+			return;
+		}
+
+		bool WasPaused = Paused;
+		Pause();
+		Speed = _Speed;
+		if ( WasPaused == false )
+		{
+			Resume();
+		}
+	}
+
+protected:
+	double Speed;										/*!< @brief Recording milliseconds per wall clock millisecond */
+	bool Paused;										/*!< @brief Is the clock paused? */
+	long long OriginMilliseconds;						/*!< @brief Recording time at Origin (or when paused) */
+	std::chrono::steady_clock::time_point Origin;		/*!< @brief Wall clock time of the last start */
+};
+
+/**
+ * @struct PlaybackStats
+ * @brief Counters of a playback.
+ */
+struct PlaybackStats
+{
+	int FramesShown;					/*!< @brief Number of rendered frames */
+	int FramesDropped;					/*!< @brief Number of frames skipped because rendering was late */
+	int BaseLayersKept;					/*!< @brief Number of frames where base layers were not redrawn (under load) */
+	int LateFrames;						/*!< @brief Number of frames rendered after their deadline */
+	double AverageRenderMilliseconds;	/*!< @brief Moving average of the rendering time of a frame */
+};
+
+/**
+ * @class PlaybackScheduler PlaybackScheduler.cpp PlaybackScheduler.h
+ * @brief Replay a recording at wall clock pace. Frames follow a reference timestamp file (video by default).
+ *        Base layers (video, depth, ...) are drawn in a kept canvas, overlays (skeleton, laser, ...) are drawn
+ *        over a copy of it. When rendering misses its deadline, late frames are dropped and, with
+ *        DropLateFramesAndBase, expensive base layers are kept from the previous frame while overlays are
+ *        still drawn at the current time. Layers are not deleted by this object.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class PlaybackScheduler
+{
+public:
+	/** @enum PlaybackScheduler::DropPolicy
+	 *  @brief What to do when rendering is late: render all frames (playback slows down), drop late frames,
+	 *         or drop late frames and keep base layers of the previous frame while under load.
+	 */
+	enum DropPolicy { NoDrop = 0, DropLateFrames = 1, DropLateFramesAndBase = 2 };
+
+	/** @brief constructor.
+	 *
+	 * @param _Policy [in] Drop policy (Default = DropLateFramesAndBase).
+	 */
+	PlaybackScheduler( DropPolicy _Policy = DropLateFramesAndBase );
+
+	/** @brief Virtual destructor, always.
+	 */
+	virtual ~PlaybackScheduler() {}
+
+	/** @brief Open the reference timestamp file giving the frames to render and rewind.
+	 *
+	 * @param TimestampFile [in] Reference timestamp file (e.g. Folder + "/video/video.timestamp").
+	 * @return true if the file was read.
+	 */
+	bool Open( const std::string& TimestampFile );
+
+	/** @brief Add a base layer, drawn before overlays. Base layers may be kept from a previous frame under load.
+	 *
+	 * @param Layer [in] Drawable of the layer.
+	 */
+	void AddBaseLayer( Drawable * Layer )
+	{
+		BaseLayers.push_back( Layer );
+	}
+
+	/** @brief Add an overlay, drawn over base layers at each rendered frame.
+	 *
+	 * @param Layer [in] Drawable of the layer.
+	 */
+	void AddOverlay( Drawable * Layer )
+	{
+		Overlays.push_back( Layer );
+	}
+
+	/** @brief Set the drop policy.
+	 *
+	 * @param _Policy [in] Drop policy.
+	 */
+	void SetPolicy( DropPolicy _Policy )
+	{
+		Policy = _Policy;
+	}
+
+	/** @brief Get the playback clock (pause, resume, speed).
+	 */
+	PlaybackClock& GetClock()
+	{
+		return Clock;
+	}
+
+	/** @brief Get the playback counters.
+	 */
+	const PlaybackStats& GetStats() const
+	{
+		return Stats;
+	}
+
+	/** @brief Wait for the next frame to render and render it. The clock starts at the first call.
+	 *
+	 * @param Canvas [in] Drawing cv::Mat (BGR), its size is the size of rendered frames.
+	 * @param Timestamp [out] Timestamp of the rendered frame.
+	 * @return false at the end of the recording.
+	 */
+	bool Step( cv::Mat& Canvas, TimeB& Timestamp );
+
+	/** @brief Move to a recording time. Next Step renders the frame at this time.
+	 *
+	 * @param RecordingMilliseconds [in] Recording time in milliseconds since epoch.
+	 */
+	void Seek( long long RecordingMilliseconds );
+
+protected:
+	/** @brief Render a frame.
+	 *
+	 * @param Canvas [in] Drawing cv::Mat.
+	 * @param Timestamp [in] Timestamp of the frame.
+	 * @param RedrawBase [in] Redraw base layers or keep them from the previous frame.
+	 */
+	void Render( cv::Mat& Canvas, const TimeB& Timestamp, bool RedrawBase );
+
+	DropPolicy Policy;					/*!< @brief What to do when rendering is late */
+	PlaybackClock Clock;				/*!< @brief Recording time */
+	TimestampIndex Frames;				/*!< @brief Frames to render */
+	TimestampCursor Cursor;				/*!< @brief Search of the frame at the current time */
+	int NextFrame;						/*!< @brief Next frame to render */
+	bool Started;						/*!< @brief Is the clock started? */
+	bool UnderLoad;						/*!< @brief Was the next frame already late after the last rendering? */
+	std::vector<Drawable*> BaseLayers;	/*!< @brief Base layers */
+	std::vector<Drawable*> Overlays;	/*!< @brief Overlays */
+	cv::Mat BaseCanvas;					/*!< @brief Base layers of the last frame */
+	bool BaseValid;						/*!< @brief Does BaseCanvas contain base layers? */
+	PlaybackStats Stats;				/*!< @brief Counters */
+};
+
+} // namespace MobileRGBD
+
+#endif // __PLAYBACK_SCHEDULER_H__
@@ -0,0 +1,443 @@
+/**
+ * @file PresenceIndex.cpp
+ * @ingroup Drawing
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#include "PresenceIndex.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined WIN32 || defined WIN64
+	#define fseek64 _fseeki64
+	#define ftell64 _ftelli64
+#else
+	#define fseek64 fseeko
+	#define ftell64 ftello
+#endif
+
+using namespace MobileRGBD;
+
+namespace {
+
+const char PresenceMagic[4] = { 'P', 'R', 'S', '1' };	// Identify sidecar files (and their version)
+
+/**
+ * @struct PresenceHeader
+ * @brief Header of a sidecar file, followed by timestamps (long long) and runs (PresenceRun).
+ */
+struct PresenceHeader
+{
+	char Magic[4];					/*!< @brief PresenceMagic */
+	int NumberOfEntries;			/*!< @brief Number of timestamps */
+	long long TimestampFileSize;	/*!< @brief Size of the indexed timestamp file */
+	int NumberOfRuns;				/*!< @brief Number of runs */
+	int Reserved;					/*!< @brief Alignment */
+};
+
+/** @brief Get the size of a file, -1 if it can not be read.
+ */
+long long GetFileSize( const std::string& FileName )
+{
+	FILE * fin = fopen( FileName.c_str(), "rb" );
+	if ( fin == nullptr )
+	{
+		return -1;
+	}
+
+	long long Size = -1;
+	if ( fseek64( fin, 0, SEEK_END ) == 0 )
+	{
+		Size = (long long)ftell64( fin );
+	}
+	fclose( fin );
+
+	return Size;
+}
+
+} // anonymous namespace
+
+/** @brief Get the number of sub-frames given by the data of a timestamp line (its last number).
+ *
+ * @param EntryData [in] Data following the timestamp on the line.
+ */
+// static
+int PresenceIndex::ParseCount( const char * EntryData )
+{
+	int Count = 0;
+	const char * Pos = EntryData;
+	while( *Pos != '\0' )
+	{
+		char * End;
+		long Value = strtol( Pos, &End, 10 );
+		if ( End == Pos )
+		{
+			Pos++;
+			continue;
+		}
+		Count = (int)Value;
+		Pos = End;
+	}
+
+	return Count < 0 ? 0 : Count;
+}
+
+/** @brief Add an entry while loading, extending the runs.
+ */
+void PresenceIndex::AddEntry( long long EntryMilliseconds, const char * EntryData, bool KeepData )
+{
+	TimestampIndex::AddEntry( EntryMilliseconds, EntryData, KeepData );
+
+	int Count = ParseCount( EntryData );
+	if ( Runs.empty() == false && Runs.back().Count == Count )
+	{
+		Runs.back().NumberOfEntries++;
+		return;
+	}
+
+	PresenceRun NewRun;
+	NewRun.FirstEntry = (int)Milliseconds.size()-1;
+	NewRun.NumberOfEntries = 1;
+	NewRun.Count = Count;
+	Runs.push_back( NewRun );
+}
+
+/** @brief Build the index from a timestamp file, in one pass.
+ *
+ * @param TimestampFile [in] Timestamp file of the stream.
+ * @return true if the file was read.
+ */
+bool PresenceIndex::Build( const std::string& TimestampFile )
+{
+	Runs.clear();
+
+	bool Ret = Load( TimestampFile );
+	ComputeSubFrames();
+
+	return Ret;
+}
+
+/** @brief Compute RunFirstSubFrame from Runs.
+ */
+void PresenceIndex::ComputeSubFrames()
+{
+	RunFirstSubFrame.resize( Runs.size() );
+
+	long long SubFrame = 0;
+	for( size_t Run = 0; Run < Runs.size(); Run++ )
+	{
+		RunFirstSubFrame[Run] = SubFrame;
+		SubFrame += (long long)Runs[Run].NumberOfEntries*Runs[Run].Count;
+	}
+}
+
+/** @brief Get the position of the first sub-frame of an entry in the raw file of the stream, in sub-frames
+ *         (sub-frames of all entries are stored in order).
+ *
+ * @param Entry [in] Index of the entry, GetNumberOfEntries() for the total number of sub-frames.
+ */
+long long PresenceIndex::GetFirstSubFrame( int Entry ) const
+{
+	if ( Runs.empty() || Entry <= 0 )
+	{
+		return 0;
+	}
+
+	if ( Entry >= GetNumberOfEntries() )
+	{
+		const PresenceRun& Last = Runs.back();
+		return RunFirstSubFrame.back() + (long long)Last.NumberOfEntries*Last.Count;
+	}
+
+	int Run = SearchRun( Entry );
+	return RunFirstSubFrame[Run] + (long long)(Entry - Runs[Run].FirstEntry)*Runs[Run].Count;
+}
+
+/** @brief Get the sidecar file name of a timestamp file (extension replaced by '.presence').
+ */
+// static
+std::string PresenceIndex::GetSidecarFileName( const std::string& TimestampFile )
+{
+	size_t Dot = TimestampFile.find_last_of( '.' );
+	size_t Separator = TimestampFile.find_last_of( "/\\" );
+	if ( Dot == std::string::npos || (Separator != std::string::npos && Dot < Separator) )
+	{
+		return TimestampFile + ".presence";
+	}
+
+	return TimestampFile.substr( 0, Dot ) + ".presence";
+}
+
+/** @brief Write the index in a sidecar file.
+ *
+ * @param SidecarFile [in] Sidecar file.
+ * @param TimestampFileSize [in] Size of the indexed timestamp file, to check if the sidecar is up to date.
+ * @return true if the file was written.
+ */
+bool PresenceIndex::WriteSidecar( const std::string& SidecarFile, long long TimestampFileSize ) const
+{
+	FILE * fout = fopen( SidecarFile.c_str(), "wb" );
+	if ( fout == nullptr )
+	{
+		return false;
+	}
+
+	PresenceHeader Header;
+	memset( &Header, 0, sizeof(Header) );
+	memcpy( Header.Magic, PresenceMagic, sizeof(PresenceMagic) );
+	Header.NumberOfEntries = GetNumberOfEntries();
+	Header.TimestampFileSize = TimestampFileSize;
+	Header.NumberOfRuns = (int)Runs.size();
+
+	bool Ret = fwrite( &Header, sizeof(Header), 1, fout ) == 1;
+	if ( Ret && Milliseconds.empty() == false )
+	{
+		Ret = fwrite( &Milliseconds[0], sizeof(long long), Milliseconds.size(), fout ) == Milliseconds.size();
+	}
+	if ( Ret && Runs.empty() == false )
+	{
+		Ret = fwrite( &Runs[0], sizeof(PresenceRun), Runs.size(), fout ) == Runs.size();
+	}
+
+	fclose( fout );
+
+	if ( Ret == false )
+	{
+		// Do not leave a partial sidecar
+		remove( SidecarFile.c_str() );
+	}
+
+	return Ret;
+}
+
+/** @brief Read the index from a sidecar file.
+ *
+ * @param SidecarFile [in] Sidecar file.
+ * @param TimestampFileSize [in] Size of the indexed timestamp file, the sidecar must be written for this size.
+ * @return true if the sidecar was read and is up to date.
+ */
+bool PresenceIndex::ReadSidecar( const std::string& SidecarFile, long long TimestampFileSize )
+{
+	Milliseconds.clear();
+	Data.clear();
+	Offsets.clear();
+	Runs.clear();
+
+	FILE * fin = fopen( SidecarFile.c_str(), "rb" );
+	if ( fin == nullptr )
+	{
+		return false;
+	}
+
+	PresenceHeader Header;
+	bool Ret = fread( &Header, sizeof(Header), 1, fin ) == 1 && memcmp( Header.Magic, PresenceMagic, sizeof(PresenceMagic) ) == 0 &&
+		Header.TimestampFileSize == TimestampFileSize && Header.NumberOfEntries >= 0 && Header.NumberOfRuns >= 0;
+
+	if ( Ret && Header.NumberOfEntries > 0 )
+	{
+		Milliseconds.resize( Header.NumberOfEntries );
+		Ret = fread( &Milliseconds[0], sizeof(long long), Milliseconds.size(), fin ) == Milliseconds.size();
+	}
+	if ( Ret && Header.NumberOfRuns > 0 )
+	{
+		Runs.resize( Header.NumberOfRuns );
+		Ret = fread( &Runs[0], sizeof(PresenceRun), Runs.size(), fin ) == Runs.size();
+	}
+
+	fclose( fin );
+
+	if ( Ret == false )
+	{
+		Milliseconds.clear();
+		Runs.clear();
+	}
+	ComputeSubFrames();
+
+	return Ret;
+}
+
+/** @brief Open the index of a timestamp file: read its sidecar if it is up to date, otherwise build
+ *         the index from the timestamp file and write the sidecar.
+ *
+ * @param TimestampFile [in] Timestamp file of the stream.
+ * @return true if the index is available.
+ */
+bool PresenceIndex::Open( const std::string& TimestampFile )
+{
+	long long TimestampFileSize = GetFileSize( TimestampFile );
+	if ( TimestampFileSize < 0 )
+	{
+		return false;
+	}
+
+	std::string SidecarFile = GetSidecarFileName( TimestampFile );
+	if ( ReadSidecar( SidecarFile, TimestampFileSize ) )
+	{
+		return true;
+	}
+
+	if ( Build( TimestampFile ) == false )
+	{
+		return false;
+	}
+
+	// Index is usable even if the sidecar can not be written (read only folder)
+	WriteSidecar( SidecarFile, TimestampFileSize );
+
+	return true;
+}
+
+/** @brief Search the run containing an entry.
+ *
+ * @return the index of the run, -1 if the entry is out of the index.
+ */
+int PresenceIndex::SearchRun( int Entry ) const
+{
+	if ( Entry < 0 || Entry >= GetNumberOfEntries() )
+	{
+		return -1;
+	}
+
+	// Last run starting at or before Entry
+	int Low = 0;
+	int High = (int)Runs.size();
+	while( Low < High )
+	{
+		int Middle = Low + (High-Low)/2;
+		if ( Runs[Middle].FirstEntry <= Entry )
+		{
+			Low = Middle+1;
+		}
+		else
+		{
+			High = Middle;
+		}
+	}
+
+	return Low-1;
+}
+
+/** @brief Get the number of sub-frames of an entry.
+ *
+ * @param Entry [in] Index of the entry.
+ */
+int PresenceIndex::GetCount( int Entry ) const
+{
+	int Run = SearchRun( Entry );
+
+	return Run < 0 ? 0 : Runs[Run].Count;
+}
+
+/** @brief Search the first entry after an entry with at least MinCount sub-frames.
+ *
+ * @param Entry [in] Start of the search (excluded), -1 to search from the beginning.
+ * @param MinCount [in] Minimum number of sub-frames (Default = 1).
+ * @return the entry, -1 if none.
+ */
+int PresenceIndex::SearchNextOccupied( int Entry, int MinCount /* = 1 */ ) const
+{
+	int Next = Entry < 0 ? 0 : Entry+1;
+	int Run = SearchRun( Next );
+	if ( Run < 0 )
+	{
+		return -1;
+	}
+
+	if ( Runs[Run].Count >= MinCount )
+	{
+		return Next;
+	}
+
+	for( Run++; Run < (int)Runs.size(); Run++ )
+	{
+		if ( Runs[Run].Count >= MinCount )
+		{
+			return Runs[Run].FirstEntry;
+		}
+	}
+
+	return -1;
+}
+
+/** @brief Search the last entry before an entry with at least MinCount sub-frames.
+ *
+ * @param Entry [in] Start of the search (excluded), GetNumberOfEntries() to search from the end.
+ * @param MinCount [in] Minimum number of sub-frames (Default = 1).
+ * @return the entry, -1 if none.
+ */
+int PresenceIndex::SearchPreviousOccupied( int Entry, int MinCount /* = 1 */ ) const
+{
+	int Previous = Entry > GetNumberOfEntries() ? GetNumberOfEntries()-1 : Entry-1;
+	int Run = SearchRun( Previous );
+	if ( Run < 0 )
+	{
+		return -1;
+	}
+
+	if ( Runs[Run].Count >= MinCount )
+	{
+		return Previous;
+	}
+
+	for( Run--; Run >= 0; Run-- )
+	{
+		if ( Runs[Run].Count >= MinCount )
+		{
+			return Runs[Run].FirstEntry + Runs[Run].NumberOfEntries - 1;
+		}
+	}
+
+	return -1;
+}
+
+/** @brief Find entries with at least MinCount sub-frames in a range of entries.
+ *
+ * @param FirstEntry [in] First entry of the range.
+ * @param LastEntry [in] Last entry of the range (included).
+ * @param MinCount [in] Minimum number of sub-frames.
+ * @param Found [out] Found entries, as runs (consecutive runs with different counts are not merged).
+ * @return the number of found entries.
+ */
+int PresenceIndex::FindOccupied( int FirstEntry, int LastEntry, int MinCount, std::vector<PresenceRun>& Found ) const
+{
+	Found.clear();
+
+	if ( FirstEntry < 0 )
+	{
+		FirstEntry = 0;
+	}
+	if ( LastEntry >= GetNumberOfEntries() )
+	{
+		LastEntry = GetNumberOfEntries()-1;
+	}
+
+	int NumberOfFound = 0;
+	for( int Run = SearchRun( FirstEntry ); Run >= 0 && Run < (int)Runs.size() && Runs[Run].FirstEntry <= LastEntry; Run++ )
+	{
+		if ( Runs[Run].Count < MinCount )
+		{
+			continue;
+		}
+
+		// Part of the run in the range
+		PresenceRun Part = Runs[Run];
+		int End = Part.FirstEntry + Part.NumberOfEntries - 1;
+		if ( Part.FirstEntry < FirstEntry )
+		{
+			Part.FirstEntry = FirstEntry;
+		}
+		if ( End > LastEntry )
+		{
+			End = LastEntry;
+		}
+		Part.NumberOfEntries = End - Part.FirstEntry + 1;
+
+		Found.push_back( Part );
+		NumberOfFound += Part.NumberOfEntries;
+	}
+
+	return NumberOfFound;
+}
@@ -0,0 +1,159 @@
+/**
+ * @file PresenceIndex.h
+ * @ingroup Drawing
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __PRESENCE_INDEX_H__
+#define __PRESENCE_INDEX_H__
+
+#include <string>
+#include <vector>
+
+#include "TimestampIndex.h"
+
+namespace MobileRGBD {
+
+/**
+ * @struct PresenceRun
+ * @brief Consecutive entries of a stream with the same number of sub-frames (bodies, faces...).
+ */
+struct PresenceRun
+{
+	int FirstEntry;				/*!< @brief First entry of the run */
+	int NumberOfEntries;		/*!< @brief Number of entries in the run */
+	int Count;					/*!< @brief Number of sub-frames of each entry */
+};
+
+/**
+ * @class PresenceIndex PresenceIndex.cpp PresenceIndex.h
+ * @brief Index of a sub-frames stream (skeleton, face) giving the number of sub-frames of each entry
+ *        without reading frames. Counts are stored as a run-length list, built in one pass over the
+ *        timestamp file and saved with the timestamps in a sidecar file ('.presence' next to the
+ *        timestamp file) loaded in one read afterwards. Searching the next or previous occupied entry
+ *        or the entries with N sub-frames or more in a range is a binary search and a walk on runs.
+ *        The number of sub-frames of an entry is the last number on its line in the timestamp file.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class PresenceIndex : public TimestampIndex
+{
+public:
+	/** @brief constructor. Empty index.
+	 */
+	PresenceIndex() {}
+
+	/** @brief Virtual destructor, always.
+	 */
+	virtual ~PresenceIndex() {}
+
+	/** @brief Open the index of a timestamp file: read its sidecar if it is up to date, otherwise build
+	 *         the index from the timestamp file and write the sidecar.
+	 *
+	 * @param TimestampFile [in] Timestamp file of the stream.
+	 * @return true if the index is available.
+	 */
+	bool Open( const std::string& TimestampFile );
+
+	/** @brief Build the index from a timestamp file, in one pass.
+	 *
+	 * @param TimestampFile [in] Timestamp file of the stream.
+	 * @return true if the file was read.
+	 */
+	bool Build( const std::string& TimestampFile );
+
+	/** @brief Write the index in a sidecar file.
+	 *
+	 * @param SidecarFile [in] Sidecar file.
+	 * @param TimestampFileSize [in] Size of the indexed timestamp file, to check if the sidecar is up to date.
+	 * @return true if the file was written.
+	 */
+	bool WriteSidecar( const std::string& SidecarFile, long long TimestampFileSize ) const;
+
+	/** @brief Read the index from a sidecar file.
+	 *
+	 * @param SidecarFile [in] Sidecar file.
+	 * @param TimestampFileSize [in] Size of the indexed timestamp file, the sidecar must be written for this size.
+	 * @return true if the sidecar was read and is up to date.
+	 */
+	bool ReadSidecar( const std::string& SidecarFile, long long TimestampFileSize );
+
+	/** @brief Get the sidecar file name of a timestamp file (extension replaced by '.presence').
+	 */
+	static std::string GetSidecarFileName( const std::string& TimestampFile );
+
+	/** @brief Get the number of sub-frames of an entry.
+	 *
+	 * @param Entry [in] Index of the entry.
+	 */
+	int GetCount( int Entry ) const;
+
+	/** @brief Search the first entry after an entry with at least MinCount sub-frames.
+	 *
+	 * @param Entry [in] Start of the search (excluded), -1 to search from the beginning.
+	 * @param MinCount [in] Minimum number of sub-frames (Default = 1).
+	 * @return the entry, -1 if none.
+	 */
+	int SearchNextOccupied( int Entry, int MinCount = 1 ) const;
+
+	/** @brief Search the last entry before an entry with at least MinCount sub-frames.
+	 *
+	 * @param Entry [in] Start of the search (excluded), GetNumberOfEntries() to search from the end.
+	 * @param MinCount [in] Minimum number of sub-frames (Default = 1).
+	 * @return the entry, -1 if none.
+	 */
+	int SearchPreviousOccupied( int Entry, int MinCount = 1 ) const;
+
+	/** @brief Find entries with at least MinCount sub-frames in a range of entries.
+	 *
+	 * @param FirstEntry [in] First entry of the range.
+	 * @param LastEntry [in] Last entry of the range (included).
+	 * @param MinCount [in] Minimum number of sub-frames.
+	 * @param Found [out] Found entries, as runs (consecutive runs with different counts are not merged).
+	 * @return the number of found entries.
+	 */
+	int FindOccupied( int FirstEntry, int LastEntry, int MinCount, std::vector<PresenceRun>& Found ) const;
+
+	/** @brief Get the position of the first sub-frame of an entry in the raw file of the stream, in sub-frames
+	 *         (sub-frames of all entries are stored in order).
+	 *
+	 * @param Entry [in] Index of the entry, GetNumberOfEntries() for the total number of sub-frames.
+	 */
+	long long GetFirstSubFrame( int Entry ) const;
+
+	/** @brief Get the runs of the index.
+	 */
+	const std::vector<PresenceRun>& GetRuns() const
+	{
+		return Runs;
+	}
+
+	/** @brief Get the number of sub-frames given by the data of a timestamp line (its last number).
+	 *
+	 * @param EntryData [in] Data following the timestamp on the line.
+	 */
+	static int ParseCount( const char * EntryData );
+
+protected:
+	/** @brief Add an entry while loading, extending the runs.
+	 */
+	virtual void AddEntry( long long EntryMilliseconds, const char * EntryData, bool KeepData );
+
+	/** @brief Search the run containing an entry.
+	 *
+	 * @return the index of the run, -1 if the entry is out of the index.
+	 */
+	int SearchRun( int Entry ) const;
+
+	/** @brief Compute RunFirstSubFrame from Runs.
+	 */
+	void ComputeSubFrames();
+
+	std::vector<PresenceRun> Runs;		/*!< @brief Counts of all entries, in order */
+	std::vector<long long> RunFirstSubFrame;	/*!< @brief First sub-frame of each run in the raw file */
+};
+
+} // namespace MobileRGBD
+
+#endif // __PRESENCE_INDEX_H__
@@ -0,0 +1,269 @@
+/**
+ * @file ProxyGenerator.cpp
+ * @ingroup Drawing Kinect
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#include "ProxyGenerator.h"
+
+#ifdef KINECT_2
+
+#include "DrawCameraView.h"
+#include "DrawDepthView.h"
+#include "DrawInfraredView.h"
+#include "DrawBodyIndexView.h"
+
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+
+#undef min
+#include <algorithm>
+
+namespace MobileRGBD { namespace Kinect2 {
+
+/** @brief Write all proxies of a recording. Missing streams are skipped.
+ *
+ * @param Folder [in] Main folder containing the data.
+ * @return the number of written proxies.
+ */
+// static
+int ProxyGenerator::GenerateAll( const std::string& Folder )
+{
+	int NumberOfProxies = 0;
+
+	NumberOfProxies += GenerateVideo( Folder ) ? 1 : 0;
+	NumberOfProxies += GenerateDepth( Folder ) ? 1 : 0;
+	NumberOfProxies += GenerateInfrared( Folder ) ? 1 : 0;
+	NumberOfProxies += GenerateBodyIndex( Folder ) ? 1 : 0;
+
+	return NumberOfProxies;
+}
+
+/** @brief Write the proxy of the video stream.
+ *
+ * @param Folder [in] Main folder containing the data.
+ * @return true if the proxy was written.
+ */
+// static
+bool ProxyGenerator::GenerateVideo( const std::string& Folder )
+{
+	return Generate( Folder + RawVideoFileName, CamWidth*CamHeight*CamBytesPerPixel, Folder + ProxyVideoFileName, ProxyCamFrameSize, ReduceVideoFrame );
+}
+
+/** @brief Write the proxy of the depth stream.
+ *
+ * @param Folder [in] Main folder containing the data.
+ * @return true if the proxy was written.
+ */
+// static
+bool ProxyGenerator::GenerateDepth( const std::string& Folder )
+{
+	return Generate( Folder + RawDepthFileName, DepthWidth*DepthHeight*DepthBytesPerPixel, Folder + ProxyDepthFileName, ProxyDepthFrameSize, ReduceDepthFrame );
+}
+
+/** @brief Write the proxy of the infrared stream.
+ *
+ * @param Folder [in] Main folder containing the data.
+ * @return true if the proxy was written.
+ */
+// static
+bool ProxyGenerator::GenerateInfrared( const std::string& Folder )
+{
+	return Generate( Folder + RawInfraredFileName, InfraredWidth*InfraredHeight*InfraredBytesPerPixel, Folder + ProxyInfraredFileName, ProxyDepthFrameSize, ReduceInfraredFrame );
+}
+
+/** @brief Write the proxy of the body_index stream.
+ *
+ * @param Folder [in] Main folder containing the data.
+ * @return true if the proxy was written.
+ */
+// static
+bool ProxyGenerator::GenerateBodyIndex( const std::string& Folder )
+{
+	return Generate( Folder + RawBodyIndexFileName, DepthWidth*DepthHeight, Folder + ProxyBodyIndexFileName, ProxyDepthFrameSize, ReduceBodyIndexFrame );
+}
+
+/** @brief Read all frames of a raw file, reduce them and write them in the proxy file.
+ *
+ * @param RawFile [in] Raw file to read.
+ * @param FrameSize [in] Size of frames in the raw file.
+ * @param ProxyFile [in] Proxy file to write. Removed on error.
+ * @param ProxyFrameSize [in] Size of frames in the proxy file.
+ * @param Reducer [in] Function reducing frames.
+ * @return true if the proxy was written.
+ */
+// static
+bool ProxyGenerator::Generate( const std::string& RawFile, int FrameSize, const std::string& ProxyFile, int ProxyFrameSize, FrameReducer Reducer )
+{
+	FILE * fin = fopen( RawFile.c_str(), "rb" );
+	if ( fin == nullptr )
+	{
+		return false;
+	}
+
+	FILE * fout = fopen( ProxyFile.c_str(), "wb" );
+	if ( fout == nullptr )
+	{
+		fclose( fin );
+		return false;
+	}
+
+	std::vector<unsigned char> Frame( FrameSize );
+	std::vector<unsigned char> ProxyFrame( ProxyFrameSize );
+
+	// Frame i of the proxy is frame i of the raw file, so the timestamp file is valid for both
+	bool Ret = true;
+	while( fread( &Frame[0], FrameSize, 1, fin ) == 1 )
+	{
+		Reducer( &Frame[0], &ProxyFrame[0] );
+		if ( fwrite( &ProxyFrame[0], ProxyFrameSize, 1, fout ) != 1 )
+		{
+			Ret = false;
+			break;
+		}
+	}
+
+	if ( ferror( fin ) != 0 )
+	{
+		Ret = false;
+	}
+
+	fclose( fin );
+	if ( fclose( fout ) != 0 )
+	{
+		Ret = false;
+	}
+
+	if ( Ret == false )
+	{
+		// Do not leave a truncated proxy
+		remove( ProxyFile.c_str() );
+	}
+
+	return Ret;
+}
+
+/** @brief Reduce a YUY2 video frame to 1/4 resolution (mean of 4x4 blocks for Y, of 8x4 blocks for U and V).
+ *
+ * @param Frame [in] Video frame (CamWidth*CamHeight*CamBytesPerPixel).
+ * @param ProxyFrame [out] Proxy frame (ProxyCamFrameSize).
+ */
+// static
+void ProxyGenerator::ReduceVideoFrame( const unsigned char * Frame, unsigned char * ProxyFrame )
+{
+	const int LineSize = CamWidth*CamBytesPerPixel;
+
+	// A YUY2 macro pixel (Y0 U Y1 V) is 2 pixels. A proxy macro pixel covers 4 lines of 4 macro pixels (16 bytes)
+	for( int line = 0; line < ProxyCamHeight; line++ )
+	{
+		const unsigned char * Block = Frame + line*4*LineSize;
+		for( int MacroPixel = 0; MacroPixel < ProxyCamWidth/2; MacroPixel++, Block += 16 )
+		{
+			int Y0 = 0, Y1 = 0, U = 0, V = 0;
+			for( int SubLine = 0; SubLine < 4; SubLine++ )
+			{
+				const unsigned char * Src = Block + SubLine*LineSize;
+				Y0 += Src[0] + Src[2] + Src[4] + Src[6];
+				Y1 += Src[8] + Src[10] + Src[12] + Src[14];
+				U += Src[1] + Src[5] + Src[9] + Src[13];
+				V += Src[3] + Src[7] + Src[11] + Src[15];
+			}
+
+			*ProxyFrame++ = (unsigned char)((Y0+8)/16);
+			*ProxyFrame++ = (unsigned char)((U+8)/16);
+			*ProxyFrame++ = (unsigned char)((Y1+8)/16);
+			*ProxyFrame++ = (unsigned char)((V+8)/16);
+		}
+	}
+}
+
+/** @brief Reduce a depth frame to 1/2 resolution (mean of valid values of 2x2 blocks) with 8 bits gamma coded values.
+ *
+ * @param Frame [in] Depth frame (DepthWidth*DepthHeight*DepthBytesPerPixel).
+ * @param ProxyFrame [out] Proxy frame (ProxyDepthFrameSize).
+ */
+// static
+void ProxyGenerator::ReduceDepthFrame( const unsigned char * Frame, unsigned char * ProxyFrame )
+{
+	const unsigned short int * Table = (const unsigned short int *)Frame;
+
+	for( int line = 0; line < ProxyDepthHeight; line++ )
+	{
+		const unsigned short int * Src = Table + line*2*DepthWidth;
+		for( int col = 0; col < ProxyDepthWidth; col++, Src += 2 )
+		{
+			// 0 means no depth, do not average it with valid values
+			const unsigned short int Values[4] = { Src[0], Src[1], Src[DepthWidth], Src[DepthWidth+1] };
+			int Sum = 0;
+			int NumberOfValues = 0;
+			for( int v = 0; v < 4; v++ )
+			{
+				if ( Values[v] != 0 )
+				{
+					Sum += Values[v];
+					NumberOfValues++;
+				}
+			}
+
+			if ( NumberOfValues == 0 )
+			{
+				*ProxyFrame++ = 0;
+				continue;
+			}
+
+			// Same gamma coding as DrawDepthView
+			float originalBrightnessValue = ((float)Sum/(float)NumberOfValues)/(65536.f);
+			float gammaAppliedValue = pow(originalBrightnessValue, .32f);
+			*ProxyFrame++ = (unsigned char)(std::min(gammaAppliedValue, 1.0f)*255.0f);
+		}
+	}
+}
+
+/** @brief Reduce an infrared frame to 1/2 resolution (mean of 2x2 blocks) with 8 bits gamma coded values.
+ *
+ * @param Frame [in] Infrared frame (InfraredWidth*InfraredHeight*InfraredBytesPerPixel).
+ * @param ProxyFrame [out] Proxy frame (ProxyDepthFrameSize).
+ */
+// static
+void ProxyGenerator::ReduceInfraredFrame( const unsigned char * Frame, unsigned char * ProxyFrame )
+{
+	const unsigned short int * Table = (const unsigned short int *)Frame;
+
+	for( int line = 0; line < ProxyDepthHeight; line++ )
+	{
+		const unsigned short int * Src = Table + line*2*InfraredWidth;
+		for( int col = 0; col < ProxyDepthWidth; col++, Src += 2 )
+		{
+			int Sum = Src[0] + Src[1] + Src[InfraredWidth] + Src[InfraredWidth+1];
+
+			// Same gamma coding as DrawInfraredView
+			float originalBrightnessValue = ((float)Sum/4.0f)/(8192.f);
+			float gammaAppliedValue = pow(originalBrightnessValue, .32f);
+			*ProxyFrame++ = (unsigned char)(std::min(gammaAppliedValue, 1.0f)*255.0f);
+		}
+	}
+}
+
+/** @brief Reduce a body_index frame to 1/2 resolution (one pixel out of 2 in each direction, indexes cannot be averaged).
+ *
+ * @param Frame [in] Body index frame (DepthWidth*DepthHeight).
+ * @param ProxyFrame [out] Proxy frame (ProxyDepthFrameSize).
+ */
+// static
+void ProxyGenerator::ReduceBodyIndexFrame( const unsigned char * Frame, unsigned char * ProxyFrame )
+{
+	for( int line = 0; line < ProxyDepthHeight; line++ )
+	{
+		const unsigned char * Src = Frame + line*2*DepthWidth;
+		for( int col = 0; col < ProxyDepthWidth; col++, Src += 2 )
+		{
+			*ProxyFrame++ = *Src;
+		}
+	}
+}
+
+}} // namespace MobileRGBD::Kinect2
+
+#endif // KINECT_2
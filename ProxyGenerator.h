@@ -0,0 +1,131 @@
+/**
+ * @file ProxyGenerator.h
+ * @ingroup Drawing Kinect
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __PROXY_GENERATOR_H__
+#define __PROXY_GENERATOR_H__
+
+#ifdef KINECT_2
+
+#include <string>
+
+#include "../Kinect/KinectBasics.h"
+
+#define ProxyVideoFileName "/video/video.proxy.raw"					/*!< @brief Proxy raw file for the video input from Kinect2 */
+#define ProxyDepthFileName "/depth/depth.proxy.raw"					/*!< @brief Proxy raw file for the depth input from Kinect2 */
+#define ProxyInfraredFileName "/infrared/infrared.proxy.raw"		/*!< @brief Proxy raw file for the infrared input from Kinect2 */
+#define ProxyBodyIndexFileName "/body_index/body_index.proxy.raw"	/*!< @brief Proxy raw file for the body_index from Kinect2 */
+
+namespace MobileRGBD { namespace Kinect2 {
+
+// Video proxy: 1/4 resolution, still YUY2
+const int ProxyCamWidth = CamWidth/4;										/*!< @brief Width of video proxy frames */
+const int ProxyCamHeight = CamHeight/4;										/*!< @brief Height of video proxy frames */
+const int ProxyCamFrameSize = ProxyCamWidth*ProxyCamHeight*CamBytesPerPixel;	/*!< @brief Size of video proxy frames */
+
+// Depth and infrared proxies: 1/2 resolution, 8 bits gamma coded values
+const int ProxyDepthWidth = DepthWidth/2;									/*!< @brief Width of depth, infrared and body_index proxy frames */
+const int ProxyDepthHeight = DepthHeight/2;									/*!< @brief Height of depth, infrared and body_index proxy frames */
+const int ProxyDepthFrameSize = ProxyDepthWidth*ProxyDepthHeight;			/*!< @brief Size of depth, infrared and body_index proxy frames (1 byte per pixel) */
+
+/**
+ * @class ProxyGenerator ProxyGenerator.cpp ProxyGenerator.h
+ * @brief Write proxies of Kinect2 raw files: smaller versions of each frame, in the same order than
+ *        in the raw file. A proxy uses the timestamp file of its raw file and is read by views
+ *        (see DrawRawData::OpenProxy) when the target image is not larger than proxy frames.
+ *        Video proxy is 1/4 resolution YUY2 (16 times smaller), depth and infrared proxies are 1/2
+ *        resolution 8 bits values (8 times smaller), body_index proxy is 1/2 resolution (4 times smaller).
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class ProxyGenerator
+{
+public:
+	/** @brief Write all proxies of a recording. Missing streams are skipped.
+	 *
+	 * @param Folder [in] Main folder containing the data.
+	 * @return the number of written proxies.
+	 */
+	static int GenerateAll( const std::string& Folder );
+
+	/** @brief Write the proxy of the video stream.
+	 *
+	 * @param Folder [in] Main folder containing the data.
+	 * @return true if the proxy was written.
+	 */
+	static bool GenerateVideo( const std::string& Folder );
+
+	/** @brief Write the proxy of the depth stream.
+	 *
+	 * @param Folder [in] Main folder containing the data.
+	 * @return true if the proxy was written.
+	 */
+	static bool GenerateDepth( const std::string& Folder );
+
+	/** @brief Write the proxy of the infrared stream.
+	 *
+	 * @param Folder [in] Main folder containing the data.
+	 * @return true if the proxy was written.
+	 */
+	static bool GenerateInfrared( const std::string& Folder );
+
+	/** @brief Write the proxy of the body_index stream.
+	 *
+	 * @param Folder [in] Main folder containing the data.
+	 * @return true if the proxy was written.
+	 */
+	static bool GenerateBodyIndex( const std::string& Folder );
+
+	/** @brief Reduce a YUY2 video frame to 1/4 resolution (mean of 4x4 blocks for Y, of 8x4 blocks for U and V).
+	 *
+	 * @param Frame [in] Video frame (CamWidth*CamHeight*CamBytesPerPixel).
+	 * @param ProxyFrame [out] Proxy frame (ProxyCamFrameSize).
+	 */
+	static void ReduceVideoFrame( const unsigned char * Frame, unsigned char * ProxyFrame );
+
+	/** @brief Reduce a depth frame to 1/2 resolution (mean of valid values of 2x2 blocks) with 8 bits gamma coded values.
+	 *
+	 * @param Frame [in] Depth frame (DepthWidth*DepthHeight*DepthBytesPerPixel).
+	 * @param ProxyFrame [out] Proxy frame (ProxyDepthFrameSize).
+	 */
+	static void ReduceDepthFrame( const unsigned char * Frame, unsigned char * ProxyFrame );
+
+	/** @brief Reduce an infrared frame to 1/2 resolution (mean of 2x2 blocks) with 8 bits gamma coded values.
+	 *
+	 * @param Frame [in] Infrared frame (InfraredWidth*InfraredHeight*InfraredBytesPerPixel).
+	 * @param ProxyFrame [out] Proxy frame (ProxyDepthFrameSize).
+	 */
+	static void ReduceInfraredFrame( const unsigned char * Frame, unsigned char * ProxyFrame );
+
+	/** @brief Reduce a body_index frame to 1/2 resolution (one pixel out of 2 in each direction, indexes cannot be averaged).
+	 *
+	 * @param Frame [in] Body index frame (DepthWidth*DepthHeight).
+	 * @param ProxyFrame [out] Proxy frame (ProxyDepthFrameSize).
+	 */
+	static void ReduceBodyIndexFrame( const unsigned char * Frame, unsigned char * ProxyFrame );
+
+protected:
+	/** @brief Function reducing a frame to a proxy frame.
+	 */
+	typedef void (*FrameReducer)( const unsigned char * Frame, unsigned char * ProxyFrame );
+
+	/** @brief Read all frames of a raw file, reduce them and write them in the proxy file.
+	 *
+	 * @param RawFile [in] Raw file to read.
+	 * @param FrameSize [in] Size of frames in the raw file.
+	 * @param ProxyFile [in] Proxy file to write. Removed on error.
+	 * @param ProxyFrameSize [in] Size of frames in the proxy file.
+	 * @param Reducer [in] Function reducing frames.
+	 * @return true if the proxy was written.
+	 */
+	static bool Generate( const std::string& RawFile, int FrameSize, const std::string& ProxyFile, int ProxyFrameSize, FrameReducer Reducer );
+};
+
+}} // namespace MobileRGBD::Kinect2
+
+#endif // KINECT_2
+
+#endif // __PROXY_GENERATOR_H__
@@ -0,0 +1,190 @@
+/**
+ * @file RvlCodec.cpp
+ * @ingroup Drawing
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#include "RvlCodec.h"
+#include "IndexedFrameFile.h"
+
+#include <stdio.h>
+
+using namespace MobileRGBD;
+
+namespace {
+
+/**
+ * @struct NibbleWriter
+ * @brief Write variable length numbers in 32 bits words.
+ */
+struct NibbleWriter
+{
+	/** @brief constructor.
+	 */
+	NibbleWriter( std::vector<unsigned char>& _Output ) : Output( _Output )
+	{
+		Word = 0;
+		NibblesWritten = 0;
+	}
+
+	/** @brief Write a variable length number: 3 bits per nibble, high bit set if more nibbles follow.
+	 */
+	void EncodeVLE( unsigned int Value )
+	{
+		do
+		{
+			unsigned int Nibble = Value & 0x7;
+			Value >>= 3;
+			if ( Value != 0 )
+			{
+				Nibble |= 0x8;
+			}
+			Word <<= 4;
+			Word |= Nibble;
+			if ( ++NibblesWritten == 8 )
+			{
+				Flush();
+			}
+		}
+		while( Value != 0 );
+	}
+
+	/** @brief Write the current word, even if not full.
+	 */
+	void Flush()
+	{
+		if ( NibblesWritten == 0 )
+		{
+			return;
+		}
+
+		// Align remaining nibbles on the high bits
+		Word <<= 4*(8-NibblesWritten);
+
+		size_t Pos = Output.size();
+		Output.resize( Pos + sizeof(Word) );
+		memcpy( &Output[Pos], &Word, sizeof(Word) );
+
+		Word = 0;
+		NibblesWritten = 0;
+	}
+
+	std::vector<unsigned char>& Output;		/*!< @brief Compressed data */
+	unsigned int Word;						/*!< @brief Current word */
+	int NibblesWritten;						/*!< @brief Number of nibbles in Word */
+};
+
+} // anonymous namespace
+
+/** @brief Compress a depth frame.
+ *
+ * @param Frame [in] Depth values.
+ * @param NumberOfPixels [in] Number of values in Frame.
+ * @param Compressed [out] Compressed frame.
+ * @return the size of the compressed frame.
+ */
+// static
+int RvlCodec::Compress( const unsigned short int * Frame, int NumberOfPixels, std::vector<unsigned char>& Compressed )
+{
+	Compressed.clear();
+
+	NibbleWriter Writer( Compressed );
+
+	const unsigned short int * End = Frame + NumberOfPixels;
+	int Previous = 0;
+	while( Frame != End )
+	{
+		int Zeros = 0;
+		for( ; Frame != End && *Frame == 0; Frame++ )
+		{
+			Zeros++;
+		}
+		Writer.EncodeVLE( Zeros );
+
+		int NonZeros = 0;
+		for( const unsigned short int * p = Frame; p != End && *p != 0; p++ )
+		{
+			NonZeros++;
+		}
+		Writer.EncodeVLE( NonZeros );
+
+		for( int i = 0; i < NonZeros; i++ )
+		{
+			int Current = *Frame++;
+			int Delta = Current - Previous;
+			Writer.EncodeVLE( ((unsigned int)Delta << 1) ^ (unsigned int)(Delta >> 31) );	// zigzag
+			Previous = Current;
+		}
+	}
+
+	Writer.Flush();
+
+	return (int)Compressed.size();
+}
+
+/** @brief Decompress a depth frame.
+ *
+ * @param Compressed [in] Compressed frame.
+ * @param CompressedSize [in] Size of the compressed frame.
+ * @param Frame [out] Depth values.
+ * @param NumberOfPixels [in] Number of values in Frame.
+ * @return true if the frame was decoded.
+ */
+// static
+bool RvlCodec::Decompress( const unsigned char * Compressed, int CompressedSize, unsigned short int * Frame, int NumberOfPixels )
+{
+	DepthSink Sink;
+	Sink.Pos = Frame;
+
+	return Decode( Compressed, CompressedSize, NumberOfPixels, Sink );
+}
+
+/** @brief Compress all frames of a raw depth file to a data file and its index (see IndexedFrameFile).
+ *         Frames are in the same order, so the timestamp file of the raw file remains valid.
+ *
+ * @param RawFile [in] Raw depth file.
+ * @param NumberOfPixels [in] Number of pixels of each frame (2 bytes per pixel).
+ * @param RvlFile [in] Compressed data file to write.
+ * @param IndexFile [in] Index file to write.
+ * @return true if the files were written.
+ */
+// static
+bool RvlCodec::ConvertRawFile( const std::string& RawFile, int NumberOfPixels, const std::string& RvlFile, const std::string& IndexFile )
+{
+	FILE * fin = fopen( RawFile.c_str(), "rb" );
+	if ( fin == nullptr )
+	{
+		return false;
+	}
+
+	IndexedFrameFileWriter Writer;
+	if ( Writer.Open( RvlFile, IndexFile ) == false )
+	{
+		fclose( fin );
+		return false;
+	}
+
+	std::vector<unsigned short int> Frame( NumberOfPixels );
+	std::vector<unsigned char> Compressed;
+
+	bool Ret = true;
+	while( fread( &Frame[0], NumberOfPixels*sizeof(unsigned short int), 1, fin ) == 1 )
+	{
+		int Size = Compress( &Frame[0], NumberOfPixels, Compressed );
+		if ( Writer.AddFrame( &Compressed[0], Size, NumberOfPixels ) == false )
+		{
+			Ret = false;
+			break;
+		}
+	}
+
+	if ( ferror( fin ) != 0 )
+	{
+		Ret = false;
+	}
+	fclose( fin );
+
+	// Do not leave truncated files
+	return Writer.Close( Ret == false ) && Ret;
+}
@@ -0,0 +1,197 @@
+/**
+ * @file RvlCodec.h
+ * @ingroup Drawing
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __RVL_CODEC_H__
+#define __RVL_CODEC_H__
+
+#include <string.h>
+#include <string>
+#include <vector>
+
+namespace MobileRGBD {
+
+/**
+ * @class RvlCodec RvlCodec.cpp RvlCodec.h
+ * @brief Lossless compression of 16 bits depth frames (RVL, Run length Variable Length, A. D. Wilson 2017).
+ *        A frame is coded as runs of zeros (no depth) and runs of non zero values; non zero values are
+ *        coded as the zigzag delta with the previous value. All numbers are written with a variable
+ *        number of 4 bits nibbles (3 bits of value and a continuation bit), packed in 32 bits words.
+ *        Decoding is a single pass over the data: pixels are given to a sink (see Decode) so they can
+ *        be converted for drawing without an intermediate 16 bits frame.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class RvlCodec
+{
+public:
+	/** @brief Compress a depth frame.
+	 *
+	 * @param Frame [in] Depth values.
+	 * @param NumberOfPixels [in] Number of values in Frame.
+	 * @param Compressed [out] Compressed frame.
+	 * @return the size of the compressed frame.
+	 */
+	static int Compress( const unsigned short int * Frame, int NumberOfPixels, std::vector<unsigned char>& Compressed );
+
+	/** @brief Decompress a depth frame.
+	 *
+	 * @param Compressed [in] Compressed frame.
+	 * @param CompressedSize [in] Size of the compressed frame.
+	 * @param Frame [out] Depth values.
+	 * @param NumberOfPixels [in] Number of values in Frame.
+	 * @return true if the frame was decoded.
+	 */
+	static bool Decompress( const unsigned char * Compressed, int CompressedSize, unsigned short int * Frame, int NumberOfPixels );
+
+	/** @brief Compress all frames of a raw depth file to a data file and its index (see IndexedFrameFile).
+	 *         Frames are in the same order, so the timestamp file of the raw file remains valid.
+	 *
+	 * @param RawFile [in] Raw depth file.
+	 * @param NumberOfPixels [in] Number of pixels of each frame (2 bytes per pixel).
+	 * @param RvlFile [in] Compressed data file to write.
+	 * @param IndexFile [in] Index file to write.
+	 * @return true if the files were written.
+	 */
+	static bool ConvertRawFile( const std::string& RawFile, int NumberOfPixels, const std::string& RvlFile, const std::string& IndexFile );
+
+	/** @brief Decode a compressed frame and give each pixel to a sink. The sink must have two methods:
+	 *         Zeros(int Count) for a run of Count zeros and Value(unsigned short int Value) for a non zero pixel.
+	 *
+	 * @param Compressed [in] Compressed frame.
+	 * @param CompressedSize [in] Size of the compressed frame.
+	 * @param NumberOfPixels [in] Number of pixels of the frame.
+	 * @param Sink [in] Receiver of pixels.
+	 * @return true if the frame was decoded, false if the data are corrupted (the sink may have received some pixels).
+	 */
+	template<class PixelSink>
+	static bool Decode( const unsigned char * Compressed, int CompressedSize, int NumberOfPixels, PixelSink& Sink )
+	{
+		NibbleReader Reader( Compressed, CompressedSize );
+
+		int Remaining = NumberOfPixels;
+		int Previous = 0;
+		while( Remaining > 0 )
+		{
+			int Zeros = Reader.DecodeVLE();
+			int NonZeros = Reader.DecodeVLE();
+			if ( Reader.Error || Zeros + NonZeros == 0 || Zeros > Remaining || NonZeros > Remaining - Zeros )
+			{
+				return false;
+			}
+
+			Sink.Zeros( Zeros );
+			for( int i = 0; i < NonZeros; i++ )
+			{
+				int Positive = Reader.DecodeVLE();
+				int Current = Previous + ((Positive >> 1) ^ -(Positive & 1));
+				Sink.Value( (unsigned short int)Current );
+				Previous = Current;
+			}
+
+			if ( Reader.Error )
+			{
+				return false;
+			}
+
+			Remaining -= Zeros + NonZeros;
+		}
+
+		return true;
+	}
+
+protected:
+	/**
+	 * @struct NibbleReader
+	 * @brief Read variable length numbers from 32 bits words.
+	 */
+	struct NibbleReader
+	{
+		/** @brief constructor.
+		 */
+		NibbleReader( const unsigned char * _Pos, int Size )
+		{
+			Pos = _Pos;
+			End = _Pos + (Size & ~3);
+			Word = 0;
+			NibblesLeft = 0;
+			Error = false;
+		}
+
+		/** @brief Read a variable length number.
+		 */
+		int DecodeVLE()
+		{
+			unsigned int Nibble;
+			int Value = 0;
+			int Bits = 29;
+			do
+			{
+				if ( NibblesLeft == 0 )
+				{
+					if ( Pos >= End )
+					{
+						// End of data: corrupted frame
+						Error = true;
+						return 0;
+					}
+					memcpy( &Word, Pos, sizeof(Word) );
+					Pos += sizeof(Word);
+					NibblesLeft = 8;
+				}
+				Nibble = Word & 0xf0000000;
+				Value |= (Nibble << 1) >> Bits;
+				Word <<= 4;
+				NibblesLeft--;
+				Bits -= 3;
+			}
+			while( (Nibble & 0x80000000) && Bits >= 0 );
+
+			if ( Nibble & 0x80000000 )
+			{
+				// Number too large: corrupted frame
+				Error = true;
+				return 0;
+			}
+
+			return Value;
+		}
+
+		const unsigned char * Pos;		/*!< @brief Next word */
+		const unsigned char * End;		/*!< @brief End of data */
+		unsigned int Word;				/*!< @brief Current word */
+		int NibblesLeft;				/*!< @brief Number of nibbles left in Word */
+		bool Error;						/*!< @brief Was there a decoding error? */
+	};
+
+	/**
+	 * @struct DepthSink
+	 * @brief Sink writing depth values (see Decode).
+	 */
+	struct DepthSink
+	{
+		/** @brief Write a run of zeros.
+		 */
+		void Zeros( int Count )
+		{
+			memset( Pos, 0, Count*sizeof(unsigned short int) );
+			Pos += Count;
+		}
+
+		/** @brief Write a non zero value.
+		 */
+		void Value( unsigned short int Value )
+		{
+			*Pos++ = Value;
+		}
+
+		unsigned short int * Pos;		/*!< @brief Next depth value */
+	};
+};
+
+} // namespace MobileRGBD
+
+#endif // __RVL_CODEC_H__
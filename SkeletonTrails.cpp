@@ -0,0 +1,260 @@
+/**
+ * @file SkeletonTrails.cpp
+ * @ingroup Drawing
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#include "SkeletonTrails.h"
+
+#if defined WIN32 || defined WIN64
+	#define fseek64 _fseeki64
+#else
+	#define fseek64 fseeko
+#endif
+
+using namespace MobileRGBD;
+
+namespace {
+
+// Trail colors (BGR) of bodies, by tracking id
+const unsigned char TrailColors[6][3] = { { 0, 0, 255 }, { 0, 255, 0 }, { 255, 0, 0 }, { 0, 255, 255 }, { 255, 0, 255 }, { 255, 255, 0 } };
+
+} // anonymous namespace
+
+/** @brief constructor.
+ *
+ * @param _Index [in] Presence index of the skeleton stream. Must live longer than this object.
+ * @param RawFile [in] Raw file of the skeleton stream.
+ * @param _FrameSize [in] Size of a body sub-frame.
+ */
+SkeletonTrails::SkeletonTrails( const PresenceIndex& _Index, const std::string& RawFile, int _FrameSize )
+	: Index( _Index )
+{
+	Raw = fopen( RawFile.c_str(), "rb" );
+	FrameSize = _FrameSize;
+	PastMilliseconds = 2000;
+	FutureMilliseconds = 0;
+	WindowInDepth = true;
+	CurrentMilliseconds = 0;
+	ReadSubFrames = 0;
+}
+
+/** @brief Virtual destructor, always.
+ */
+SkeletonTrails::~SkeletonTrails()
+{
+	if ( Raw != nullptr )
+	{
+		fclose( Raw );
+	}
+}
+
+/** @brief Set the joints to follow.
+ *
+ * @param _Joints [in] Joints (Kinect joint types).
+ * @param _Extractor [in] Function giving the position of a joint in a body sub-frame.
+ */
+void SkeletonTrails::SetJoints( const std::vector<int>& _Joints, JointExtractor _Extractor )
+{
+	Joints = _Joints;
+	Extractor = _Extractor;
+	Window.clear();
+}
+
+/** @brief Set the time window of trails.
+ *
+ * @param PastSeconds [in] Duration before the current timestamp.
+ * @param FutureSeconds [in] Duration after the current timestamp.
+ */
+void SkeletonTrails::SetWindow( float PastSeconds, float FutureSeconds )
+{
+	PastMilliseconds = PastSeconds <= 0.0f ? 0 : (long long)(PastSeconds*1000.0f);
+	FutureMilliseconds = FutureSeconds <= 0.0f ? 0 : (long long)(FutureSeconds*1000.0f);
+}
+
+/** @brief Read all sub-frames of a range of entries in one sequential read.
+ *
+ * @param FirstEntry [in] First entry.
+ * @param LastEntry [in] Last entry (included).
+ * @param Buffer [out] Sub-frames of the entries, in order.
+ * @return false on read error.
+ */
+bool SkeletonTrails::ReadRange( int FirstEntry, int LastEntry, std::vector<unsigned char>& Buffer )
+{
+	Buffer.clear();
+
+	if ( Raw == nullptr )
+	{
+		return false;
+	}
+
+	long long FirstSubFrame = Index.GetFirstSubFrame( FirstEntry );
+	long long NumberOfSubFrames = Index.GetFirstSubFrame( LastEntry+1 ) - FirstSubFrame;
+	if ( NumberOfSubFrames <= 0 )
+	{
+		// Nobody in the range
+		return true;
+	}
+
+	Buffer.resize( (size_t)(NumberOfSubFrames*FrameSize) );
+	if ( fseek64( Raw, FirstSubFrame*FrameSize, SEEK_SET ) != 0 || fread( &Buffer[0], Buffer.size(), 1, Raw ) != 1 )
+	{
+		Buffer.clear();
+		return false;
+	}
+
+	ReadSubFrames += NumberOfSubFrames;
+
+	return true;
+}
+
+/** @brief Read entries and add them at the front or the back of the window.
+ *
+ * @return false on read error.
+ */
+bool SkeletonTrails::LoadEntries( int FirstEntry, int LastEntry, bool AtFront )
+{
+	if ( ReadRange( FirstEntry, LastEntry, ReadBuffer ) == false )
+	{
+		return false;
+	}
+
+	std::vector<TrailEntry> NewEntries( LastEntry-FirstEntry+1 );
+	const unsigned char * Body = ReadBuffer.empty() ? nullptr : &ReadBuffer[0];
+	for( int Entry = FirstEntry; Entry <= LastEntry; Entry++ )
+	{
+		TrailEntry& Current = NewEntries[Entry-FirstEntry];
+		Current.Entry = Entry;
+		Current.Milliseconds = Index.GetMilliseconds( Entry );
+
+		int NumberOfBodies = Index.GetCount( Entry );
+		for( int b = 0; b < NumberOfBodies; b++, Body += FrameSize )
+		{
+			for( size_t j = 0; j < Joints.size(); j++ )
+			{
+				TrailSample Sample;
+				Sample.Joint = Joints[j];
+				if ( Extractor( Body, Joints[j], WindowInDepth, Sample.Position, Sample.BodyId ) )
+				{
+					Current.Samples.push_back( Sample );
+				}
+			}
+		}
+	}
+
+	if ( AtFront )
+	{
+		Window.insert( Window.begin(), NewEntries.begin(), NewEntries.end() );
+	}
+	else
+	{
+		Window.insert( Window.end(), NewEntries.begin(), NewEntries.end() );
+	}
+
+	return true;
+}
+
+/** @brief Move the window to a timestamp, reading only entries entering the window.
+ *
+ * @param RequestMilliseconds [in] Current timestamp in milliseconds since epoch.
+ * @param InDepth [in] Positions in depth frame or video frame coordinates.
+ * @return false if the raw file can not be read.
+ */
+bool SkeletonTrails::Update( long long RequestMilliseconds, bool InDepth )
+{
+	CurrentMilliseconds = RequestMilliseconds;
+
+	if ( Raw == nullptr || Joints.empty() || !Extractor )
+	{
+		Window.clear();
+		return Raw != nullptr;
+	}
+
+	if ( InDepth != WindowInDepth )
+	{
+		// Positions of another frame
+		Window.clear();
+		WindowInDepth = InDepth;
+	}
+
+	// Entries in [RequestMilliseconds-PastMilliseconds, RequestMilliseconds+FutureMilliseconds]
+	int FirstEntry = Index.SearchPrevious( RequestMilliseconds - PastMilliseconds - 1 ) + 1;
+	int LastEntry = Index.SearchPrevious( RequestMilliseconds + FutureMilliseconds );
+	if ( LastEntry < FirstEntry )
+	{
+		Window.clear();
+		return true;
+	}
+
+	if ( Window.empty() || Window.back().Entry < FirstEntry || Window.front().Entry > LastEntry )
+	{
+		// Seek, no common entry
+		Window.clear();
+		return LoadEntries( FirstEntry, LastEntry, false );
+	}
+
+	// Slide: drop entries leaving the window, read entries entering it
+	while( Window.front().Entry < FirstEntry )
+	{
+		Window.pop_front();
+	}
+	while( Window.back().Entry > LastEntry )
+	{
+		Window.pop_back();
+	}
+
+	bool Ret = true;
+	if ( Window.front().Entry > FirstEntry )
+	{
+		Ret = LoadEntries( FirstEntry, Window.front().Entry-1, true ) && Ret;
+	}
+	if ( Window.back().Entry < LastEntry )
+	{
+		Ret = LoadEntries( Window.back().Entry+1, LastEntry, false ) && Ret;
+	}
+
+	return Ret;
+}
+
+/** @brief Draw trails of the current window. Past is drawn thicker than future and fades with time.
+ *
+ * @param WhereToDraw [in] Drawing cv::Mat.
+ * @param ScaleX [in] Horizontal scale from joint coordinates to WhereToDraw.
+ * @param ScaleY [in] Vertical scale from joint coordinates to WhereToDraw.
+ */
+void SkeletonTrails::Draw( cv::Mat& WhereToDraw, float ScaleX, float ScaleY ) const
+{
+	const long long Span = PastMilliseconds > FutureMilliseconds ? PastMilliseconds : FutureMilliseconds;
+
+	for( size_t e = 1; e < Window.size(); e++ )
+	{
+		const TrailEntry& Before = Window[e-1];
+		const TrailEntry& After = Window[e];
+
+		long long Age = CurrentMilliseconds - After.Milliseconds;
+		bool Past = Age >= 0;
+		float Intensity = Span <= 0 ? 1.0f : 1.0f - 0.75f*(float)(Past ? Age : -Age)/(float)Span;
+
+		for( size_t s = 0; s < After.Samples.size(); s++ )
+		{
+			const TrailSample& To = After.Samples[s];
+
+			// Same joint of the same body in the previous entry
+			for( size_t p = 0; p < Before.Samples.size(); p++ )
+			{
+				const TrailSample& From = Before.Samples[p];
+				if ( From.BodyId != To.BodyId || From.Joint != To.Joint )
+				{
+					continue;
+				}
+
+				const unsigned char * Color = TrailColors[To.BodyId%6];
+				cv::line( WhereToDraw, cv::Point( (int)(From.Position.x*ScaleX), (int)(From.Position.y*ScaleY) ),
+					cv::Point( (int)(To.Position.x*ScaleX), (int)(To.Position.y*ScaleY) ),
+					cv::Scalar( Color[0]*Intensity, Color[1]*Intensity, Color[2]*Intensity ), Past ? 2 : 1 );
+				break;
+			}
+		}
+	}
+}
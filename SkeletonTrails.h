@@ -0,0 +1,147 @@
+/**
+ * @file SkeletonTrails.h
+ * @ingroup Drawing
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __SKELETON_TRAILS_H__
+#define __SKELETON_TRAILS_H__
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <functional>
+
+#include "Drawable.h"
+#include "PresenceIndex.h"
+
+namespace MobileRGBD {
+
+/**
+ * @class SkeletonTrails SkeletonTrails.cpp SkeletonTrails.h
+ * @brief Trajectories of selected joints of bodies over a time window around the current timestamp.
+ *        Body sub-frames of a range of entries are read from the raw file in one sequential read (see
+ *        ReadRange, positions come from a PresenceIndex). Joint positions of the window are kept: when
+ *        playback advances, only entries entering the window are read and entries leaving it are dropped,
+ *        so the cost per drawn frame does not depend on the length of the window.
+ *        Joint positions are extracted from body sub-frames by a function given by the user, as the
+ *        body layout belongs to the Kinect module.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class SkeletonTrails
+{
+public:
+	/** @brief Get the position of a joint in a body sub-frame, in depth or video frame coordinates.
+	 *         Returns false if the body or the joint is not tracked.
+	 */
+	typedef std::function<bool(const unsigned char * Body, int Joint, bool InDepth, cv::Point2f& Position, unsigned long long& BodyId)> JointExtractor;
+
+	/** @brief constructor.
+	 *
+	 * @param _Index [in] Presence index of the skeleton stream. Must live longer than this object.
+	 * @param RawFile [in] Raw file of the skeleton stream.
+	 * @param _FrameSize [in] Size of a body sub-frame.
+	 */
+	SkeletonTrails( const PresenceIndex& _Index, const std::string& RawFile, int _FrameSize );
+
+	/** @brief Virtual destructor, always.
+	 */
+	virtual ~SkeletonTrails();
+
+	/** @brief Set the joints to follow.
+	 *
+	 * @param _Joints [in] Joints (Kinect joint types).
+	 * @param _Extractor [in] Function giving the position of a joint in a body sub-frame.
+	 */
+	void SetJoints( const std::vector<int>& _Joints, JointExtractor _Extractor );
+
+	/** @brief Set the time window of trails.
+	 *
+	 * @param PastSeconds [in] Duration before the current timestamp.
+	 * @param FutureSeconds [in] Duration after the current timestamp.
+	 */
+	void SetWindow( float PastSeconds, float FutureSeconds );
+
+	/** @brief Move the window to a timestamp, reading only entries entering the window.
+	 *
+	 * @param RequestMilliseconds [in] Current timestamp in milliseconds since epoch.
+	 * @param InDepth [in] Positions in depth frame or video frame coordinates.
+	 * @return false if the raw file can not be read.
+	 */
+	bool Update( long long RequestMilliseconds, bool InDepth );
+
+	/** @brief Draw trails of the current window. Past is drawn thicker than future and fades with time.
+	 *
+	 * @param WhereToDraw [in] Drawing cv::Mat.
+	 * @param ScaleX [in] Horizontal scale from joint coordinates to WhereToDraw.
+	 * @param ScaleY [in] Vertical scale from joint coordinates to WhereToDraw.
+	 */
+	void Draw( cv::Mat& WhereToDraw, float ScaleX, float ScaleY ) const;
+
+	/** @brief Read all sub-frames of a range of entries in one sequential read.
+	 *
+	 * @param FirstEntry [in] First entry.
+	 * @param LastEntry [in] Last entry (included).
+	 * @param Buffer [out] Sub-frames of the entries, in order.
+	 * @return false on read error.
+	 */
+	bool ReadRange( int FirstEntry, int LastEntry, std::vector<unsigned char>& Buffer );
+
+	/** @brief Get the number of sub-frames read since construction.
+	 */
+	long long GetNumberOfReadSubFrames() const
+	{
+		return ReadSubFrames;
+	}
+
+protected:
+	/**
+	 * @struct TrailSample
+	 * @brief Position of a joint of a body.
+	 */
+	struct TrailSample
+	{
+		unsigned long long BodyId;		/*!< @brief Tracking id of the body */
+		int Joint;						/*!< @brief Joint */
+		cv::Point2f Position;			/*!< @brief Position in depth or video frame coordinates */
+	};
+
+	/**
+	 * @struct TrailEntry
+	 * @brief Joint positions of an entry of the stream.
+	 */
+	struct TrailEntry
+	{
+		int Entry;							/*!< @brief Entry in the index */
+		long long Milliseconds;				/*!< @brief Timestamp of the entry */
+		std::vector<TrailSample> Samples;	/*!< @brief Positions of followed joints */
+	};
+
+	/** @brief Read entries and add them at the front or the back of the window.
+	 *
+	 * @return false on read error.
+	 */
+	bool LoadEntries( int FirstEntry, int LastEntry, bool AtFront );
+
+	const PresenceIndex& Index;				/*!< @brief Presence index of the stream */
+	FILE * Raw;								/*!< @brief Raw file, nullptr if not available */
+	int FrameSize;							/*!< @brief Size of a body sub-frame */
+
+	std::vector<int> Joints;				/*!< @brief Followed joints */
+	JointExtractor Extractor;				/*!< @brief Position of a joint in a body sub-frame */
+	long long PastMilliseconds;				/*!< @brief Duration of the window before the current timestamp */
+	long long FutureMilliseconds;			/*!< @brief Duration of the window after the current timestamp */
+
+	std::deque<TrailEntry> Window;			/*!< @brief Entries of the window, in order, without gap */
+	bool WindowInDepth;						/*!< @brief Coordinates of positions in Window */
+	long long CurrentMilliseconds;			/*!< @brief Current timestamp */
+	std::vector<unsigned char> ReadBuffer;	/*!< @brief Sub-frames of the last read range */
+	long long ReadSubFrames;				/*!< @brief Number of sub-frames read */
+};
+
+} // namespace MobileRGBD
+
+#endif // __SKELETON_TRAILS_H__
@@ -0,0 +1,141 @@
+/**
+ * @file StreamSynchronizer.cpp
+ * @ingroup Drawing
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#include "StreamSynchronizer.h"
+
+#include <stdlib.h>
+
+using namespace MobileRGBD;
+
+/** @brief Add a stream. The first stream is the reference stream.
+ *
+ * @param TimestampFile [in] Timestamp file of the stream.
+ * @return the id of the stream (index in SyncTuple::Entries), -1 if the file can not be read.
+ */
+int StreamSynchronizer::AddStream( const std::string& TimestampFile )
+{
+	Streams.push_back( TimestampIndex() );
+	if ( Streams.back().Load( TimestampFile ) == false )
+	{
+		Streams.pop_back();
+		return -1;
+	}
+
+	return (int)Streams.size()-1;
+}
+
+/** @brief Merge-join all streams, call OnTuple for each entry of the reference stream.
+ *         The same tuple object is reused for all calls.
+ *
+ * @param OnTuple [in] Callback receiving tuples.
+ * @param FirstEntry [in] First entry of the reference stream (Default = 0).
+ * @param Step [in] Use one reference entry every Step entries (Default = 1).
+ * @return the number of tuples given to OnTuple.
+ */
+int StreamSynchronizer::Run( const TupleCallback& OnTuple, int FirstEntry /* = 0 */, int Step /* = 1 */ ) const
+{
+	if ( Streams.empty() )
+	{
+		return 0;
+	}
+
+	const TimestampIndex& Reference = Streams[0];
+	const int NumberOfStreams = (int)Streams.size();
+
+	if ( Step <= 0 )
+	{
+		Step = 1;
+	}
+	if ( FirstEntry < 0 )
+	{
+		FirstEntry = 0;
+	}
+
+	// Last entry of each stream not after the current reference timestamp
+	std::vector<int> Previous( NumberOfStreams, -1 );
+
+	SyncTuple Tuple;
+	Tuple.Entries.resize( NumberOfStreams );
+
+	int NumberOfTuples = 0;
+	for( int Entry = FirstEntry; Entry < Reference.GetNumberOfEntries(); Entry += Step )
+	{
+		long long RequestMilliseconds = Reference.GetMilliseconds( Entry );
+
+		Tuple.ReferenceEntry = Entry;
+		Tuple.ReferenceTimestamp = Reference.GetTimestamp( Entry );
+		Tuple.Entries[0] = Entry;
+		Tuple.Complete = true;
+
+		for( int s = 1; s < NumberOfStreams; s++ )
+		{
+			const TimestampIndex& Stream = Streams[s];
+
+			// Reference timestamps increase, streams only go forward
+			int& Position = Previous[s];
+			while( Position+1 < Stream.GetNumberOfEntries() && Stream.GetMilliseconds(Position+1) <= RequestMilliseconds )
+			{
+				Position++;
+			}
+
+			int Match;
+			switch( Policy )
+			{
+				case PreviousOnly:
+					Match = Position;
+					break;
+
+				case WithinTolerance:
+					Match = Stream.NearestFromPrevious( Position, RequestMilliseconds );
+					if ( Match >= 0 && llabs( Stream.GetMilliseconds(Match) - RequestMilliseconds ) > ToleranceMilliseconds )
+					{
+						Match = -1;
+					}
+					break;
+
+				default:
+					Match = Stream.NearestFromPrevious( Position, RequestMilliseconds );
+					break;
+			}
+
+			Tuple.Entries[s] = Match;
+			if ( Match < 0 )
+			{
+				Tuple.Complete = false;
+			}
+		}
+
+		if ( SkipIncomplete && Tuple.Complete == false )
+		{
+			continue;
+		}
+
+		NumberOfTuples++;
+		if ( OnTuple( Tuple ) == false )
+		{
+			break;
+		}
+	}
+
+	return NumberOfTuples;
+}
+
+/** @brief Merge-join all streams and keep all tuples.
+ *
+ * @param Tuples [out] Tuples in reference order.
+ * @return the number of tuples.
+ */
+int StreamSynchronizer::Synchronize( std::vector<SyncTuple>& Tuples ) const
+{
+	Tuples.clear();
+
+	return Run( [&Tuples]( const SyncTuple& Tuple ) -> bool
+	{
+		Tuples.push_back( Tuple );
+		return true;
+	} );
+}
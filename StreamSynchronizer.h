@@ -0,0 +1,148 @@
+/**
+ * @file StreamSynchronizer.h
+ * @ingroup Drawing
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __STREAM_SYNCHRONIZER_H__
+#define __STREAM_SYNCHRONIZER_H__
+
+#include <string>
+#include <vector>
+#include <functional>
+
+#include "TimestampIndex.h"
+#include "DrawTimestampData.h"
+#include "DrawTimestampRawData.h"
+
+namespace MobileRGBD {
+
+/**
+ * @struct SyncTuple
+ * @brief Entries of all streams aligned on one entry of the reference stream (stream 0).
+ */
+struct SyncTuple
+{
+	int ReferenceEntry;				/*!< @brief Entry of the reference stream */
+	TimeB ReferenceTimestamp;		/*!< @brief Timestamp of the reference entry */
+	std::vector<int> Entries;		/*!< @brief Matching entry of each stream (Entries[0] = ReferenceEntry), -1 if none */
+	bool Complete;					/*!< @brief Do all streams have a matching entry? */
+};
+
+/**
+ * @class StreamSynchronizer StreamSynchronizer.cpp StreamSynchronizer.h
+ * @brief Align the frames of several streams on the frames of a reference stream (the first added one).
+ *        Timestamp files are loaded once and merge-joined in one linear pass: each stream keeps its
+ *        position while the reference timestamps increase, no search is done per output frame.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class StreamSynchronizer
+{
+public:
+	/** @enum StreamSynchronizer::MatchingPolicy
+	 *  @brief How an entry of a stream is chosen for a reference timestamp: nearest entry, last entry
+	 *         not after the reference timestamp, or nearest entry if it is within the tolerance.
+	 */
+	enum MatchingPolicy { Nearest = 0, PreviousOnly = 1, WithinTolerance = 2 };
+
+	/** @brief Callback receiving aligned tuples in reference order. Return false to stop.
+	 */
+	typedef std::function<bool(const SyncTuple& Tuple)> TupleCallback;
+
+	/** @brief constructor. No stream.
+	 *
+	 * @param _Policy [in] Matching policy (Default = Nearest).
+	 * @param _ToleranceMilliseconds [in] Maximum distance of a match with the WithinTolerance policy (Default = 50).
+	 */
+	StreamSynchronizer( MatchingPolicy _Policy = Nearest, long long _ToleranceMilliseconds = 50 )
+	{
+		Policy = _Policy;
+		ToleranceMilliseconds = _ToleranceMilliseconds;
+		SkipIncomplete = false;
+	}
+
+	/** @brief Virtual destructor, always.
+	 */
+	virtual ~StreamSynchronizer() {}
+
+	/** @brief Add a stream. The first stream is the reference stream.
+	 *
+	 * @param TimestampFile [in] Timestamp file of the stream.
+	 * @return the id of the stream (index in SyncTuple::Entries), -1 if the file can not be read.
+	 */
+	int AddStream( const std::string& TimestampFile );
+
+	/** @brief Add a stream. The first stream is the reference stream.
+	 *
+	 * @param Stream [in] Stream without raw file (skeleton, face, laser, localization, ...).
+	 * @return the id of the stream (index in SyncTuple::Entries), -1 if its timestamp file can not be read.
+	 */
+	int AddStream( const DrawTimestampData& Stream )
+	{
+		return AddStream( Stream.GetTimestampFileName() );
+	}
+
+	/** @brief Add a stream. The first stream is the reference stream.
+	 *
+	 * @param Stream [in] Stream with a raw file (video, depth, ...).
+	 * @return the id of the stream (index in SyncTuple::Entries), -1 if its timestamp file can not be read.
+	 */
+	int AddStream( const DrawTimestampRawData& Stream )
+	{
+		return AddStream( Stream.GetTimestampFileName() );
+	}
+
+	/** @brief Get the number of streams.
+	 */
+	int GetNumberOfStreams() const
+	{
+		return (int)Streams.size();
+	}
+
+	/** @brief Get the timestamp index of a stream, to get timestamps of matched entries.
+	 *
+	 * @param Stream [in] Id of the stream.
+	 */
+	const TimestampIndex& GetIndex( int Stream ) const
+	{
+		return Streams[Stream];
+	}
+
+	/** @brief Set if tuples where a stream has no matching entry are skipped (Default = false).
+	 *
+	 * @param Value [in] Skip incomplete tuples or not.
+	 */
+	void SetSkipIncomplete( bool Value )
+	{
+		SkipIncomplete = Value;
+	}
+
+	/** @brief Merge-join all streams, call OnTuple for each entry of the reference stream.
+	 *         The same tuple object is reused for all calls.
+	 *
+	 * @param OnTuple [in] Callback receiving tuples.
+	 * @param FirstEntry [in] First entry of the reference stream (Default = 0).
+	 * @param Step [in] Use one reference entry every Step entries (Default = 1).
+	 * @return the number of tuples given to OnTuple.
+	 */
+	int Run( const TupleCallback& OnTuple, int FirstEntry = 0, int Step = 1 ) const;
+
+	/** @brief Merge-join all streams and keep all tuples.
+	 *
+	 * @param Tuples [out] Tuples in reference order.
+	 * @return the number of tuples.
+	 */
+	int Synchronize( std::vector<SyncTuple>& Tuples ) const;
+
+protected:
+	std::vector<TimestampIndex> Streams;	/*!< @brief Timestamps of each stream, reference first */
+	MatchingPolicy Policy;					/*!< @brief How entries are matched */
+	long long ToleranceMilliseconds;		/*!< @brief Maximum distance of a match (WithinTolerance) */
+	bool SkipIncomplete;					/*!< @brief Skip tuples where a stream has no match */
+};
+
+} // namespace MobileRGBD
+
+#endif // __STREAM_SYNCHRONIZER_H__
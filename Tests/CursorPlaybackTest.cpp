@@ -0,0 +1,286 @@
+/**
+ * @file CursorPlaybackTest.cpp
+ * @ingroup Drawing
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ *
+ * Check that drawing through a cursor (see CursorReader) lands on the same frames as the Process
+ * function of DataManagement. Writes a text stream, a single frame raw stream and a sub-frames raw
+ * stream, plays them sequentially with backward jumps and seeks, in reverse and scrubbing back and forth,
+ * cursor on and cursor off, and compares the line data, frames and number of sub-frames given to
+ * ProcessElement for each request. Views using the cursor must never call Process, i.e.:
+ *   g++ -std=c++11 -DKINECT_2 Tests/CursorPlaybackTest.cpp CursorReader.cpp TimestampIndex.cpp PresenceIndex.cpp
+ *       DrawTimestampData.cpp DrawTimestampRawData.cpp Drawable.cpp -lDataManagement -lopencv_core -o CursorPlaybackTest
+ * Returns 0 on success.
+ */
+
+#include "../DrawTimestampData.h"
+#include "../DrawTimestampRawData.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+using namespace MobileRGBD;
+
+namespace {
+
+const int NumberOfEntries = 500;			// Entries in each stream
+const int TestFrameSize = 64;					// Size of test (sub-)frames
+const long long FirstMilliseconds = 1450000000000LL;	// Timestamp of first entry
+
+/**
+ * @struct DrawnElement
+ * @brief What ProcessElement received for a request.
+ */
+struct DrawnElement
+{
+	int DataValue;			/*!< @brief First number of the line data */
+	int FrameValue;			/*!< @brief First value of the (first sub-)frame, -1 if none */
+	int SubFrames;			/*!< @brief Number of sub-frames, -1 for single frame streams */
+
+	bool operator==( const DrawnElement& Other ) const
+	{
+		return DataValue == Other.DataValue && FrameValue == Other.FrameValue && SubFrames == Other.SubFrames;
+	}
+};
+
+/**
+ * @class TestData
+ * @brief Text stream recording what it draws.
+ */
+class TestData : public DrawTimestampData
+{
+public:
+	TestData( const std::string& TimestampFile ) : DrawTimestampData( TimestampFile ), NumberOfSearches( 0 ) {}
+
+	// Searches of DataManagement, must not be done through the cursor
+	virtual bool Process( const TimeB &RequestTimestamp, void * UserData = nullptr ) override
+	{
+		NumberOfSearches++;
+		return DrawTimestampData::Process( RequestTimestamp, UserData );
+	}
+
+	virtual bool ProcessElement( const TimeB &RequestTimestamp, void * UserData = nullptr )
+	{
+		DrawnElement Drawn = { -1, -1, -1 };
+		sscanf( DataBuffer, "%d", &Drawn.DataValue );
+		Elements.push_back( Drawn );
+		return true;
+	}
+
+	std::vector<DrawnElement> Elements;		/*!< @brief Drawn elements, in order */
+	int NumberOfSearches;					/*!< @brief Number of calls to Process */
+};
+
+/**
+ * @class TestRawData
+ * @brief Raw stream recording what it draws.
+ */
+class TestRawData : public DrawTimestampRawData
+{
+public:
+	TestRawData( const std::string& TimestampFile, const std::string& RawFile, bool SubFrames )
+		: DrawTimestampRawData( TimestampFile, RawFile, TestFrameSize ), NumberOfSearches( 0 )
+	{
+		Mode = SubFrames ? SubFramesMode : SingleFrameMode;
+		StartingFrame = 0;
+	}
+
+	// Searches of DataManagement, must not be done through the cursor
+	virtual bool Process( const TimeB &RequestTimestamp, void * UserData = nullptr ) override
+	{
+		NumberOfSearches++;
+		return DrawTimestampRawData::Process( RequestTimestamp, UserData );
+	}
+
+	virtual bool ProcessElement( const TimeB &RequestTimestamp, void * UserData = nullptr )
+	{
+		DrawnElement Drawn = { -1, -1, -1 };
+		sscanf( DataBuffer, "%d", &Drawn.DataValue );
+		if ( Mode == SubFramesMode )
+		{
+			Drawn.SubFrames = NumberOfSubFrames;
+		}
+		if ( Mode == SingleFrameMode || NumberOfSubFrames > 0 )
+		{
+			Drawn.FrameValue = *(const int*)FrameBuffer;
+		}
+		Elements.push_back( Drawn );
+		return true;
+	}
+
+	std::vector<DrawnElement> Elements;		/*!< @brief Drawn elements, in order */
+	int NumberOfSearches;					/*!< @brief Number of calls to Process */
+};
+
+/** @brief Number of sub-frames of an entry in the sub-frames stream.
+ */
+int GetCount( int Entry )
+{
+	return (Entry/7)%4;
+}
+
+/** @brief Write the test streams: entry i has i as line data, frames contain i*10 + sub-frame.
+ *
+ * @return true if the files were written.
+ */
+bool WriteStreams( const std::string& TimestampFile, const std::string& SubFramesTimestampFile,
+	const std::string& RawFile, const std::string& SubFramesRawFile )
+{
+	FILE * Timestamps = fopen( TimestampFile.c_str(), "wb" );
+	FILE * SubFramesTimestamps = fopen( SubFramesTimestampFile.c_str(), "wb" );
+	FILE * Raw = fopen( RawFile.c_str(), "wb" );
+	FILE * SubFramesRaw = fopen( SubFramesRawFile.c_str(), "wb" );
+	bool Ret = Timestamps != nullptr && SubFramesTimestamps != nullptr && Raw != nullptr && SubFramesRaw != nullptr;
+
+	long long Milliseconds = FirstMilliseconds;
+	std::vector<int> Frame( TestFrameSize/sizeof(int) );
+	for( int Entry = 0; Ret && Entry < NumberOfEntries; Entry++ )
+	{
+		// Irregular intervals, with some long lines
+		Milliseconds += 25 + (Entry*37)%20;
+		std::string Padding( Entry%50 == 0 ? 5000 : 0, 'x' );
+		fprintf( Timestamps, "%lld %03d %d %s\r\n", Milliseconds/1000, (int)(Milliseconds%1000), Entry, Padding.c_str() );
+		fprintf( SubFramesTimestamps, "%lld %03d %d %d\r\n", Milliseconds/1000, (int)(Milliseconds%1000), Entry, GetCount(Entry) );
+
+		for( size_t i = 0; i < Frame.size(); i++ )
+		{
+			Frame[i] = Entry*10;
+		}
+		Ret = fwrite( &Frame[0], TestFrameSize, 1, Raw ) == 1;
+		for( int SubFrame = 0; Ret && SubFrame < GetCount(Entry); SubFrame++ )
+		{
+			Frame[0] = Entry*10 + SubFrame;
+			Ret = fwrite( &Frame[0], TestFrameSize, 1, SubFramesRaw ) == 1;
+		}
+	}
+
+	if ( Timestamps != nullptr ) fclose( Timestamps );
+	if ( SubFramesTimestamps != nullptr ) fclose( SubFramesTimestamps );
+	if ( Raw != nullptr ) fclose( Raw );
+	if ( SubFramesRaw != nullptr ) fclose( SubFramesRaw );
+
+	return Ret;
+}
+
+/** @brief Draw a list of requests with a view.
+ */
+void Play( Drawable& View, const std::vector<long long>& Requests )
+{
+	cv::Mat WhereToDraw;
+	for( size_t i = 0; i < Requests.size(); i++ )
+	{
+		View.Draw( WhereToDraw, TimestampIndex::MillisecondsToTimestamp( Requests[i] ) );
+	}
+}
+
+/** @brief Compare elements drawn with and without cursor.
+ *
+ * @return the number of errors.
+ */
+int Compare( const char * Name, const std::vector<DrawnElement>& WithCursor, const std::vector<DrawnElement>& WithoutCursor )
+{
+	int Errors = 0;
+	if ( WithCursor.size() != WithoutCursor.size() )
+	{
+		fprintf( stderr, "%s: %d elements drawn with cursor, %d without\n", Name, (int)WithCursor.size(), (int)WithoutCursor.size() );
+		Errors++;
+	}
+
+	for( size_t i = 0; i < WithCursor.size() && i < WithoutCursor.size(); i++ )
+	{
+		if ( (WithCursor[i] == WithoutCursor[i]) == false )
+		{
+			fprintf( stderr, "%s: request %d drew %d/%d/%d with cursor, %d/%d/%d without\n", Name, (int)i,
+				WithCursor[i].DataValue, WithCursor[i].FrameValue, WithCursor[i].SubFrames,
+				WithoutCursor[i].DataValue, WithoutCursor[i].FrameValue, WithoutCursor[i].SubFrames );
+			Errors++;
+		}
+	}
+
+	printf( "%s: %d elements drawn, %d errors\n", Name, (int)WithCursor.size(), Errors );
+
+	return Errors;
+}
+
+} // anonymous namespace
+
+int main()
+{
+	const std::string TimestampFile = "CursorPlaybackTest.timestamp";
+	const std::string SubFramesTimestampFile = "CursorPlaybackTestSubFrames.timestamp";
+	const std::string RawFile = "CursorPlaybackTest.raw";
+	const std::string SubFramesRawFile = "CursorPlaybackTestSubFrames.raw";
+
+	if ( WriteStreams( TimestampFile, SubFramesTimestampFile, RawFile, SubFramesRawFile ) == false )
+	{
+		fprintf( stderr, "Unable to write test streams\n" );
+		return 1;
+	}
+
+	// Playback at 30 fps from before the first entry to after the last one, with a backward jump
+	// and a forward seek, then playback at 2x speed
+	std::vector<long long> Requests;
+	long long Last = FirstMilliseconds + NumberOfEntries*45;
+	for( long long Request = FirstMilliseconds - 100; Request < Last + 100; Request += 33 )
+	{
+		Requests.push_back( Request );
+		if ( Requests.size() == 300 )
+		{
+			Request -= 2000;
+		}
+		if ( Requests.size() == 450 )
+		{
+			Request += 5000;
+		}
+	}
+	for( long long Request = FirstMilliseconds; Request < Last; Request += 66 )
+	{
+		Requests.push_back( Request );
+	}
+
+	// Reverse playback one frame back at a time, then scrubbing two frames back and one forward
+	for( long long Request = Last + 100; Request > FirstMilliseconds - 100; Request -= 33 )
+	{
+		Requests.push_back( Request );
+	}
+	for( long long Request = Last; Request > FirstMilliseconds; Request -= 33 )
+	{
+		Requests.push_back( Request );
+		Requests.push_back( Request - 66 );
+	}
+
+	TestData Data( TimestampFile ), DataWithoutCursor( TimestampFile );
+	TestRawData Raw( TimestampFile, RawFile, false ), RawWithoutCursor( TimestampFile, RawFile, false );
+	TestRawData SubFrames( SubFramesTimestampFile, SubFramesRawFile, true ), SubFramesWithoutCursor( SubFramesTimestampFile, SubFramesRawFile, true );
+	DataWithoutCursor.SetUseCursor( false );
+	RawWithoutCursor.SetUseCursor( false );
+	SubFramesWithoutCursor.SetUseCursor( false );
+
+	Play( Data, Requests );
+	Play( DataWithoutCursor, Requests );
+	Play( Raw, Requests );
+	Play( RawWithoutCursor, Requests );
+	Play( SubFrames, Requests );
+	Play( SubFramesWithoutCursor, Requests );
+
+	int Errors = 0;
+	if ( Data.GetUseCursor() == false || Raw.GetUseCursor() == false || SubFrames.GetUseCursor() == false ||
+		 Data.NumberOfSearches != 0 || Raw.NumberOfSearches != 0 || SubFrames.NumberOfSearches != 0 )
+	{
+		fprintf( stderr, "Cursor not used for all requests (%d, %d and %d searches)\n", Data.NumberOfSearches, Raw.NumberOfSearches, SubFrames.NumberOfSearches );
+		Errors++;
+	}
+	Errors += Compare( "Data", Data.Elements, DataWithoutCursor.Elements );
+	Errors += Compare( "Raw", Raw.Elements, RawWithoutCursor.Elements );
+	Errors += Compare( "SubFrames", SubFrames.Elements, SubFramesWithoutCursor.Elements );
+
+	remove( TimestampFile.c_str() );
+	remove( SubFramesTimestampFile.c_str() );
+	remove( RawFile.c_str() );
+	remove( SubFramesRawFile.c_str() );
+
+	return Errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,407 @@
+/**
+ * @file DrawAllocationTest.cpp
+ * @ingroup Drawing
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ *
+ * Check that steady-state drawing does not allocate memory. Global operator new/delete are replaced
+ * by counting versions and cv::Mat buffers are counted by a cv::MatAllocator installed as default
+ * allocator. Depth, infrared, body_index and laser views draw a synthetic recording: the first frame
+ * warms up each view (files opened, buffers sized), then allocations over the next frames must be zero.
+ * Views draw raw files in a depth frame, at native size (copy) and at another size (resize).
+ * Temporary buffers of OpenCV functions (resize, cvtColor, imdecode) are out of scope: operator new
+ * calls from OpenCV libraries are not counted. Any cv::Mat allocation is counted.
+ * Needs OpenCV 3 or later (cv::Mat::setDefaultAllocator). Build it with the Drawing sources and
+ * their libraries, i.e.:
+ *   g++ -std=c++11 -DKINECT_2 Tests/DrawAllocationTest.cpp *.cpp -lDataManagement -lOmiscid
+ *       -lopencv_core -lopencv_imgproc -lopencv_highgui -ldl -lpthread -o DrawAllocationTest
+ * Returns 0 on success.
+ */
+
+#include "../DrawDepthView.h"
+#include "../DrawInfraredView.h"
+#include "../DrawBodyIndexView.h"
+#include "../DrawLaser.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <new>
+#include <string>
+#include <vector>
+
+#if defined WIN32 || defined WIN64
+	#include <direct.h>
+	#define MakeFolder( Name ) _mkdir( Name )
+	#define RemoveFolder( Name ) _rmdir( Name )
+	#define CallerAddress() nullptr
+#else
+	#include <dlfcn.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+	#define MakeFolder( Name ) mkdir( Name, 0755 )
+	#define RemoveFolder( Name ) rmdir( Name )
+	#define CallerAddress() __builtin_return_address(0)
+#endif
+
+namespace {
+
+std::atomic<bool> CountAllocations( false );		// Count allocations or not
+std::atomic<long long> NumberOfAllocations( 0 );	// Counted operator new calls
+std::atomic<long long> NumberOfMatAllocations( 0 );	// Counted cv::Mat buffers
+
+/** @brief Is operator new called from an OpenCV library?
+ *
+ * @param Caller [in] Return address of operator new, nullptr if unknown.
+ */
+bool IsOpenCVCaller( void * Caller )
+{
+#if defined WIN32 || defined WIN64
+	return false;
+#else
+	Dl_info Info;
+	return Caller != nullptr && dladdr( Caller, &Info ) != 0 && Info.dli_fname != nullptr && strstr( Info.dli_fname, "opencv" ) != nullptr;
+#endif
+}
+
+/** @brief Allocate memory, counting the allocation if needed.
+ *
+ * @param Size [in] Size of the allocation.
+ * @param Caller [in] Return address of operator new.
+ * @return the memory, nullptr on failure.
+ */
+void * CountedAllocation( size_t Size, void * Caller )
+{
+	if ( CountAllocations.load() && IsOpenCVCaller( Caller ) == false )
+	{
+		NumberOfAllocations++;
+	}
+
+	return malloc( Size == 0 ? 1 : Size );
+}
+
+} // anonymous namespace
+
+void * operator new( size_t Size )
+{
+	void * Memory = CountedAllocation( Size, CallerAddress() );
+	if ( Memory == nullptr )
+	{
+		throw std::bad_alloc();
+	}
+	return Memory;
+}
+
+void * operator new[]( size_t Size )
+{
+	void * Memory = CountedAllocation( Size, CallerAddress() );
+	if ( Memory == nullptr )
+	{
+		throw std::bad_alloc();
+	}
+	return Memory;
+}
+
+void * operator new( size_t Size, const std::nothrow_t& ) noexcept
+{
+	return CountedAllocation( Size, CallerAddress() );
+}
+
+void * operator new[]( size_t Size, const std::nothrow_t& ) noexcept
+{
+	return CountedAllocation( Size, CallerAddress() );
+}
+
+void operator delete( void * Memory ) noexcept
+{
+	free( Memory );
+}
+
+void operator delete[]( void * Memory ) noexcept
+{
+	free( Memory );
+}
+
+void operator delete( void * Memory, const std::nothrow_t& ) noexcept
+{
+	free( Memory );
+}
+
+void operator delete[]( void * Memory, const std::nothrow_t& ) noexcept
+{
+	free( Memory );
+}
+
+#if CV_VERSION_MAJOR >= 4
+	typedef cv::AccessFlag MatAccessFlag;
+#else
+	typedef int MatAccessFlag;
+#endif
+
+namespace {
+
+/**
+ * @class CountingMatAllocator
+ * @brief Count allocations of cv::Mat buffers, done by the previous default allocator of OpenCV.
+ */
+class CountingMatAllocator : public cv::MatAllocator
+{
+public:
+	/** @brief constructor.
+	 *
+	 * @param _Allocator [in] Allocator doing allocations.
+	 */
+	CountingMatAllocator( cv::MatAllocator * _Allocator ) : Allocator( _Allocator ) {}
+
+	/** @brief Allocate a cv::Mat buffer (if data is not given by the caller).
+	 */
+	virtual cv::UMatData * allocate( int dims, const int * sizes, int type, void * data, size_t * step, MatAccessFlag flags, cv::UMatUsageFlags usageFlags ) const
+	{
+		if ( data == nullptr && CountAllocations.load() )
+		{
+			NumberOfMatAllocations++;
+		}
+		return Allocator->allocate( dims, sizes, type, data, step, flags, usageFlags );
+	}
+
+	/** @brief Allocate memory of existing data.
+	 */
+	virtual bool allocate( cv::UMatData * data, MatAccessFlag accessflags, cv::UMatUsageFlags usageFlags ) const
+	{
+		return Allocator->allocate( data, accessflags, usageFlags );
+	}
+
+	/** @brief Free a buffer.
+	 */
+	virtual void deallocate( cv::UMatData * data ) const
+	{
+		Allocator->deallocate( data );
+	}
+
+protected:
+	cv::MatAllocator * Allocator;		/*!< @brief Allocator doing allocations */
+};
+
+} // anonymous namespace
+
+#ifdef KINECT_2
+
+using namespace MobileRGBD;
+using namespace MobileRGBD::Kinect2;
+
+namespace {
+
+const int NumberOfFrames = 40;			// Frames in each stream
+const int NumberOfEchos = 541;			// Values of each laser scan
+const long long FirstMilliseconds = 1450000000000LL;	// Timestamp of first frame
+const char * Folder = "DrawAllocationTest";				// Synthetic recording
+
+/** @brief Get the timestamp of a frame.
+ */
+long long GetFrameMilliseconds( int Frame )
+{
+	return FirstMilliseconds + Frame*33;
+}
+
+/** @brief Write a timestamp file and a raw file. Pixels of frame f are Fill( f, pixel ).
+ *
+ * @param TimestampFile [in] Timestamp file.
+ * @param RawFile [in] Raw file.
+ * @param Fill [in] Value of pixels.
+ * @return true if files were written.
+ */
+template<typename TypeOfPixel, class Filler>
+bool WriteRawStream( const std::string& TimestampFile, const std::string& RawFile, Filler Fill )
+{
+	FILE * Timestamps = fopen( TimestampFile.c_str(), "wb" );
+	FILE * Raw = fopen( RawFile.c_str(), "wb" );
+	bool Ret = Timestamps != nullptr && Raw != nullptr;
+
+	std::vector<TypeOfPixel> Frame( DepthWidth*DepthHeight );
+	for( int f = 0; Ret && f < NumberOfFrames; f++ )
+	{
+		for( int i = 0; i < DepthWidth*DepthHeight; i++ )
+		{
+			Frame[i] = Fill( f, i );
+		}
+
+		long long Milliseconds = GetFrameMilliseconds( f );
+		fprintf( Timestamps, "%lld %03d\r\n", Milliseconds/1000, (int)(Milliseconds%1000) );
+		Ret = fwrite( &Frame[0], Frame.size()*sizeof(TypeOfPixel), 1, Raw ) == 1;
+	}
+
+	if ( Timestamps != nullptr ) fclose( Timestamps );
+	if ( Raw != nullptr ) fclose( Raw );
+
+	return Ret;
+}
+
+/**
+ * @struct DepthFiller
+ * @brief Depth or infrared values moving with frames.
+ */
+struct DepthFiller
+{
+	unsigned short int operator()( int Frame, int Pixel ) const
+	{
+		return (unsigned short int)((Pixel*7 + Frame*131)%8000);
+	}
+};
+
+/**
+ * @struct BodyIndexFiller
+ * @brief A body moving on the background.
+ */
+struct BodyIndexFiller
+{
+	unsigned char operator()( int Frame, int Pixel ) const
+	{
+		int x = Pixel%DepthWidth;
+		int y = Pixel/DepthWidth;
+		return (x >= 100+Frame*4 && x < 200+Frame*4 && y >= 50 && y < 350) ? (unsigned char)(Frame%6) : (unsigned char)255;
+	}
+};
+
+/** @brief Write the laser timestamp file, all lines with the same layout and length.
+ *
+ * @return true if the file was written.
+ */
+bool WriteLaserStream( const std::string& TimestampFile )
+{
+	FILE * Timestamps = fopen( TimestampFile.c_str(), "wb" );
+	if ( Timestamps == nullptr )
+	{
+		return false;
+	}
+
+	for( int f = 0; f < NumberOfFrames; f++ )
+	{
+		long long Milliseconds = GetFrameMilliseconds( f );
+		fprintf( Timestamps, "%lld %03d {\"FirstAngle\":-2.356, \"LastAngle\":2.356, \"Step\":0.0087, \"NbEchos\":%d, \"LaserMap\":[",
+			Milliseconds/1000, (int)(Milliseconds%1000), NumberOfEchos );
+		for( int i = 0; i < NumberOfEchos; i++ )
+		{
+			fprintf( Timestamps, "%s%.3f", i == 0 ? "" : ",", 1.0 + ((i*13 + f*7)%500)/100.0 );
+		}
+		fprintf( Timestamps, "]}\r\n" );
+	}
+
+	fclose( Timestamps );
+
+	return true;
+}
+
+/** @brief Draw all frames of a stream, counting allocations after the first one.
+ *
+ * @param Name [in] Name of the path.
+ * @param View [in] View to draw with.
+ * @param Width [in] Width of the drawing cv::Mat.
+ * @param Height [in] Height of the drawing cv::Mat.
+ * @return the number of errors.
+ */
+int CheckPath( const char * Name, Drawable& View, int Width, int Height )
+{
+	cv::Mat WhereToDraw( Height, Width, CV_8UC3 );
+
+	// Warm up
+	bool Drawn = View.Draw( WhereToDraw, TimestampIndex::MillisecondsToTimestamp( GetFrameMilliseconds(0) ) );
+
+	NumberOfAllocations = 0;
+	NumberOfMatAllocations = 0;
+	CountAllocations = true;
+	for( int f = 1; f < NumberOfFrames; f++ )
+	{
+		Drawn = View.Draw( WhereToDraw, TimestampIndex::MillisecondsToTimestamp( GetFrameMilliseconds(f) ) ) && Drawn;
+	}
+	CountAllocations = false;
+
+	int Errors = 0;
+	if ( Drawn == false )
+	{
+		fprintf( stderr, "%s %dx%d: frames not drawn\n", Name, Width, Height );
+		Errors++;
+	}
+	if ( NumberOfAllocations != 0 || NumberOfMatAllocations != 0 )
+	{
+		fprintf( stderr, "%s %dx%d: %lld allocations and %lld cv::Mat allocations in %d frames\n", Name, Width, Height,
+			NumberOfAllocations.load(), NumberOfMatAllocations.load(), NumberOfFrames-1 );
+		Errors++;
+	}
+
+	printf( "%s %dx%d: %d frames drawn, %lld allocations, %lld cv::Mat allocations, %d errors\n", Name, Width, Height,
+		NumberOfFrames-1, NumberOfAllocations.load(), NumberOfMatAllocations.load(), Errors );
+
+	return Errors;
+}
+
+} // anonymous namespace
+
+int main()
+{
+	const std::string Root( Folder );
+	MakeFolder( Folder );
+	MakeFolder( (Root + "/depth").c_str() );
+	MakeFolder( (Root + "/infrared").c_str() );
+	MakeFolder( (Root + "/body_index").c_str() );
+	MakeFolder( (Root + "/robulab").c_str() );
+
+	if ( WriteRawStream<unsigned short int>( Root + DepthFileName, Root + RawDepthFileName, DepthFiller() ) == false ||
+		 WriteRawStream<unsigned short int>( Root + InfraredFileName, Root + RawInfraredFileName, DepthFiller() ) == false ||
+		 WriteRawStream<unsigned char>( Root + BodyIndexFileName, Root + RawBodyIndexFileName, BodyIndexFiller() ) == false ||
+		 WriteLaserStream( Root + TelemeterFileName ) == false )
+	{
+		fprintf( stderr, "Unable to write test recording\n" );
+		return 1;
+	}
+
+	// Count cv::Mat buffers
+	CountingMatAllocator MatAllocator( cv::Mat::getDefaultAllocator() );
+	cv::Mat::setDefaultAllocator( &MatAllocator );
+
+	int Errors = 0;
+	{
+		DrawDepthView Depth( Root );
+		DrawInfraredView Infrared( Root );
+		DrawBodyIndexView BodyIndex( Root );
+		DrawLaserData Laser( Root );
+
+		// Native size (copy), then resized
+		const int Sizes[2][2] = { { DepthWidth, DepthHeight }, { 640, 480 } };
+		for( int s = 0; s < 2; s++ )
+		{
+			Errors += CheckPath( "Depth", Depth, Sizes[s][0], Sizes[s][1] );
+			Errors += CheckPath( "Infrared", Infrared, Sizes[s][0], Sizes[s][1] );
+			Errors += CheckPath( "BodyIndex", BodyIndex, Sizes[s][0], Sizes[s][1] );
+			Errors += CheckPath( "Laser", Laser, Sizes[s][0], Sizes[s][1] );
+		}
+	}
+
+	cv::Mat::setDefaultAllocator( nullptr );
+
+	remove( (Root + DepthFileName).c_str() );
+	remove( (Root + RawDepthFileName).c_str() );
+	remove( (Root + InfraredFileName).c_str() );
+	remove( (Root + RawInfraredFileName).c_str() );
+	remove( (Root + BodyIndexFileName).c_str() );
+	remove( (Root + RawBodyIndexFileName).c_str() );
+	remove( (Root + TelemeterFileName).c_str() );
+	RemoveFolder( (Root + "/depth").c_str() );
+	RemoveFolder( (Root + "/infrared").c_str() );
+	RemoveFolder( (Root + "/body_index").c_str() );
+	RemoveFolder( (Root + "/robulab").c_str() );
+	RemoveFolder( Folder );
+
+	return Errors == 0 ? 0 : 1;
+}
+
+#else
+
+int main()
+{
+	// Views checked here are Kinect2 views
+	printf( "KINECT_2 not defined, nothing checked\n" );
+	return 0;
+}
+
+#endif // KINECT_2
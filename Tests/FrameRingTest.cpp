@@ -0,0 +1,195 @@
+/**
+ * @file FrameRingTest.cpp
+ * @ingroup Drawing
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ *
+ * Stress test of the lock-free FrameRing handoff: one producer thread, one consumer thread.
+ * Checks that in order reading loses and duplicates no frame, that frame data are never
+ * overwritten while the consumer reads them and that buffers are reused through the free queue.
+ * Build it with ThreadSanitizer, i.e.:
+ *   g++ -std=c++11 -O1 -g -fsanitize=thread Tests/FrameRingTest.cpp FrameRing.cpp -lpthread -o FrameRingTest
+ * Returns 0 on success.
+ */
+
+#include "../FrameRing.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include <atomic>
+#include <vector>
+
+using namespace MobileRGBD;
+
+namespace {
+
+const int FrameSize = 4096;				// Size of test frames
+const int NumberOfFrames = 4;			// Frames in the ring
+const unsigned int FramesToSend = 200000;	// Frames sent by the producer in each mode
+
+/** @brief Fill a frame with its sequence number.
+ */
+void FillFrame( RingFrame * Frame, unsigned int Sequence )
+{
+	unsigned int * Values = (unsigned int*)Frame->Data;
+	for( int i = 0; i < FrameSize/(int)sizeof(unsigned int); i++ )
+	{
+		Values[i] = Sequence;
+	}
+}
+
+/** @brief Check that a frame contains only its sequence number (not overwritten during reading).
+ */
+bool CheckFrame( const RingFrame * Frame, unsigned int& Sequence )
+{
+	const unsigned int * Values = (const unsigned int*)Frame->Data;
+	Sequence = Values[0];
+	for( int i = 1; i < FrameSize/(int)sizeof(unsigned int); i++ )
+	{
+		if ( Values[i] != Sequence )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/** @brief Run a producer and a consumer on a ring.
+ *
+ * @param Mode [in] Reading mode of the consumer.
+ * @return the number of errors.
+ */
+int RunStress( FrameRing::ReadMode Mode )
+{
+	FrameRing Ring( FrameSize, NumberOfFrames );
+
+	unsigned long long ProducerDrops = 0;
+	std::atomic<bool> ProducerDone( false );
+	std::thread Producer( [&Ring, &ProducerDrops, &ProducerDone, Mode]()
+	{
+		for( unsigned int Sequence = 1; Sequence <= FramesToSend; )
+		{
+			RingFrame * Frame = Ring.AcquireForWriting();
+			if ( Frame == nullptr )
+			{
+				if ( Mode == FrameRing::LatestFrameWins )
+				{
+					// Live capture drops its frame when the consumer is late
+					ProducerDrops++;
+					Sequence++;
+				}
+				std::this_thread::yield();
+				continue;
+			}
+			FillFrame( Frame, Sequence );
+			Frame->Timestamp.time = (time_t)Sequence;
+			Ring.Publish( Frame );
+			Sequence++;
+		}
+		ProducerDone.store( true, std::memory_order_release );
+	} );
+
+	int Errors = 0;
+	unsigned int Previous = 0;
+	unsigned long long Received = 0;
+	std::vector<int> SlotUses( NumberOfFrames, 0 );
+	while( Previous < FramesToSend )
+	{
+		RingFrame * Frame = Ring.AcquireForReading( Mode );
+		if ( Frame == nullptr )
+		{
+			if ( ProducerDone.load( std::memory_order_acquire ) == false )
+			{
+				std::this_thread::yield();
+				continue;
+			}
+
+			// Everything is published, last try
+			Frame = Ring.AcquireForReading( Mode );
+			if ( Frame == nullptr )
+			{
+				break;
+			}
+		}
+
+		unsigned int Sequence;
+		if ( CheckFrame( Frame, Sequence ) == false || (unsigned int)Frame->Timestamp.time != Sequence )
+		{
+			fprintf( stderr, "frame %u overwritten while read\n", Sequence );
+			Errors++;
+		}
+		if ( Mode == FrameRing::InOrder ? Sequence != Previous+1 : Sequence <= Previous )
+		{
+			fprintf( stderr, "frame %u received after frame %u\n", Sequence, Previous );
+			Errors++;
+		}
+		if ( Frame->Slot < 0 || Frame->Slot >= NumberOfFrames )
+		{
+			fprintf( stderr, "bad slot %d\n", Frame->Slot );
+			Errors++;
+		}
+		else
+		{
+			SlotUses[Frame->Slot]++;
+		}
+
+		Previous = Sequence;
+		Received++;
+
+		// Simulate some drawing work on the frame
+		volatile unsigned int Sum = 0;
+		for( int i = 0; i < 64; i++ )
+		{
+			Sum += Frame->Data[i];
+		}
+
+		Ring.Release( Frame );
+	}
+
+	Producer.join();
+
+	// Only NumberOfFrames buffers, reused through the free queue
+	for( int s = 0; s < NumberOfFrames; s++ )
+	{
+		if ( Received > (unsigned long long)NumberOfFrames*4 && SlotUses[s] < 2 )
+		{
+			fprintf( stderr, "slot %d not reused (%d uses)\n", s, SlotUses[s] );
+			Errors++;
+		}
+	}
+
+	if ( Mode == FrameRing::InOrder )
+	{
+		if ( Received != FramesToSend )
+		{
+			fprintf( stderr, "%llu frames received, %u sent\n", Received, FramesToSend );
+			Errors++;
+		}
+	}
+	else
+	{
+		// Frames not received were dropped by the producer or skipped by the consumer, all are counted
+		unsigned long long Published = FramesToSend - ProducerDrops;
+		unsigned long long Skipped = Ring.GetNumberOfDroppedFrames() - ProducerDrops;
+		if ( Received + Skipped != Published )
+		{
+			fprintf( stderr, "%llu received + %llu skipped != %llu published\n", Received, Skipped, Published );
+			Errors++;
+		}
+	}
+
+	printf( "%s: %llu frames received, %d errors\n", Mode == FrameRing::InOrder ? "InOrder" : "LatestFrameWins", Received, Errors );
+
+	return Errors;
+}
+
+} // anonymous namespace
+
+int main()
+{
+	int Errors = RunStress( FrameRing::InOrder );
+	Errors += RunStress( FrameRing::LatestFrameWins );
+
+	return Errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,286 @@
+/**
+ * @file TimestampIndex.cpp
+ * @ingroup Drawing
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#include "TimestampIndex.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+using namespace MobileRGBD;
+
+/** @brief constructor. Load a timestamp file.
+ *
+ * @param TimestampFile [in] Timestamp file to index.
+ * @param KeepData [in] Keep data following timestamps in memory (Default = false, timestamps only).
+ */
+TimestampIndex::TimestampIndex( const std::string& TimestampFile, bool KeepData /* = false */ )
+{
+	Load( TimestampFile, KeepData );
+}
+
+/** @brief Load a timestamp file, replacing the current index.
+ *
+ * @param TimestampFile [in] Timestamp file to index.
+ * @param KeepData [in] Keep data following timestamps in memory (Default = false, timestamps only).
+ * @return true if the file was read.
+ */
+bool TimestampIndex::Load( const std::string& TimestampFile, bool KeepData /* = false */ )
+{
+	Milliseconds.clear();
+	Data.clear();
+	Offsets.clear();
+
+	FILE * fin = fopen( TimestampFile.c_str(), "rb" );
+	if ( fin == nullptr )
+	{
+		return false;
+	}
+
+	std::string Line;
+	long long Position = 0;
+	long long LineStart = Position;
+	for( ; ReadLine( fin, Line, Position ); LineStart = Position )
+	{
+		long long EntryMilliseconds;
+		const char * EntryData;
+		if ( ParseLine( Line.c_str(), EntryMilliseconds, EntryData ) )
+		{
+			AddEntry( EntryMilliseconds, EntryData, KeepData );
+			if ( Offsets.size() < Milliseconds.size() )
+			{
+				Offsets.push_back( LineStart );
+			}
+		}
+	}
+
+	fclose( fin );
+
+	return true;
+}
+
+/** @brief Read a line of a timestamp file, without its end of line.
+ *
+ * @param fin [in] Opened timestamp file.
+ * @param Line [out] The line.
+ * @param Position [in,out] Position of fin in the file, moved after the line.
+ * @return false at the end of the file.
+ */
+// static
+bool TimestampIndex::ReadLine( FILE * fin, std::string& Line, long long& Position )
+{
+	Line.clear();
+
+	char Buffer[4096];
+	long long LineSize = 0;
+	while( fgets( Buffer, sizeof(Buffer), fin ) != nullptr )
+	{
+		// Lines may be longer than Buffer (JSON data), concatenate
+		size_t Size = strlen( Buffer );
+		Line.append( Buffer, Size );
+		LineSize += (long long)Size;
+		if ( Line[Line.size()-1] == '\n' )
+		{
+			break;
+		}
+	}
+
+	if ( LineSize == 0 )
+	{
+		return false;
+	}
+	Position += LineSize;
+
+	// Remove end of line
+	while( Line.empty() == false && (Line[Line.size()-1] == '\n' || Line[Line.size()-1] == '\r') )
+	{
+		Line.resize( Line.size()-1 );
+	}
+
+	return true;
+}
+
+/** @brief Parse the timestamp at the beginning of a line of a timestamp file.
+ *
+ * @param Line [in] The line, without its end of line.
+ * @param EntryMilliseconds [out] Timestamp of the line in milliseconds since epoch.
+ * @param EntryData [out] Data following the timestamp, inside Line.
+ * @return false if the line does not start with a timestamp.
+ */
+// static
+bool TimestampIndex::ParseLine( const char * Line, long long& EntryMilliseconds, const char *& EntryData )
+{
+	// Parse timestamp: seconds then milliseconds
+	const char * Start = Line;
+	char * End;
+	long long Seconds = strtoll( Start, &End, 10 );
+	if ( End == Start || (*End != ' ' && *End != '\t' && *End != '.' && *End != ',' && *End != ':') )
+	{
+		return false;
+	}
+
+	Start = End+1;
+	long long Millis = strtoll( Start, &End, 10 );
+	if ( End == Start )
+	{
+		return false;
+	}
+
+	// Skip separator before data
+	while( *End == ' ' || *End == '\t' )
+	{
+		End++;
+	}
+
+	EntryMilliseconds = Seconds*1000 + Millis;
+	EntryData = End;
+
+	return true;
+}
+
+/** @brief Add an entry while loading. Called for each line of the timestamp file, in order.
+ *
+ * @param EntryMilliseconds [in] Timestamp of the entry in milliseconds since epoch.
+ * @param EntryData [in] Data following the timestamp on the line.
+ * @param KeepData [in] Keep data in memory.
+ */
+void TimestampIndex::AddEntry( long long EntryMilliseconds, const char * EntryData, bool KeepData )
+{
+	Milliseconds.push_back( EntryMilliseconds );
+	if ( KeepData )
+	{
+		Data.push_back( std::string(EntryData) );
+	}
+}
+
+/** @brief Search the last entry with a timestamp lower or equal to the requested one.
+ *
+ * @param RequestMilliseconds [in] Searched timestamp in milliseconds since epoch.
+ * @return the index of the entry, -1 if all entries are after the requested timestamp.
+ */
+int TimestampIndex::SearchPrevious( long long RequestMilliseconds ) const
+{
+	std::vector<long long>::const_iterator It = std::upper_bound( Milliseconds.begin(), Milliseconds.end(), RequestMilliseconds );
+
+	return (int)(It - Milliseconds.begin()) - 1;
+}
+
+/** @brief Search the entry with the nearest timestamp.
+ *
+ * @param RequestMilliseconds [in] Searched timestamp in milliseconds since epoch.
+ * @return the index of the entry, -1 if the index is empty.
+ */
+int TimestampIndex::SearchNearest( long long RequestMilliseconds ) const
+{
+	return NearestFromPrevious( SearchPrevious( RequestMilliseconds ), RequestMilliseconds );
+}
+
+/** @brief Choose the nearest entry between an entry and the next one.
+ *
+ * @param Previous [in] Last entry with a timestamp lower or equal to the requested one (see SearchPrevious).
+ * @param RequestMilliseconds [in] Searched timestamp in milliseconds since epoch.
+ * @return the index of the entry, -1 if the index is empty.
+ */
+int TimestampIndex::NearestFromPrevious( int Previous, long long RequestMilliseconds ) const
+{
+	if ( Milliseconds.empty() )
+	{
+		return -1;
+	}
+
+	if ( Previous < 0 )
+	{
+		return 0;
+	}
+	if ( Previous == (int)Milliseconds.size()-1 )
+	{
+		return Previous;
+	}
+
+	// Choose between Previous and next one
+	if ( RequestMilliseconds - Milliseconds[Previous] <= Milliseconds[Previous+1] - RequestMilliseconds )
+	{
+		return Previous;
+	}
+
+	return Previous+1;
+}
+
+/** @brief Search the last entry with a timestamp lower or equal to the requested one.
+ *
+ * @param RequestMilliseconds [in] Searched timestamp in milliseconds since epoch.
+ * @return the index of the entry, -1 if all entries are after the requested timestamp.
+ */
+int TimestampCursor::SearchPrevious( long long RequestMilliseconds )
+{
+	const int NumberOfEntries = Index.GetNumberOfEntries();
+	if ( Position >= NumberOfEntries )
+	{
+		// Index was reloaded
+		Position = -1;
+	}
+
+	int Walked = 0;
+	if ( Position < 0 || Index.GetMilliseconds(Position) <= RequestMilliseconds )
+	{
+		// Walk forward: answer is in [Position, NumberOfEntries)
+		while( Position+1 < NumberOfEntries && Index.GetMilliseconds(Position+1) <= RequestMilliseconds )
+		{
+			if ( ++Walked > MaxWalk )
+			{
+				// Far jump, binary search after the current position
+				int Low = Position+1;
+				int High = NumberOfEntries;
+				while( Low < High )
+				{
+					int Middle = Low + (High-Low)/2;
+					if ( Index.GetMilliseconds(Middle) <= RequestMilliseconds )
+					{
+						Low = Middle+1;
+					}
+					else
+					{
+						High = Middle;
+					}
+				}
+				Position = Low-1;
+				return Position;
+			}
+			Position++;
+		}
+		return Position;
+	}
+
+	// Walk backward: answer is in [-1, Position)
+	while( Position >= 0 && Index.GetMilliseconds(Position) > RequestMilliseconds )
+	{
+		if ( ++Walked > MaxWalk )
+		{
+			// Far jump, binary search before the current position
+			int Low = 0;
+			int High = Position;
+			while( Low < High )
+			{
+				int Middle = Low + (High-Low)/2;
+				if ( Index.GetMilliseconds(Middle) <= RequestMilliseconds )
+				{
+					Low = Middle+1;
+				}
+				else
+				{
+					High = Middle;
+				}
+			}
+			Position = Low-1;
+			return Position;
+		}
+		Position--;
+	}
+
+	return Position;
+}
@@ -0,0 +1,262 @@
+/**
+ * @file TimestampIndex.h
+ * @ingroup Drawing
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ * @copyright All right reserved.
+ */
+
+#ifndef __TIMESTAMP_INDEX_H__
+#define __TIMESTAMP_INDEX_H__
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "../DataManagement/TimestampTools.h"
+
+namespace MobileRGBD {
+
+/**
+ * @class TimestampIndex TimestampIndex.cpp TimestampIndex.h
+ * @brief In memory index of a timestamp file, loaded in one pass. Each line of a timestamp file
+ *        starts with the timestamp (seconds and milliseconds) followed by the data of the line (JSON
+ *        data or raw file information). Line i of the file is entry i of the index.
+ *        Used to enumerate or search frames of a stream without reading their data.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class TimestampIndex
+{
+public:
+	/** @brief constructor. Empty index.
+	 */
+	TimestampIndex() {}
+
+	/** @brief constructor. Load a timestamp file.
+	 *
+	 * @param TimestampFile [in] Timestamp file to index.
+	 * @param KeepData [in] Keep data following timestamps in memory (Default = false, timestamps only).
+	 */
+	TimestampIndex( const std::string& TimestampFile, bool KeepData = false );
+
+	/** @brief Virtual destructor, always.
+	 */
+	virtual ~TimestampIndex() {}
+
+	/** @brief Load a timestamp file, replacing the current index.
+	 *
+	 * @param TimestampFile [in] Timestamp file to index.
+	 * @param KeepData [in] Keep data following timestamps in memory (Default = false, timestamps only).
+	 * @return true if the file was read.
+	 */
+	bool Load( const std::string& TimestampFile, bool KeepData = false );
+
+	/** @brief Get the number of entries (lines) in the index.
+	 */
+	int GetNumberOfEntries() const
+	{
+		return (int)Milliseconds.size();
+	}
+
+	/** @brief Get the timestamp of an entry in milliseconds since epoch.
+	 *
+	 * @param Entry [in] Index of the entry.
+	 */
+	long long GetMilliseconds( int Entry ) const
+	{
+		return Milliseconds[Entry];
+	}
+
+	/** @brief Get the timestamp of an entry.
+	 *
+	 * @param Entry [in] Index of the entry.
+	 */
+	TimeB GetTimestamp( int Entry ) const
+	{
+		return MillisecondsToTimestamp( Milliseconds[Entry] );
+	}
+
+	/** @brief Get the data following the timestamp on the line of an entry. Only available
+	 *         if the index was loaded with KeepData.
+	 *
+	 * @param Entry [in] Index of the entry.
+	 */
+	const std::string& GetData( int Entry ) const
+	{
+		return Data[Entry];
+	}
+
+	/** @brief Get the position of the line of an entry in the timestamp file. Only available
+	 *         if the index was loaded from the timestamp file (see Load).
+	 *
+	 * @param Entry [in] Index of the entry.
+	 * @return the position, -1 if not available.
+	 */
+	long long GetOffset( int Entry ) const
+	{
+		if ( Entry < 0 || Entry >= (int)Offsets.size() )
+		{
+			return -1;
+		}
+		return Offsets[Entry];
+	}
+
+	/** @brief Search the entry with the nearest timestamp.
+	 *
+	 * @param RequestTimestamp [in] Searched timestamp.
+	 * @return the index of the entry, -1 if the index is empty.
+	 */
+	int SearchNearest( const TimeB& RequestTimestamp ) const
+	{
+		return SearchNearest( TimestampToMilliseconds(RequestTimestamp) );
+	}
+
+	/** @brief Search the entry with the nearest timestamp.
+	 *
+	 * @param RequestMilliseconds [in] Searched timestamp in milliseconds since epoch.
+	 * @return the index of the entry, -1 if the index is empty.
+	 */
+	int SearchNearest( long long RequestMilliseconds ) const;
+
+	/** @brief Search the last entry with a timestamp lower or equal to the requested one.
+	 *
+	 * @param RequestMilliseconds [in] Searched timestamp in milliseconds since epoch.
+	 * @return the index of the entry, -1 if all entries are after the requested timestamp.
+	 */
+	int SearchPrevious( long long RequestMilliseconds ) const;
+
+	/** @brief Choose the nearest entry between an entry and the next one.
+	 *
+	 * @param Previous [in] Last entry with a timestamp lower or equal to the requested one (see SearchPrevious).
+	 * @param RequestMilliseconds [in] Searched timestamp in milliseconds since epoch.
+	 * @return the index of the entry, -1 if the index is empty.
+	 */
+	int NearestFromPrevious( int Previous, long long RequestMilliseconds ) const;
+
+	/** @brief Convert a timestamp to milliseconds since epoch.
+	 */
+	static long long TimestampToMilliseconds( const TimeB& Timestamp )
+	{
+		return (long long)Timestamp.time*1000 + (long long)Timestamp.millitm;
+	}
+
+	/** @brief Convert milliseconds since epoch to a timestamp.
+	 */
+	static TimeB MillisecondsToTimestamp( long long Value )
+	{
+		TimeB Timestamp = TimeB();
+		Timestamp.time = (time_t)(Value/1000);
+		Timestamp.millitm = (unsigned short)(Value%1000);
+		return Timestamp;
+	}
+
+	/** @brief Read a line of a timestamp file, without its end of line.
+	 *
+	 * @param fin [in] Opened timestamp file.
+	 * @param Line [out] The line.
+	 * @param Position [in,out] Position of fin in the file, moved after the line.
+	 * @return false at the end of the file.
+	 */
+	static bool ReadLine( FILE * fin, std::string& Line, long long& Position );
+
+	/** @brief Parse the timestamp at the beginning of a line of a timestamp file.
+	 *
+	 * @param Line [in] The line, without its end of line.
+	 * @param EntryMilliseconds [out] Timestamp of the line in milliseconds since epoch.
+	 * @param EntryData [out] Data following the timestamp, inside Line.
+	 * @return false if the line does not start with a timestamp.
+	 */
+	static bool ParseLine( const char * Line, long long& EntryMilliseconds, const char *& EntryData );
+
+protected:
+	/** @brief Add an entry while loading. Called for each line of the timestamp file, in order.
+	 *
+	 * @param EntryMilliseconds [in] Timestamp of the entry in milliseconds since epoch.
+	 * @param EntryData [in] Data following the timestamp on the line.
+	 * @param KeepData [in] Keep data in memory.
+	 */
+	virtual void AddEntry( long long EntryMilliseconds, const char * EntryData, bool KeepData );
+
+	std::vector<long long> Milliseconds;		/*!< @brief Timestamp of each entry, in milliseconds since epoch */
+	std::vector<std::string> Data;				/*!< @brief Data following the timestamp for each entry (if kept) */
+	std::vector<long long> Offsets;				/*!< @brief Position of the line of each entry in the timestamp file */
+};
+
+/**
+ * @class TimestampCursor TimestampIndex.cpp TimestampIndex.h
+ * @brief Search in a TimestampIndex from the last found entry. During playback, requests are
+ *        sequential or almost sequential: the cursor walks forward or backward from its position,
+ *        in amortized constant time. If the requested entry is farther than a few entries, a binary
+ *        search is done on the remaining part of the index. One cursor per reader, the index may be shared.
+ *
+ * @author Dominique Vaufreydaz, Grenoble Alpes University, Inria
+ */
+class TimestampCursor
+{
+public:
+	/** @brief constructor.
+	 *
+	 * @param _Index [in] Index to search in. Must live longer than the cursor.
+	 * @param _MaxWalk [in] Maximum number of entries walked before a binary search (Default = 8).
+	 */
+	TimestampCursor( const TimestampIndex& _Index, int _MaxWalk = 8 )
+		: Index( _Index )
+	{
+		MaxWalk = _MaxWalk < 1 ? 1 : _MaxWalk;
+		Position = -1;
+	}
+
+	/** @brief Virtual destructor, always.
+	 */
+	virtual ~TimestampCursor() {}
+
+	/** @brief Forget the last position (next search will be a full search).
+	 */
+	void Reset()
+	{
+		Position = -1;
+	}
+
+	/** @brief Get the last found entry (last entry lower or equal to the last requested timestamp), -1 if none.
+	 */
+	int GetPosition() const
+	{
+		return Position;
+	}
+
+	/** @brief Search the last entry with a timestamp lower or equal to the requested one.
+	 *
+	 * @param RequestMilliseconds [in] Searched timestamp in milliseconds since epoch.
+	 * @return the index of the entry, -1 if all entries are after the requested timestamp.
+	 */
+	int SearchPrevious( long long RequestMilliseconds );
+
+	/** @brief Search the entry with the nearest timestamp.
+	 *
+	 * @param RequestMilliseconds [in] Searched timestamp in milliseconds since epoch.
+	 * @return the index of the entry, -1 if the index is empty.
+	 */
+	int SearchNearest( long long RequestMilliseconds )
+	{
+		return Index.NearestFromPrevious( SearchPrevious( RequestMilliseconds ), RequestMilliseconds );
+	}
+
+	/** @brief Search the entry with the nearest timestamp.
+	 *
+	 * @param RequestTimestamp [in] Searched timestamp.
+	 * @return the index of the entry, -1 if the index is empty.
+	 */
+	int SearchNearest( const TimeB& RequestTimestamp )
+	{
+		return SearchNearest( TimestampIndex::TimestampToMilliseconds(RequestTimestamp) );
+	}
+
+protected:
+	const TimestampIndex& Index;	/*!< @brief Index to search in */
+	int MaxWalk;					/*!< @brief Maximum number of entries walked before a binary search */
+	int Position;					/*!< @brief Last found entry, -1 if none */
+};
+
+} // namespace MobileRGBD
+
+#endif // __TIMESTAMP_INDEX_H__